@@ -7,6 +7,9 @@ local console = require("console")
 
 runner.script(td .. "atl06_elements.lua")
 runner.script(td .. "atl06_unittest.lua")
+runner.script(td .. "atl03_unittest.lua")
+runner.script(td .. "atl03_split.lua")
+runner.script(td .. "atl03_prefetch.lua")
 runner.script(td .. "atl03_indexer.lua")
 
 -- Report Results --
@@ -14,7 +14,7 @@
 --
 --              rspq - output queue to stream results
 --
--- OUTPUT:      atl03rec
+-- OUTPUT:      atl03rec (or atl03rec.batch when the "batch" parameter is greater than 1)
 --
 -- NOTES:       1. The rqst is provided by arg[1] which is a json object provided by caller
 --              2. The rspq is the system provided output queue name string
@@ -31,9 +31,13 @@ local rqst = json.decode(arg[1])
 local atl03_asset = rqst["atl03-asset"] or "atlas-s3"
 local resource = rqst["resource"]
 local track = rqst["track"] or icesat2.ALL_TRACKS
-local parms = rqst["parms"]
+local parms = rqst["parms"] or {}
 local timeout = rqst["timeout"] or core.PEND
 
+-- Extents Are Not Fit (only read what is returned) --
+parms["stages"] = {}
+parms["consumer"] = icesat2.CONSUMER_ATL03
+
 -- Get Asset --
 asset = core.getbyname(atl03_asset)
 if not asset then
@@ -66,5 +70,6 @@ while not atl03_reader:waiton(interval) do
 end
 
 -- Processing Complete
-userlog:sendlog(core.INFO, string.format("processing of %s complete", resource))
+local atl03_stats = atl03_reader:stats(false)
+userlog:sendlog(core.INFO, string.format("processing of %s complete (avoided reading %d bytes)", resource, atl03_stats.avoided))
 return
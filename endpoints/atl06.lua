@@ -10,6 +10,7 @@
 --                  "track":        <track number: 1, 2, 3>
 --                  "parms":        {<table of parameters>}
 --                  "timeout":      <milliseconds to wait for first response>
+--                  "fused":        <true to fit extents inside the reader threads (no dispatcher)>
 --              }
 --
 --              rspq - output queue to stream results
@@ -31,8 +32,9 @@ local rqst = json.decode(arg[1])
 local atl03_asset = rqst["atl03-asset"] or "atlas-s3"
 local resource = rqst["resource"]
 local track = rqst["track"] or icesat2.ALL_TRACKS
-local parms = rqst["parms"]
+local parms = rqst["parms"] or {}
 local timeout = rqst["timeout"] or core.PEND
+local fused = rqst["fused"] or false
 
 -- Get Asset --
 asset = core.getbyname(atl03_asset)
@@ -44,6 +46,9 @@ end
 -- Check Stages --
 local recq = rspq .. "-atl03"
 
+-- Batch Extents Sent to Dispatcher --
+parms["batch"] = parms["batch"] or 256
+
 -- Post Initial Status Progress --
 userlog:sendlog(core.INFO, string.format("atl06 processing initiated on %s ...", resource))
 
@@ -51,20 +56,29 @@ userlog:sendlog(core.INFO, string.format("atl06 processing initiated on %s ...",
 atl06_algo = icesat2.atl06(rspq, parms)
 atl06_algo:name("atl06_algo")
 
--- ATL06 Dispatcher --
-atl06_disp = core.dispatcher(recq)
-atl06_disp:name("atl06_disp")
-atl06_disp:attach(atl06_algo, "atl03rec")
-atl06_disp:run()
-
--- ATL03 Reader --
-atl03_reader = icesat2.atl03(asset, resource, recq, parms, track)
-atl03_reader:name("atl03_reader")
+-- ATL06 Dispatcher and ATL03 Reader --
+local waiter = nil
+if fused then
+    -- Fit Extents in Reader Threads --
+    atl03_reader = icesat2.atl03(asset, resource, recq, parms, track, atl06_algo)
+    atl03_reader:name("atl03_reader")
+    waiter = atl03_reader
+else
+    -- Dispatch Extents to ATL06 Algorithm --
+    atl06_disp = core.dispatcher(recq)
+    atl06_disp:name("atl06_disp")
+    atl06_disp:attach(atl06_algo, "atl03rec")
+    atl06_disp:attach(atl06_algo, "atl03rec.batch")
+    atl06_disp:run()
+    atl03_reader = icesat2.atl03(asset, resource, recq, parms, track)
+    atl03_reader:name("atl03_reader")
+    waiter = atl06_disp
+end
 
 -- Wait Until Completion --
 local duration = 0
 local interval = 10000 -- 10 seconds
-while not atl06_disp:waiton(interval) do
+while not waiter:waiton(interval) do
     duration = duration + interval
     -- Check for Timeout --
     if timeout > 0 and duration == timeout then
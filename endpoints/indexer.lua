@@ -6,11 +6,12 @@
 --                  "atl03-asset":  "<name of asset to use, defaults to atlas-local>"
 --                  "resources":    ["<name of hdf5 file or object>", ...]
 --                  "timeout":      <milliseconds to wait for first response>
+--                  "sidecar":      <true to also build spatial sidecars used to subset polygons>
 --              }
 --
 --              rspq - output queue to stream results
 --
--- OUTPUT:      Index records (atl03rec.index)
+-- OUTPUT:      Index records (atl03rec.index), and optionally sidecar records (atl03rec.sidecar)
 --
 -- NOTES:       1. The rqst is provided by arg[1] which is a json object provided by caller
 --              2. The rspq is the system provided output queue name string
@@ -28,6 +29,7 @@ local rqst = json.decode(arg[1])
 local atl03_asset = rqst["atl03-asset"] or "atlas-local"
 local resources = rqst["resources"]
 local timeout = rqst["timeout"] or core.PEND
+local sidecar = rqst["sidecar"] or false
 
 -- Post Initial Status Progress --
 userlog:sendlog(core.INFO, string.format("atl03 indexing initiated on %s data...", atl03_asset))
@@ -35,7 +37,7 @@ userlog:sendlog(core.INFO, string.format("atl03 indexing initiated on %s data...
 -- Index Asset --  
 local atl03 = core.getbyname(atl03_asset)
 local name, format, url, index_filename, region, endpoint, status = atl03:info()
-local indexer = icesat2.atl03indexer(atl03, resources, rspq)
+local indexer = icesat2.atl03indexer(atl03, resources, rspq, nil, sidecar)
 
 -- Wait Until Completion --
 local duration = 0
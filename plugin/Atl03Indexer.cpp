@@ -33,6 +33,8 @@
  * INCLUDES
  ******************************************************************************/
 
+#include <float.h>
+
 #include "core.h"
 #include "icesat2.h"
 
@@ -52,6 +54,34 @@ const RecordObject::fieldDef_t Atl03Indexer::recDef[] = {
     {"cycle",   RecordObject::UINT32,   offsetof(index_t, cycle),   1,                              NULL, NATIVE_FLAGS},
     {"rgt",     RecordObject::UINT32,   offsetof(index_t, rgt),     1,                              NULL, NATIVE_FLAGS},
 };
+
+const char* Atl03Indexer::sidecarRecType = "atl03rec.sidecar";
+const RecordObject::fieldDef_t Atl03Indexer::sidecarRecDef[] = {
+    {"name",        RecordObject::STRING,   offsetof(sidecar_t, name),          Asset::RESOURCE_NAME_LENGTH,    NULL, NATIVE_FLAGS},
+    {"track",       RecordObject::UINT8,    offsetof(sidecar_t, track),         1,                              NULL, NATIVE_FLAGS},
+    {"pair",        RecordObject::UINT8,    offsetof(sidecar_t, pair),          1,                              NULL, NATIVE_FLAGS},
+    {"num_blocks",  RecordObject::UINT32,   offsetof(sidecar_t, num_blocks),    1,                              NULL, NATIVE_FLAGS},
+    {"segments",    RecordObject::UINT32,   offsetof(sidecar_t, num_segments),  1,                              NULL, NATIVE_FLAGS},
+    {"photons",     RecordObject::UINT64,   offsetof(sidecar_t, num_photons),   1,                              NULL, NATIVE_FLAGS},
+    {"first_lat",   RecordObject::DOUBLE,   offsetof(sidecar_t, first_lat),     1,                              NULL, NATIVE_FLAGS},
+    {"blocks",      RecordObject::USER,     offsetof(sidecar_t, blocks),        0,                              blockRecType, NATIVE_FLAGS} // variable length
+};
+
+const char* Atl03Indexer::blockRecType = "atl03rec.sidecar.block";
+const RecordObject::fieldDef_t Atl03Indexer::blockRecDef[] = {
+    {"segment",     RecordObject::UINT32,   offsetof(sidecar_block_t, first_segment),   1,                  NULL, NATIVE_FLAGS},
+    {"segments",    RecordObject::UINT32,   offsetof(sidecar_block_t, num_segments),    1,                  NULL, NATIVE_FLAGS},
+    {"photon",      RecordObject::UINT64,   offsetof(sidecar_block_t, first_photon),    1,                  NULL, NATIVE_FLAGS},
+    {"photons",     RecordObject::UINT32,   offsetof(sidecar_block_t, num_photons),     1,                  NULL, NATIVE_FLAGS},
+    {"min_x",       RecordObject::DOUBLE,   offsetof(sidecar_block_t, min_x),           NUM_PROJECTIONS,    NULL, NATIVE_FLAGS},
+    {"min_y",       RecordObject::DOUBLE,   offsetof(sidecar_block_t, min_y),           NUM_PROJECTIONS,    NULL, NATIVE_FLAGS},
+    {"max_x",       RecordObject::DOUBLE,   offsetof(sidecar_block_t, max_x),           NUM_PROJECTIONS,    NULL, NATIVE_FLAGS},
+    {"max_y",       RecordObject::DOUBLE,   offsetof(sidecar_block_t, max_y),           NUM_PROJECTIONS,    NULL, NATIVE_FLAGS}
+};
+
+Mutex Atl03Indexer::sidecarMut;
+Dictionary<Atl03Indexer::registration_t*> Atl03Indexer::sidecars;
+uint64_t Atl03Indexer::sidecarSequence = 0;
 const char* Atl03Indexer::OBJECT_TYPE = "Atl03Indexer";
 const char* Atl03Indexer::LuaMetaName = "Atl03Indexer";
 const struct luaL_Reg Atl03Indexer::LuaMetaTable[] = {
@@ -64,7 +94,10 @@ const struct luaL_Reg Atl03Indexer::LuaMetaTable[] = {
  ******************************************************************************/
 
 /*----------------------------------------------------------------------------
- * luaCreate - create(<asset>, <resource table>, <outq_name>, [<num threads>])
+ * luaCreate - create(<asset>, <resource table>, <outq_name>, [<num threads>], [<sidecar>])
+ *
+ *  when <sidecar> is true, a spatial sidecar of each pair track is posted and
+ *  registered so that readers in this process can subset polygons with it
  *----------------------------------------------------------------------------*/
 int Atl03Indexer::luaCreate (lua_State* L)
 {
@@ -77,6 +110,7 @@ int Atl03Indexer::luaCreate (lua_State* L)
         int         tblindex    = 2;
         const char* outq_name   = getLuaString(L, 3);
         int         num_threads = getLuaInteger(L, 4, true, DEFAULT_NUM_THREADS);
+        bool        _sidecar    = getLuaBoolean(L, 5, true, false);
 
         /* Build Resource Table */
         _resources = new List<const char*>();
@@ -97,7 +131,7 @@ int Atl03Indexer::luaCreate (lua_State* L)
         }
 
         /* Return Indexer Object */
-        return createLuaObject(L, new Atl03Indexer(L, _asset, _resources, outq_name, num_threads));
+        return createLuaObject(L, new Atl03Indexer(L, _asset, _resources, outq_name, num_threads, _sidecar));
     }
     catch(const RunTimeException& e)
     {
@@ -121,6 +155,53 @@ void Atl03Indexer::init (void)
     {
         mlog(CRITICAL, "Failed to define %s: %d", recType, rc);
     }
+
+    RecordObject::recordDefErr_t block_rc = RecordObject::defineRecord(blockRecType, NULL, sizeof(sidecar_block_t), blockRecDef, sizeof(blockRecDef) / sizeof(RecordObject::fieldDef_t), 16);
+    if(block_rc != RecordObject::SUCCESS_DEF)
+    {
+        mlog(CRITICAL, "Failed to define %s: %d", blockRecType, block_rc);
+    }
+
+    RecordObject::recordDefErr_t sidecar_rc = RecordObject::defineRecord(sidecarRecType, NULL, sizeof(sidecar_t), sidecarRecDef, sizeof(sidecarRecDef) / sizeof(RecordObject::fieldDef_t), 16);
+    if(sidecar_rc != RecordObject::SUCCESS_DEF)
+    {
+        mlog(CRITICAL, "Failed to define %s: %d", sidecarRecType, sidecar_rc);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * getSidecar
+ *
+ *  returns a copy of the registered spatial sidecar of the pair track, or NULL
+ *  if the resource has not been indexed with sidecars (or its sidecar has
+ *  been evicted); free with freeSidecar
+ *----------------------------------------------------------------------------*/
+Atl03Indexer::sidecar_t* Atl03Indexer::getSidecar (const Asset* asset, const char* resource, int track, int pair)
+{
+    sidecar_t* sidecar = NULL;
+    SafeString key("%s/%s/gt%d%c", asset->getName(), resource, track, pair == PRT_LEFT ? 'l' : 'r');
+
+    sidecarMut.lock();
+    {
+        registration_t* registration = NULL;
+        if(sidecars.find(key.getString(), &registration))
+        {
+            sidecar = (sidecar_t*)new unsigned char [registration->size];
+            LocalLib::copy(sidecar, registration->sidecar, registration->size);
+            registration->used = ++sidecarSequence;
+        }
+    }
+    sidecarMut.unlock();
+
+    return sidecar;
+}
+
+/*----------------------------------------------------------------------------
+ * freeSidecar
+ *----------------------------------------------------------------------------*/
+void Atl03Indexer::freeSidecar (sidecar_t* sidecar)
+{
+    delete [] (unsigned char*)sidecar;
 }
 
 /*----------------------------------------------------------------------------
@@ -129,7 +210,7 @@ void Atl03Indexer::init (void)
  *  Note:   object takes ownership of _resources list as well as pointers to urls
  *          (const char*) inside the list; responsible for freeing both
  *----------------------------------------------------------------------------*/
-Atl03Indexer::Atl03Indexer (lua_State* L, Asset* _asset, List<const char*>* _resources, const char* outq_name, int num_threads):
+Atl03Indexer::Atl03Indexer (lua_State* L, Asset* _asset, List<const char*>* _resources, const char* outq_name, int num_threads, bool _sidecar):
     LuaObject(L, OBJECT_TYPE, LuaMetaName, LuaMetaTable)
 {
     assert(outq_name);
@@ -145,6 +226,9 @@ Atl03Indexer::Atl03Indexer (lua_State* L, Asset* _asset, List<const char*>* _res
     /* Save Off Asset */
     asset = _asset;
 
+    /* Set Sidecar Option */
+    sidecar = _sidecar;
+
     /* Create Publisher */
     outQ = new Publisher(outq_name);
 
@@ -250,6 +334,18 @@ void* Atl03Indexer::indexerThread (void* parm)
                 H5Array<double>     gt1l_lat            (indexer->asset, resource_name, "/gt1l/geolocation/reference_photon_lat", context);
                 H5Array<double>     gt1l_lon            (indexer->asset, resource_name, "/gt1l/geolocation/reference_photon_lon", context);
 
+                /* Build Spatial Sidecars */
+                if(indexer->sidecar)
+                {
+                    for(int track = 1; track <= NUM_TRACKS; track++)
+                    {
+                        for(int pair = 0; pair < PAIR_TRACKS_PER_GROUND_TRACK; pair++)
+                        {
+                            indexer->indexSidecar(resource_name, track, pair, context);
+                        }
+                    }
+                }
+
                 /* Clean Up Context */
                 delete context;
                 context = NULL;
@@ -310,6 +406,159 @@ void* Atl03Indexer::indexerThread (void* parm)
     return NULL;
 }
 
+/*----------------------------------------------------------------------------
+ * indexSidecar
+ *
+ *  summarizes the segments of a pair track in blocks of consecutive segments:
+ *  the bounding box of the segment coordinates in each projection and the
+ *  photon offset of the block; a reader needs only to read the geolocation
+ *  of the blocks whose bounding box overlaps its polygon
+ *----------------------------------------------------------------------------*/
+void Atl03Indexer::indexSidecar (const char* resource_name, int track, int pair, H5Api::context_t* context)
+{
+    char side = (pair == PRT_LEFT) ? 'l' : 'r';
+
+    try
+    {
+        /* Read Geolocation of Every Segment */
+        H5Array<double>     segment_lat     (asset, resource_name, SafeString("/gt%d%c/geolocation/reference_photon_lat", track, side).getString(), context);
+        H5Array<double>     segment_lon     (asset, resource_name, SafeString("/gt%d%c/geolocation/reference_photon_lon", track, side).getString(), context);
+        H5Array<int32_t>    segment_ph_cnt  (asset, resource_name, SafeString("/gt%d%c/geolocation/segment_ph_cnt", track, side).getString(), context);
+
+        /* Allocate Record */
+        int num_blocks = (segment_ph_cnt.size + SIDECAR_BLOCK_SEGMENTS - 1) / SIDECAR_BLOCK_SEGMENTS;
+        int size = sizeof(sidecar_t) + (num_blocks * sizeof(sidecar_block_t));
+        RecordObject record(sidecarRecType, size);
+        sidecar_t* sidecar_data = (sidecar_t*)record.getRecordData();
+
+        /* Populate Pair Track */
+        StringLib::copy(sidecar_data->name, resource_name, Asset::RESOURCE_NAME_LENGTH);
+        sidecar_data->track = track;
+        sidecar_data->pair = pair;
+        sidecar_data->num_blocks = num_blocks;
+        sidecar_data->num_segments = segment_ph_cnt.size;
+        sidecar_data->first_lat = (segment_lat.size > 0) ? segment_lat[0] : 0.0;
+
+        /* Summarize Blocks of Segments */
+        uint64_t num_photons = 0;
+        for(int b = 0; b < num_blocks; b++)
+        {
+            sidecar_block_t* block = &sidecar_data->blocks[b];
+            block->first_segment = b * SIDECAR_BLOCK_SEGMENTS;
+            block->num_segments = MIN(SIDECAR_BLOCK_SEGMENTS, segment_ph_cnt.size - block->first_segment);
+            block->first_photon = num_photons;
+            block->num_photons = 0;
+            for(int p = 0; p < NUM_PROJECTIONS; p++)
+            {
+                block->min_x[p] = DBL_MAX;
+                block->min_y[p] = DBL_MAX;
+                block->max_x[p] = -DBL_MAX;
+                block->max_y[p] = -DBL_MAX;
+            }
+
+            for(long segment = block->first_segment; segment < block->first_segment + block->num_segments; segment++)
+            {
+                block->num_photons += segment_ph_cnt[segment];
+
+                /* Grow Bounding Box of Each Projection */
+                MathLib::coord_t coord = {segment_lat[segment], segment_lon[segment]};
+                for(int p = 0; p < NUM_PROJECTIONS; p++)
+                {
+                    MathLib::point_t point = MathLib::coord2point(coord, (MathLib::proj_t)p);
+                    block->min_x[p] = MIN(block->min_x[p], point.x);
+                    block->min_y[p] = MIN(block->min_y[p], point.y);
+                    block->max_x[p] = MAX(block->max_x[p], point.x);
+                    block->max_y[p] = MAX(block->max_y[p], point.y);
+                }
+            }
+
+            num_photons += block->num_photons;
+        }
+        sidecar_data->num_photons = num_photons;
+
+        /* Post Sidecar Record */
+        uint8_t* rec_buf = NULL;
+        int rec_bytes = record.serialize(&rec_buf, RecordObject::REFERENCE);
+        int post_status = MsgQ::STATE_ERROR;
+        while(active && (post_status = outQ->postCopy(rec_buf, rec_bytes, SYS_TIMEOUT)) <= 0)
+        {
+            mlog(DEBUG, "Atl03 indexer failed to post sidecar to stream %s: %d", outQ->getName(), post_status);
+        }
+
+        /* Register Sidecar */
+        SafeString key("%s/%s/gt%d%c", asset->getName(), resource_name, track, side);
+        registerSidecar(key.getString(), sidecar_data, size);
+    }
+    catch(const RunTimeException& e)
+    {
+        /* Skip Pair Track (e.g. beam not present in granule) */
+        mlog(e.level(), "Unable to build sidecar of %s/gt%d%c: %s", resource_name, track, side, e.what());
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * registerSidecar
+ *
+ *  registers a copy of the sidecar, replacing any previous sidecar of the
+ *  pair track; once MAX_SIDECARS are registered, the least recently used
+ *  sidecar is evicted (readers fall back to scanning its pair track)
+ *----------------------------------------------------------------------------*/
+void Atl03Indexer::registerSidecar (const char* key, sidecar_t* sidecar, int size)
+{
+    registration_t* registration = new registration_t;
+    registration->sidecar = (sidecar_t*)new unsigned char [size];
+    registration->size = size;
+    LocalLib::copy(registration->sidecar, sidecar, size);
+
+    sidecarMut.lock();
+    {
+        /* Remove Previous Sidecar of Pair Track */
+        registration_t* previous = NULL;
+        if(sidecars.find(key, &previous))
+        {
+            sidecars.remove(key);
+            freeSidecar(previous->sidecar);
+            delete previous;
+        }
+
+        /* Evict Least Recently Used Sidecar */
+        if(sidecars.length() >= MAX_SIDECARS)
+        {
+            char* oldest_key = NULL;
+            uint64_t oldest_used = UINT64_MAX;
+            registration_t* entry = NULL;
+            const char* entry_key = sidecars.first(&entry);
+            while(entry_key != NULL)
+            {
+                if(entry->used < oldest_used)
+                {
+                    delete [] oldest_key;
+                    oldest_key = StringLib::duplicate(entry_key);
+                    oldest_used = entry->used;
+                }
+                entry_key = sidecars.next(&entry);
+            }
+
+            if(oldest_key)
+            {
+                registration_t* oldest = NULL;
+                if(sidecars.find(oldest_key, &oldest))
+                {
+                    sidecars.remove(oldest_key);
+                    freeSidecar(oldest->sidecar);
+                    delete oldest;
+                }
+                delete [] oldest_key;
+            }
+        }
+
+        /* Add Sidecar */
+        registration->used = ++sidecarSequence;
+        sidecars.add(key, registration);
+    }
+    sidecarMut.unlock();
+}
+
 /*----------------------------------------------------------------------------
  * freeResources
  *----------------------------------------------------------------------------*/
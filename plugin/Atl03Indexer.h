@@ -40,7 +40,9 @@
 #include "RecordObject.h"
 #include "MsgQ.h"
 #include "Asset.h"
+#include "Dictionary.h"
 #include "OsApi.h"
+#include "H5Api.h"
 
 /******************************************************************************
  * ATL03 READER
@@ -66,6 +68,42 @@ class Atl03Indexer: public LuaObject
             int     rgt;
         } index_t;
 
+        /*--------------------------------------------------------------------
+         * Constants
+         *--------------------------------------------------------------------*/
+
+        static const int NUM_PROJECTIONS = 3; // MathLib::proj_t
+        static const int SIDECAR_BLOCK_SEGMENTS = 1000;
+        static const int MAX_SIDECARS = 1536; // registered pair tracks (six for each of 256 granules)
+
+        /*--------------------------------------------------------------------
+         * Types
+         *--------------------------------------------------------------------*/
+
+        /* Spatial Sidecar Block (summary of consecutive segments) */
+        typedef struct {
+            uint32_t        first_segment;
+            uint32_t        num_segments;
+            uint64_t        first_photon;           // photons in all preceding segments
+            uint32_t        num_photons;
+            double          min_x[NUM_PROJECTIONS]; // bounding box of projected segment coordinates
+            double          min_y[NUM_PROJECTIONS];
+            double          max_x[NUM_PROJECTIONS];
+            double          max_y[NUM_PROJECTIONS];
+        } sidecar_block_t;
+
+        /* Spatial Sidecar of a Pair Track */
+        typedef struct {
+            char            name[Asset::RESOURCE_NAME_LENGTH];
+            uint8_t         track;                  // 1, 2, or 3
+            uint8_t         pair;                   // PRT_LEFT or PRT_RIGHT
+            uint32_t        num_blocks;
+            uint32_t        num_segments;
+            uint64_t        num_photons;
+            double          first_lat;              // latitude of first segment (selects projection)
+            sidecar_block_t blocks[];               // zero length field
+        } sidecar_t;
+
         /*--------------------------------------------------------------------
          * Constants
          *--------------------------------------------------------------------*/
@@ -76,6 +114,12 @@ class Atl03Indexer: public LuaObject
         static const char* recType;
         static const RecordObject::fieldDef_t recDef[];
 
+        static const char* sidecarRecType;
+        static const RecordObject::fieldDef_t sidecarRecDef[];
+
+        static const char* blockRecType;
+        static const RecordObject::fieldDef_t blockRecDef[];
+
         static const char* OBJECT_TYPE;
 
         static const char* LuaMetaName;
@@ -85,11 +129,25 @@ class Atl03Indexer: public LuaObject
          * Methods
          *--------------------------------------------------------------------*/
 
-        static int  luaCreate   (lua_State* L);
-        static void init        (void);
+        static int          luaCreate   (lua_State* L);
+        static void         init        (void);
+
+        static sidecar_t*   getSidecar  (const Asset* asset, const char* resource, int track, int pair);
+        static void         freeSidecar (sidecar_t* sidecar);
 
     private:
 
+        /*--------------------------------------------------------------------
+         * Types
+         *--------------------------------------------------------------------*/
+
+        /* Registered Sidecar */
+        typedef struct {
+            sidecar_t*      sidecar;
+            int             size;                   // bytes
+            uint64_t        used;                   // registry sequence at last registration or lookup
+        } registration_t;
+
         /*--------------------------------------------------------------------
          * Data
          *--------------------------------------------------------------------*/
@@ -105,16 +163,23 @@ class Atl03Indexer: public LuaObject
         int                     resourceEntry;
         Mutex                   resourceMut;
         Asset*                  asset;
+        bool                    sidecar;    // build spatial sidecars
+
+        static Mutex                        sidecarMut;
+        static Dictionary<registration_t*>  sidecars;   // registered by "<asset>/<resource>/gt<track><pair>"
+        static uint64_t                     sidecarSequence;
 
         /*--------------------------------------------------------------------
          * Methods
          *--------------------------------------------------------------------*/
 
-                            Atl03Indexer        (lua_State* L, Asset* _asset, List<const char*>* _resources, const char* outq_name, int num_threads);
+                            Atl03Indexer        (lua_State* L, Asset* _asset, List<const char*>* _resources, const char* outq_name, int num_threads, bool _sidecar);
                             ~Atl03Indexer       (void);
 
         static void*        indexerThread       (void* parm);
         static void         freeResources       (List<const char*>* _resources);
+        void                indexSidecar        (const char* resource_name, int track, int pair, H5Api::context_t* context);
+        static void         registerSidecar     (const char* key, sidecar_t* sidecar, int size);
 
         static int          luaStats            (lua_State* L);
 };
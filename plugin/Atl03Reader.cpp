@@ -46,6 +46,13 @@
 #define LUA_STAT_EXTENTS_SENT           "sent"
 #define LUA_STAT_EXTENTS_DROPPED        "dropped"
 #define LUA_STAT_EXTENTS_RETRIED        "retried"
+#define LUA_STAT_BYTES_AVOIDED          "avoided"
+#define LUA_STAT_WINDOWS_READ           "windows"
+#define LUA_STAT_WINDOWS_WAITED         "waited"
+#define LUA_STAT_POSTS_STALLED          "stalled"
+#define LUA_STAT_POSTS_IDLED            "idled"
+#define LUA_STAT_POSTS_QUEUED           "queued"
+#define LUA_STAT_POSTS_WAITING          "occupancy"
 
 /******************************************************************************
  * STATIC DATA
@@ -74,6 +81,17 @@ const RecordObject::fieldDef_t Atl03Reader::exRecDef[] = {
     {"data",        RecordObject::USER,     sizeof(extent_t),                                   0,  phRecType, NATIVE_FLAGS} // variable length
 };
 
+const char* Atl03Reader::batchRecType = "atl03rec.batch";
+const RecordObject::fieldDef_t Atl03Reader::batchRecDef[] = {
+    {"track",       RecordObject::UINT8,    offsetof(extent_batch_t, reference_pair_track),         1,  NULL, NATIVE_FLAGS},
+    {"sc_orient",   RecordObject::UINT8,    offsetof(extent_batch_t, spacecraft_orientation),       1,  NULL, NATIVE_FLAGS},
+    {"rgt",         RecordObject::UINT16,   offsetof(extent_batch_t, reference_ground_track_start), 1,  NULL, NATIVE_FLAGS},
+    {"cycle",       RecordObject::UINT16,   offsetof(extent_batch_t, cycle_start),                  1,  NULL, NATIVE_FLAGS},
+    {"count",       RecordObject::UINT16,   offsetof(extent_batch_t, extent_count),                 1,  NULL, NATIVE_FLAGS},
+    {"offset",      RecordObject::UINT32,   offsetof(extent_batch_t, extent_offset),                MAX_EXTENTS_PER_BATCH,  NULL, NATIVE_FLAGS},
+    {"data",        RecordObject::USER,     sizeof(extent_batch_t),                                 0,  exRecType, NATIVE_FLAGS} // variable length
+};
+
 const double Atl03Reader::ATL03_SEGMENT_LENGTH = 20.0; // meters
 
 const char* Atl03Reader::OBJECT_TYPE = "Atl03Reader";
@@ -89,7 +107,10 @@ const struct luaL_Reg Atl03Reader::LuaMetaTable[] = {
  ******************************************************************************/
 
 /*----------------------------------------------------------------------------
- * luaCreate - create(<asset>, <resource>, <outq_name>, [<parms>], [<track>])
+ * luaCreate - create(<asset>, <resource>, <outq_name>, [<parms>], [<track>], [<atl06 dispatch>])
+ *
+ *  when an atl06 dispatch is supplied, extents are fit directly in the reader
+ *  threads and only the end of data is posted to <outq_name>
  *----------------------------------------------------------------------------*/
 int Atl03Reader::luaCreate (lua_State* L)
 {
@@ -101,9 +122,18 @@ int Atl03Reader::luaCreate (lua_State* L)
         const char* outq_name = getLuaString(L, 3);
         atl06_parms_t* parms = getLuaAtl06Parms(L, 4);
         int track = getLuaInteger(L, 5, true, ALL_TRACKS);
+        LuaObject* dispatch = getLuaObject(L, 6, DispatchObject::OBJECT_TYPE, true, NULL);
+
+        /* Check Dispatch */
+        Atl06Dispatch* atl06 = dynamic_cast<Atl06Dispatch*>(dispatch);
+        if(dispatch && !atl06)
+        {
+            dispatch->releaseLuaObject();
+            throw RunTimeException(CRITICAL, "dispatch supplied to reader must be an atl06 dispatch");
+        }
 
         /* Return Reader Object */
-        return createLuaObject(L, new Atl03Reader(L, asset, resource, outq_name, parms, track));
+        return createLuaObject(L, new Atl03Reader(L, asset, resource, outq_name, parms, track, atl06));
     }
     catch(const RunTimeException& e)
     {
@@ -128,13 +158,41 @@ void Atl03Reader::init (void)
     {
         mlog(CRITICAL, "Failed to define %s: %d", phRecType, ph_rc);
     }
+
+    RecordObject::recordDefErr_t batch_rc = RecordObject::defineRecord(batchRecType, "track", sizeof(extent_batch_t), batchRecDef, sizeof(batchRecDef) / sizeof(RecordObject::fieldDef_t), 16);
+    if(batch_rc != RecordObject::SUCCESS_DEF)
+    {
+        mlog(CRITICAL, "Failed to define %s: %d", batchRecType, batch_rc);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * getSpot
+ *
+ *  returns the spot of a pair track given the orientation of the spacecraft,
+ *  or zero when the orientation is in transition (unknown)
+ *----------------------------------------------------------------------------*/
+int Atl03Reader::getSpot (sc_orient_t sc_orient, track_t track, int pair_track)
+{
+    static const spot_t spots[2][NUM_TRACKS][PAIR_TRACKS_PER_GROUND_TRACK] = {
+        { {SPOT_5, SPOT_6}, {SPOT_3, SPOT_4}, {SPOT_1, SPOT_2} },   // SC_BACKWARD
+        { {SPOT_2, SPOT_1}, {SPOT_4, SPOT_3}, {SPOT_6, SPOT_5} }    // SC_FORWARD
+    };
+
+    if((sc_orient != SC_BACKWARD && sc_orient != SC_FORWARD) || track < RPT_1 || track > RPT_3)
+    {
+        return 0;
+    }
+
+    return spots[sc_orient][track - 1][pair_track];
 }
 
 /*----------------------------------------------------------------------------
  * Constructor
  *----------------------------------------------------------------------------*/
-Atl03Reader::Atl03Reader (lua_State* L, Asset* _asset, const char* resource, const char* outq_name, atl06_parms_t* _parms, int track):
-    LuaObject(L, OBJECT_TYPE, LuaMetaName, LuaMetaTable)
+Atl03Reader::Atl03Reader (lua_State* L, Asset* _asset, const char* resource, const char* outq_name, atl06_parms_t* _parms, int track, Atl06Dispatch* _atl06):
+    LuaObject(L, OBJECT_TYPE, LuaMetaName, LuaMetaTable),
+    postCond(NUM_POST_SIGS)
 {
     assert(_asset);
     assert(resource);
@@ -147,20 +205,39 @@ Atl03Reader::Atl03Reader (lua_State* L, Asset* _asset, const char* resource, con
     /* Create Publisher */
     outQ = new Publisher(outq_name);
 
+    /* Save Pointer to ATL06 Dispatch (optional) */
+    atl06 = _atl06;
+
     /* Set Parameters */
     parms = _parms;
 
+    /* Plan Datasets to Read */
+    plan = planReads(parms);
+
     /* Clear Statistics */
     stats.segments_read     = 0;
     stats.extents_filtered  = 0;
     stats.extents_sent      = 0;
     stats.extents_dropped   = 0;
     stats.extents_retried   = 0;
+    stats.bytes_avoided     = 0;
+    stats.windows_read      = 0;
+    stats.windows_waited    = 0;
+    stats.posts_stalled     = 0;
+    stats.posts_idled       = 0;
+    stats.posts_queued      = 0;
+    stats.posts_waiting     = 0;
 
     /* Initialize Readers */
     active = true;
     numComplete = 0;
-    LocalLib::set(readerPid, 0, sizeof(readerPid));
+    threadCount = 0;
+
+    /* Start Poster (posts the records of the readers unless fit in reader) */
+    posting = true;
+    posterAsleep = false;
+    postPid = NULL;
+    if(!atl06) postPid = new Thread(postThread, this);
 
     /* Initialize Global Information to Null */
     sc_orient       = NULL;
@@ -175,20 +252,40 @@ Atl03Reader::Atl03Reader (lua_State* L, Asset* _asset, const char* resource, con
         start_rgt       = new H5Array<int32_t>(_asset, resource, "/ancillary_data/start_rgt", &context);
         start_cycle     = new H5Array<int32_t>(_asset, resource, "/ancillary_data/start_cycle", &context);
 
+        /* Select Pair Tracks to Read (beams and spots) */
+        bool selected[NUM_TRACKS][PAIR_TRACKS_PER_GROUND_TRACK];
+        int selected_tracks = 0;
+        for(int t = 0; t < NUM_TRACKS; t++)
+        {
+            selected[t][PRT_LEFT] = selectPairTrack(t + 1, PRT_LEFT);
+            selected[t][PRT_RIGHT] = selectPairTrack(t + 1, PRT_RIGHT);
+            if((track == ALL_TRACKS || track == t + 1) && (selected[t][PRT_LEFT] || selected[t][PRT_RIGHT]))
+            {
+                selected_tracks++;
+            }
+        }
+
         /* Read ATL03 Track Data */
-        if(track == ALL_TRACKS)
+        if(selected_tracks == 0)
+        {
+            throw RunTimeException(INFO, "no beams selected in track %d", track);
+        }
+        else if(track == ALL_TRACKS)
         {
-            threadCount = NUM_TRACKS;
+            threadCount = selected_tracks;
 
-            /* Create Readers */
+            /* Submit Readers to Pool (of tracks with a pair track selected) */
             for(int t = 0; t < NUM_TRACKS; t++)
             {
+                if(!selected[t][PRT_LEFT] && !selected[t][PRT_RIGHT]) continue;
                 info_t* info = new info_t;
                 info->reader = this;
                 info->asset = _asset;
                 info->resource = StringLib::duplicate(resource);
                 info->track = t + 1;
-                readerPid[t] = new Thread(atl06Thread, info);
+                info->selected[PRT_LEFT] = selected[t][PRT_LEFT];
+                info->selected[PRT_RIGHT] = selected[t][PRT_RIGHT];
+                ReaderPool::submit(atl06Thread, info, this);
             }
         }
         else if(track >= 1 && track <= 3)
@@ -200,6 +297,8 @@ Atl03Reader::Atl03Reader (lua_State* L, Asset* _asset, const char* resource, con
             info->asset = _asset;
             info->resource = StringLib::duplicate(resource);
             info->track = track;
+            info->selected[PRT_LEFT] = selected[track - 1][PRT_LEFT];
+            info->selected[PRT_RIGHT] = selected[track - 1][PRT_RIGHT];
             atl06Thread(info);
         }
     }
@@ -220,134 +319,114 @@ Atl03Reader::~Atl03Reader (void)
 {
     active = false;
 
-    for(int t = 0; t < NUM_TRACKS; t++)
+    /* Withdraw Readers Not Yet Started */
+    List<void*> withdrawn;
+    ReaderPool::withdraw(this, &withdrawn);
+    for(int i = 0; i < withdrawn.length(); i++)
+    {
+        info_t* info = (info_t*)withdrawn[i];
+        delete [] info->resource;
+        delete info;
+    }
+
+    /* Wait for Readers Running */
+    threadCond.lock();
     {
-        if(readerPid[t]) delete readerPid[t];
+        numComplete += withdrawn.length();
+        while(numComplete < threadCount)
+        {
+            threadCond.wait(0, SYS_TIMEOUT);
+        }
+    }
+    threadCond.unlock();
+
+    /* Stop Poster (readers have posted their records) */
+    postCond.lock();
+    {
+        posting = false;
+        postCond.signal(RECORD_SIG);
     }
+    postCond.unlock();
+    if(postPid) delete postPid;
 
     delete outQ;
-    delete parms;
+    freeAtl06Parms(parms);
 
     if(sc_orient)       delete sc_orient;
     if(start_rgt)       delete start_rgt;
     if(start_cycle)     delete start_cycle;
 
     asset->releaseLuaObject();
+    if(atl06) atl06->releaseLuaObject();
 }
 
 /*----------------------------------------------------------------------------
  * Region::Constructor
  *----------------------------------------------------------------------------*/
-Atl03Reader::Region::Region (info_t* info, H5Api::context_t* context):
-    segment_lat    (info->asset, info->resource, info->track, "geolocation/reference_photon_lat", context),
-    segment_lon    (info->asset, info->resource, info->track, "geolocation/reference_photon_lon", context),
-    segment_ph_cnt (info->asset, info->resource, info->track, "geolocation/segment_ph_cnt",       context)
+Atl03Reader::Region::Region (info_t* info, H5Api::context_t* context)
 {
-    /* Initialize Region */
+    /* Initialize Region (pair tracks not selected are empty) */
     for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
     {
-        first_segment[t] = 0;
-        num_segments[t] = H5Api::ALL_ROWS;
-        first_photon[t] = 0;
-        num_photons[t] = H5Api::ALL_ROWS;
+        selected[t] = info->selected[t];
+        in_range[t] = false;
+        photon_index[t] = 0;
+        track_segments[t] = selected[t] ? H5Api::ALL_ROWS : 0;
+        track_photons[t] = selected[t] ? H5Api::ALL_ROWS : 0;
     }
 
     /* Determine Spatial Extent */
-    if(info->reader->parms->points_in_polygon > 0)
+    if(info->reader->plan.geolocation)
     {
-        /* Determine Best Projection To Use */
-        MathLib::proj_t projection = MathLib::PLATE_CARREE;
-        if(segment_lat.gt[PRT_LEFT][0] > 60.0) projection = MathLib::NORTH_POLAR;
-        else if(segment_lat.gt[PRT_LEFT][0] < -60.0) projection = MathLib::SOUTH_POLAR;
-
-        /* Project Polygon */
-        List<MathLib::coord_t>::Iterator poly_iterator(info->reader->parms->polygon);
-        MathLib::point_t* projected_poly = new MathLib::point_t [info->reader->parms->points_in_polygon];
-        for(int i = 0; i < info->reader->parms->points_in_polygon; i++)
+        /* Get Spatial Sidecars of Selected Pair Tracks (registered by indexer) */
+        Atl03Indexer::sidecar_t* sidecar[PAIR_TRACKS_PER_GROUND_TRACK] = { NULL, NULL };
+        bool have_sidecars = true;
+        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
         {
-            projected_poly[i] = MathLib::coord2point(poly_iterator[i], projection);
+            if(selected[t]) sidecar[t] = Atl03Indexer::getSidecar(info->asset, info->resource, info->track, t);
+            if(selected[t] && !sidecar[t]) have_sidecars = false;
         }
 
-        /* Find First Segment In Polygon */
-        bool first_segment_found[PAIR_TRACKS_PER_GROUND_TRACK] = {false, false};
-        bool last_segment_found[PAIR_TRACKS_PER_GROUND_TRACK] = {false, false};
-        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+        /* Find Segments In Polygon */
+        try
         {
-            int segment = 0;
-            while(segment < segment_ph_cnt.gt[t].size)
-            {
-                bool inclusion = false;
-
-                /* Project Segment Coordinate */
-                MathLib::coord_t segment_coord = {segment_lat.gt[t][segment], segment_lon.gt[t][segment]};
-                MathLib::point_t segment_point = MathLib::coord2point(segment_coord, projection);
-
-                /* Test Inclusion */
-                if(MathLib::inpoly(projected_poly, info->reader->parms->points_in_polygon, segment_point))
-                {
-                    inclusion = true;
-                }
-
-                /* Check First Segment */
-                if(!first_segment_found[t])
-                {
-                    /* If Coordinate Is In Polygon */
-                    if(inclusion && segment_ph_cnt.gt[t][segment] != 0)
-                    {
-                        /* Set First Segment */
-                        first_segment_found[t] = true;
-                        first_segment[t] = segment;
-
-                        /* Include Photons From First Segment */
-                        num_photons[t] = segment_ph_cnt.gt[t][segment];
-                    }
-                    else
-                    {
-                        /* Update Photon Index */
-                        first_photon[t] += segment_ph_cnt.gt[t][segment];
-                    }
-                }
-                else if(!last_segment_found[t])
-                {
-                    /* If Coordinate Is NOT In Polygon */
-                    if(!inclusion && segment_ph_cnt.gt[t][segment] != 0)
-                    {
-                        /* Set Last Segment */
-                        last_segment_found[t] = true;
-                        break; // full extent found!
-                    }
-                    else
-                    {
-                        /* Update Photon Index */
-                        num_photons[t] += segment_ph_cnt.gt[t][segment];
-                    }
-                }
-
-                /* Bump Segment */
-                segment++;
-            }
-
-            /* Set Number of Segments */
-            if(first_segment_found[t])
-            {
-                num_segments[t] = segment - first_segment[t];
-            }
+            if(have_sidecars) subsetBySidecar(info, context, sidecar);
+            else if(info->reader->parms->polygon_stride > 1) subsetByBisection(info, context);
+            else subsetByScan(info, context);
+        }
+        catch(const RunTimeException& e)
+        {
+            if(sidecar[PRT_LEFT]) Atl03Indexer::freeSidecar(sidecar[PRT_LEFT]);
+            if(sidecar[PRT_RIGHT]) Atl03Indexer::freeSidecar(sidecar[PRT_RIGHT]);
+            throw;
         }
 
-        /* Delete Projected Polygon */
-        delete [] projected_poly;
+        /* Free Spatial Sidecars */
+        if(sidecar[PRT_LEFT]) Atl03Indexer::freeSidecar(sidecar[PRT_LEFT]);
+        if(sidecar[PRT_RIGHT]) Atl03Indexer::freeSidecar(sidecar[PRT_RIGHT]);
 
-        /* Check If Anything to Process */
-        if(num_photons[PRT_LEFT] < 0 || num_photons[PRT_RIGHT] < 0)
+        /* Check If Anything to Process (a pair track with no runs leaves the other one-sided) */
+        if(ranges[PRT_LEFT].length() == 0 && ranges[PRT_RIGHT].length() == 0)
         {
             throw RunTimeException(INFO, "empty spatial region");
         }
-    }
 
-    /* Trim Geospatial Extent Datasets Read from HDF5 File */
-    segment_lat.trim(first_segment);
-    segment_lon.trim(first_segment);
-    segment_ph_cnt.trim(first_segment);
+        /* Pair Up Runs of Each Track */
+        matchRanges(info, context);
+    }
+    else
+    {
+        /* Single Run of Entire Track */
+        run_t run;
+        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+        {
+            run.first_segment[t] = 0;
+            run.num_segments[t] = selected[t] ? H5Api::ALL_ROWS : 0;
+            run.first_photon[t] = 0;
+            run.num_photons[t] = selected[t] ? H5Api::ALL_ROWS : 0;
+        }
+        runs.add(run);
+    }
 }
 
 /*----------------------------------------------------------------------------
@@ -358,410 +437,2181 @@ Atl03Reader::Region::~Region (void)
 }
 
 /*----------------------------------------------------------------------------
- * atl06Thread
+ * Region::subsetByScan
+ *
+ *  reads the geolocation of every segment and tests each one
  *----------------------------------------------------------------------------*/
-void* Atl03Reader::atl06Thread (void* parm)
+void Atl03Reader::Region::subsetByScan (info_t* info, H5Api::context_t* context)
 {
-    /* Get Thread Info */
-    info_t* info = (info_t*)parm;
-    Atl03Reader* reader = info->reader;
-    const Asset* asset = info->asset;
-    const char* resource = info->resource;
-    int track = info->track;
-    stats_t local_stats = {0, 0, 0, 0, 0};
+    long rows[PAIR_TRACKS_PER_GROUND_TRACK];
+    selectedRows(rows);
+    GTStream<double> segment_lat (info->asset, info->resource, info->track, "geolocation/reference_photon_lat", context, 0, GTArray<double>::DefaultStartRow, rows);
+    GTStream<double> segment_lon (info->asset, info->resource, info->track, "geolocation/reference_photon_lon", context, 0, GTArray<double>::DefaultStartRow, rows);
+    GTStream<int32_t> segment_ph_cnt (info->asset, info->resource, info->track, "geolocation/segment_ph_cnt", context, 0, GTArray<int32_t>::DefaultStartRow, rows);
+    segment_lat.join();
+    segment_lon.join();
+    segment_ph_cnt.join();
+
+    /* Determine Best Projection To Use */
+    MathLib::proj_t projection = selectProjection(segment_lat.gt[referenceTrack()][0]);
+
+    /* Find Segments In Polygon */
+    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+    {
+        for(long segment = 0; segment < segment_ph_cnt.gt[t].size; segment++)
+        {
+            /* Project Segment Coordinate */
+            MathLib::coord_t segment_coord = {segment_lat.gt[t][segment], segment_lon.gt[t][segment]};
+            MathLib::point_t segment_point = MathLib::coord2point(segment_coord, projection);
 
-    /* ATL08 Variables (dynamically allocated) */
-    GTArray<int32_t>* atl08_ph_segment_id   = NULL;
-    GTArray<int32_t>* atl08_classed_pc_indx = NULL;
-    GTArray<int8_t>*  atl08_classed_pc_flag = NULL;
+            /* Test Inclusion */
+            bool inclusion = info->reader->parms->polygon_index->inside(segment_point, projection);
 
-    /* Start Trace */
-    uint32_t trace_id = start_trace(INFO, reader->traceId, "atl03_reader", "{\"asset\":\"%s\", \"resource\":\"%s\", \"track\":%d}", info->asset->getName(), resource, track);
-    EventLib::stashId (trace_id); // set thread specific trace id for H5Api
+            /* Add Segment to Region */
+            addSegment(t, segment, inclusion, segment_ph_cnt.gt[t][segment]);
+        }
 
-    try
+        /* Close Run Reaching End of Track */
+        endTrack(t, segment_ph_cnt.gt[t].size);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Region::subsetBySidecar
+ *
+ *  uses the bounding boxes of the blocks in the sidecar to skip the blocks
+ *  that cannot contain a segment in the polygon; only the geolocation of
+ *  the blocks that can is read (plus the photon counts of the blocks in
+ *  which a run ends); the runs found are identical to subsetByScan
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::Region::subsetBySidecar (info_t* info, H5Api::context_t* context, Atl03Indexer::sidecar_t** sidecar)
+{
+    /* Determine Best Projection To Use */
+    MathLib::proj_t projection = selectProjection(sidecar[referenceTrack()]->first_lat);
+
+    /* Get Bounding Box of Projected Polygon */
+    MathLib::point_t poly_min, poly_max;
+    info->reader->parms->polygon_index->boundingBox(projection, &poly_min, &poly_max);
+
+    /* Find Segments In Polygon */
+    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
     {
-        /* Subset to Region of Interest */
-        Region region(info, &reader->context);
+        if(!selected[t]) continue;
 
-        /* Read ATL03 Data from HDF5 File */
-        GTArray<float>      velocity_sc         (asset, resource, track, "geolocation/velocity_sc", &reader->context, H5Api::ALL_COLS, region.first_segment, region.num_segments);
-        GTArray<double>     segment_delta_time  (asset, resource, track, "geolocation/delta_time", &reader->context, 0, region.first_segment, region.num_segments);
-        GTArray<int32_t>    segment_id          (asset, resource, track, "geolocation/segment_id", &reader->context, 0, region.first_segment, region.num_segments);
-        GTArray<double>     segment_dist_x      (asset, resource, track, "geolocation/segment_dist_x", &reader->context, 0, region.first_segment, region.num_segments);
-        GTArray<float>      dist_ph_along       (asset, resource, track, "heights/dist_ph_along", &reader->context, 0, region.first_photon, region.num_photons);
-        GTArray<float>      h_ph                (asset, resource, track, "heights/h_ph", &reader->context, 0, region.first_photon, region.num_photons);
-        GTArray<int8_t>     signal_conf_ph      (asset, resource, track, "heights/signal_conf_ph", &reader->context, reader->parms->surface_type, region.first_photon, region.num_photons);
-        GTArray<double>     lat_ph              (asset, resource, track, "heights/lat_ph", &reader->context, 0, region.first_photon, region.num_photons);
-        GTArray<double>     lon_ph              (asset, resource, track, "heights/lon_ph", &reader->context, 0, region.first_photon, region.num_photons);
-        GTArray<double>     delta_time          (asset, resource, track, "heights/delta_time", &reader->context, 0, region.first_photon, region.num_photons);
-        GTArray<double>     bckgrd_delta_time   (asset, resource, track, "bckgrd_atlas/delta_time", &reader->context);
-        GTArray<float>      bckgrd_rate         (asset, resource, track, "bckgrd_atlas/bckgrd_rate", &reader->context);
-
-        /* Read ATL08 Data from HDF5 File */
-        if(reader->parms->use_atl08_classification)
-        {
-            /* Build ATL08 Resource Name */
-            SafeString atl08_resource("%s", resource);
-            atl08_resource.setChar('8', 4); // change "ATL03 to ATL08"
-
-            /* Read ATL08 Datasets */
-            atl08_ph_segment_id     = new GTArray<int32_t>(asset, atl08_resource.getString(), track, "signal_photons/ph_segment_id", &reader->context08);
-            atl08_classed_pc_indx   = new GTArray<int32_t>(asset, atl08_resource.getString(), track, "signal_photons/classed_pc_indx", &reader->context08);
-            atl08_classed_pc_flag   = new GTArray<int8_t>(asset, atl08_resource.getString(), track, "signal_photons/classed_pc_flag", &reader->context08);
-        }
-
-        /* Initialize Dataset Scope Variables */
-        int32_t ph_in[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 }; // photon index
-        int32_t seg_in[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 }; // segment index
-        int32_t seg_ph[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 }; // current photon index in segment
-        int32_t start_segment[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 };
-        double  start_distance[PAIR_TRACKS_PER_GROUND_TRACK] = { segment_dist_x.gt[PRT_LEFT][0], segment_dist_x.gt[PRT_RIGHT][0] };
-        double  start_seg_portion[PAIR_TRACKS_PER_GROUND_TRACK] = { 0.0, 0.0 };
-        bool    track_complete[PAIR_TRACKS_PER_GROUND_TRACK] = { false, false };
-        int32_t bckgrd_in[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 }; // bckgrd index
-        int32_t atl08_in[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 }; // ATL08 datasets index
-
-        /* Set Number of Photons to Process (if not already set by subsetter) */
-        if(region.num_photons[PRT_LEFT] == H5Api::ALL_ROWS) region.num_photons[PRT_LEFT] = dist_ph_along.gt[PRT_LEFT].size;
-        if(region.num_photons[PRT_RIGHT] == H5Api::ALL_ROWS) region.num_photons[PRT_RIGHT] = dist_ph_along.gt[PRT_RIGHT].size;
-
-        /* Increment Read Statistics */
-        local_stats.segments_read = (region.segment_ph_cnt.gt[PRT_LEFT].size + region.segment_ph_cnt.gt[PRT_RIGHT].size);
-
-        /* Traverse All Photons In Dataset */
-        while( reader->active && (!track_complete[PRT_LEFT] || !track_complete[PRT_RIGHT]) )
-        {
-            List<photon_t> extent_photons[PAIR_TRACKS_PER_GROUND_TRACK];
-            int32_t extent_segment[PAIR_TRACKS_PER_GROUND_TRACK];
-            bool extent_valid[PAIR_TRACKS_PER_GROUND_TRACK] = { true, true };
-
-            /* Select Photons for Extent from each Track */
-            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+        char side = (t == PRT_LEFT) ? 'l' : 'r';
+        for(uint32_t b = 0; b < sidecar[t]->num_blocks; b++)
+        {
+            Atl03Indexer::sidecar_block_t* block = &sidecar[t]->blocks[b];
+
+            /* Check Block's Bounding Box */
+            bool candidate = (block->min_x[projection] <= poly_max.x) && (block->max_x[projection] >= poly_min.x) &&
+                             (block->min_y[projection] <= poly_max.y) && (block->max_y[projection] >= poly_min.y);
+
+            /* Skip Blocks Entirely Outside Polygon */
+            if(!candidate)
             {
-                /* Skip Completed Tracks */
-                if(track_complete[t])
+                if(!in_range[t])
                 {
-                    extent_valid[t] = false;
+                    photon_index[t] += block->num_photons;
                     continue;
                 }
+                else if(block->num_photons == 0)
+                {
+                    continue; // segments without photons do not end a run
+                }
+            }
+
+            /* Read Block */
+            H5Array<int32_t> block_ph_cnt(info->asset, info->resource, SafeString("/gt%d%c/geolocation/segment_ph_cnt", info->track, side).getString(), context, 0, block->first_segment, block->num_segments);
+            H5Array<double>* block_lat = NULL;
+            H5Array<double>* block_lon = NULL;
+            if(candidate)
+            {
+                block_lat = new H5Array<double>(info->asset, info->resource, SafeString("/gt%d%c/geolocation/reference_photon_lat", info->track, side).getString(), context, 0, block->first_segment, block->num_segments);
+                block_lon = new H5Array<double>(info->asset, info->resource, SafeString("/gt%d%c/geolocation/reference_photon_lon", info->track, side).getString(), context, 0, block->first_segment, block->num_segments);
+            }
+
+            /* Add Segments of Block to Region */
+            for(long s = 0; s < block_ph_cnt.size; s++)
+            {
+                bool inclusion = false;
+                if(candidate)
+                {
+                    MathLib::coord_t segment_coord = {(*block_lat)[s], (*block_lon)[s]};
+                    MathLib::point_t segment_point = MathLib::coord2point(segment_coord, projection);
+                    inclusion = info->reader->parms->polygon_index->inside(segment_point, projection);
+                }
+                addSegment(t, block->first_segment + s, inclusion, block_ph_cnt[s]);
+            }
+
+            delete block_lat;
+            delete block_lon;
+        }
 
-                /* Setup Variables for Extent */
-                int32_t current_photon = ph_in[t];
-                int32_t current_segment = seg_in[t];
-                int32_t current_count = seg_ph[t]; // number of photons in current segment already accounted for
-                int32_t current_atl08_photon = atl08_in[t];
-                bool extent_complete = false;
-                bool step_complete = false;
+        /* Close Run Reaching End of Track */
+        endTrack(t, sidecar[t]->num_segments);
+    }
+}
 
-                /* Set Extent Segment */
-                extent_segment[t] = seg_in[t];
-                start_seg_portion[t] = dist_ph_along.gt[t][current_photon] / ATL03_SEGMENT_LENGTH;
+/*----------------------------------------------------------------------------
+ * Region::subsetByBisection
+ *
+ *  samples the geolocation of every polygon_stride segments and bisects
+ *  between samples whose inclusion differs to find the segment at which
+ *  inclusion changes; the ground track is monotonic along-track, so this
+ *  assumes inclusion changes at most once between samples (a crossing of
+ *  the polygon shorter than the stride can be missed); only the photon
+ *  counts are read in full
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::Region::subsetByBisection (info_t* info, H5Api::context_t* context)
+{
+    long stride = info->reader->parms->polygon_stride;
+    long rows[PAIR_TRACKS_PER_GROUND_TRACK];
+    selectedRows(rows);
+    GTStream<int32_t> segment_ph_cnt (info->asset, info->resource, info->track, "geolocation/segment_ph_cnt", context, 0, GTArray<int32_t>::DefaultStartRow, rows);
+
+    /* Determine Best Projection To Use */
+    char reference_side = (referenceTrack() == PRT_LEFT) ? 'l' : 'r';
+    H5Array<double> first_lat(info->asset, info->resource, SafeString("/gt%d%c/geolocation/reference_photon_lat", info->track, reference_side).getString(), context, 0, 0, 1);
+    MathLib::proj_t projection = selectProjection(first_lat[0]);
+    segment_ph_cnt.join();
+
+    /* Find Segments In Polygon */
+    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+    {
+        /* Close Empty Pair Track (no segment to sample) */
+        long track_segments = segment_ph_cnt.gt[t].size;
+        if(track_segments <= 0)
+        {
+            endTrack(t, 0);
+            continue;
+        }
 
-                /* Traverse Photons Until Desired Along Track Distance Reached */
-                while(!extent_complete || !step_complete)
+        long segment = 0;
+        long sample = 0;
+        bool sample_inclusion = sampleInclusion(info, context, t, sample, projection);
+        while(segment < track_segments)
+        {
+            /* Sample Ahead */
+            long next_sample = MIN(sample + stride, track_segments - 1);
+            bool next_inclusion = sample_inclusion;
+            long transition = track_segments;
+            if(next_sample > sample)
+            {
+                next_inclusion = sampleInclusion(info, context, t, next_sample, projection);
+                if(next_inclusion != sample_inclusion)
                 {
-                    /* Go to Photon's Segment */
-                    current_count++;
-                    while((current_count > region.segment_ph_cnt.gt[t][current_segment]) &&
-                          (current_segment < segment_dist_x.gt[t].size) )
+                    /* Bisect Transition */
+                    long lower = sample;
+                    long upper = next_sample;
+                    while(upper - lower > 1)
                     {
-                        current_count = 1; // reset photons in segment
-                        current_segment++; // go to next segment
+                        long middle = lower + ((upper - lower) / 2);
+                        if(sampleInclusion(info, context, t, middle, projection) == sample_inclusion) lower = middle;
+                        else upper = middle;
                     }
+                    transition = upper;
+                }
+            }
 
-                    /* Check Current Segment */
-                    if(current_segment >= segment_dist_x.gt[t].size)
-                    {
-                        mlog(ERROR, "Photons with no segments are detected is %s!", resource);
-                        track_complete[t] = true;
-                        break;
-                    }
+            /* Add Segments Up To Next Sample */
+            long end_segment = (next_sample > sample) ? next_sample : track_segments;
+            while(segment < end_segment)
+            {
+                bool inclusion = (segment < transition) ? sample_inclusion : next_inclusion;
+                addSegment(t, segment, inclusion, segment_ph_cnt.gt[t][segment]);
+                segment++;
+            }
 
-                    /* Update Along Track Distance */
-                    double delta_distance = segment_dist_x.gt[t][current_segment] - start_distance[t];
-                    double along_track_distance = delta_distance + dist_ph_along.gt[t][current_photon];
+            /* Advance Sample */
+            sample = next_sample;
+            sample_inclusion = next_inclusion;
+        }
 
-                    /* Set Next Extent's First Photon */
-                    if(!step_complete && along_track_distance >= reader->parms->extent_step)
-                    {
-                        ph_in[t] = current_photon;
-                        seg_in[t] = current_segment;
-                        seg_ph[t] = current_count - 1;
-                        atl08_in[t] = current_atl08_photon;
-                        step_complete = true;
-                    }
+        /* Close Run Reaching End of Track */
+        endTrack(t, track_segments);
+    }
+}
 
-                    /* Check if Photon within Extent's Length */
-                    if(along_track_distance < reader->parms->extent_length)
-                    {
-                        /* Find ATL08 Classification */
-                        atl08_classification_t classification = ATL08_UNCLASSIFIED;
-                        bool acceptable_classification = true;
-                        if(reader->parms->use_atl08_classification)
-                        {
-                            /* Go To Segment */
-                            while( (current_atl08_photon < atl08_ph_segment_id->gt[t].size) &&
-                                   (atl08_ph_segment_id->gt[t][current_atl08_photon] < segment_id.gt[t][current_segment]) )
-                            {
-                                current_atl08_photon++;
-                            }
-
-                            /* Go To Photon */
-                            while( (current_atl08_photon < atl08_ph_segment_id->gt[t].size) &&
-                                   (atl08_ph_segment_id->gt[t][current_atl08_photon] == segment_id.gt[t][current_segment]) &&
-                                   (atl08_classed_pc_indx->gt[t][current_atl08_photon] < current_count) )
-                            {
-                                current_atl08_photon++;
-                            }
-
-                            /* Check Match */
-                            if( (current_atl08_photon < atl08_ph_segment_id->gt[t].size) &&
-                                (atl08_ph_segment_id->gt[t][current_atl08_photon] == segment_id.gt[t][current_segment]) &&
-                                (atl08_classed_pc_indx->gt[t][current_atl08_photon] == current_count) )
-                            {
-                                /* Assign Classification */
-                                classification = (atl08_classification_t)atl08_classed_pc_flag->gt[t][current_atl08_photon];
-
-                                /* Check Classification */
-                                if(classification >= 0 && classification < NUM_ATL08_CLASSES)
-                                {
-                                    /* Use Photon if Classification Selected */
-                                    acceptable_classification = reader->parms->atl08_class[classification];
-                                }
-                                else
-                                {
-                                    throw RunTimeException(CRITICAL, "invalid atl08 classification: %d", classification);
-                                }
-
-                                /* Got To Next Photon */
-                                current_atl08_photon++;
-                            }
-                            else
-                            {
-                                /* Photon Not Classified By ATL08*/
-                                acceptable_classification = reader->parms->atl08_class[ATL08_UNCLASSIFIED];
-                            }
-                        }
-
-                        /* Check Photon Signal Confidence Level and Classification */
-                        int8_t cnf = signal_conf_ph.gt[t][current_photon];
-                        if(acceptable_classification && (cnf >= reader->parms->signal_confidence))
-                        {
-                            photon_t ph = {
-                                .delta_time = delta_time.gt[t][current_photon],
-                                .latitude = lat_ph.gt[t][current_photon],
-                                .longitude = lon_ph.gt[t][current_photon],
-                                .distance = along_track_distance - (reader->parms->extent_length / 2.0),
-                                .height = h_ph.gt[t][current_photon],
-                                .atl08_class = (uint16_t)classification,
-                                .atl03_cnf = (int16_t)cnf
-                            };
-                            extent_photons[t].add(ph);
-                        }
-                    }
-                    else
-                    {
-                        extent_complete = true;
-                    }
+/*----------------------------------------------------------------------------
+ * Region::sampleInclusion
+ *
+ *  reads the geolocation of a single segment and tests it
+ *----------------------------------------------------------------------------*/
+bool Atl03Reader::Region::sampleInclusion (info_t* info, H5Api::context_t* context, int t, long segment, MathLib::proj_t projection)
+{
+    char side = (t == PRT_LEFT) ? 'l' : 'r';
+    H5Array<double> segment_lat(info->asset, info->resource, SafeString("/gt%d%c/geolocation/reference_photon_lat", info->track, side).getString(), context, 0, segment, 1);
+    H5Array<double> segment_lon(info->asset, info->resource, SafeString("/gt%d%c/geolocation/reference_photon_lon", info->track, side).getString(), context, 0, segment, 1);
 
-                    /* Go to Next Photon */
-                    current_photon++;
+    MathLib::coord_t segment_coord = {segment_lat[0], segment_lon[0]};
+    MathLib::point_t segment_point = MathLib::coord2point(segment_coord, projection);
+    return info->reader->parms->polygon_index->inside(segment_point, projection);
+}
 
-                    /* Check Current Photon */
-                    if(current_photon >= dist_ph_along.gt[t].size)
-                    {
-                        track_complete[t] = true;
-                        break;
-                    }
-                }
+/*----------------------------------------------------------------------------
+ * Region::addSegment
+ *
+ *  segments are added in order; a run starts at a segment in the polygon
+ *  with photons and ends at the next segment outside of the polygon with
+ *  photons
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::Region::addSegment (int t, long segment, bool inclusion, int32_t ph_cnt)
+{
+    if(!in_range[t])
+    {
+        /* Start Run at Segment In Polygon */
+        if(inclusion && ph_cnt != 0)
+        {
+            in_range[t] = true;
+            range[t].first_segment = segment;
+            range[t].num_segments = 0;
+            range[t].first_photon = photon_index[t];
+            range[t].num_photons = 0;
+        }
+    }
+    else
+    {
+        /* End Run at Segment NOT In Polygon */
+        if(!inclusion && ph_cnt != 0)
+        {
+            in_range[t] = false;
+            range[t].num_segments = segment - range[t].first_segment;
+            ranges[t].add(range[t]);
+        }
+    }
 
-                /* Add Step to Start Distance */
-                start_distance[t] += reader->parms->extent_step;
+    /* Update Photon Index */
+    if(in_range[t]) range[t].num_photons += ph_cnt;
+    photon_index[t] += ph_cnt;
+}
 
-                /* Apply Segment Distance Correction and Update Start Segment */
-                while( ((start_segment[t] + 1) < segment_dist_x.gt[t].size) &&
-                        (start_distance[t] >= segment_dist_x.gt[t][start_segment[t] + 1]) )
-                {
-                    start_distance[t] += segment_dist_x.gt[t][start_segment[t] + 1] - segment_dist_x.gt[t][start_segment[t]];
-                    start_distance[t] -= ATL03_SEGMENT_LENGTH;
-                    start_segment[t]++;
-                }
+/*----------------------------------------------------------------------------
+ * Region::endTrack
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::Region::endTrack (int t, long num_segments)
+{
+    if(in_range[t])
+    {
+        in_range[t] = false;
+        range[t].num_segments = num_segments - range[t].first_segment;
+        ranges[t].add(range[t]);
+    }
 
-                /* Check Photon Count */
-                if(extent_photons[t].length() < reader->parms->minimum_photon_count)
-                {
-                    extent_valid[t] = false;
-                }
+    /* Size of Pair Track */
+    track_segments[t] = num_segments;
+    track_photons[t] = photon_index[t];
+}
 
-                /* Check Along Track Spread */
-                if(extent_photons[t].length() > 1)
-                {
-                    int32_t last = extent_photons[t].length() - 1;
-                    double along_track_spread = extent_photons[t][last].distance - extent_photons[t][0].distance;
-                    if(along_track_spread < reader->parms->along_track_spread)
-                    {
-                        extent_valid[t] = false;
-                    }
-                }
+/*----------------------------------------------------------------------------
+ * Region::matchRanges
+ *
+ *  the extents of a track pair up the photons of both pair tracks, so the
+ *  runs of the left and right pair tracks are matched in order; when the
+ *  pair tracks cross the polygon a different number of times, the runs are
+ *  matched by their along-track span instead: runs whose segment ids overlap
+ *  are grouped into one run, and a run overlapping no run of the other pair
+ *  track is one-sided (no segments or photons of the other pair track)
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::Region::matchRanges (info_t* info, H5Api::context_t* context)
+{
+    run_t run;
+    if(!selected[PRT_LEFT] || !selected[PRT_RIGHT])
+    {
+        /* Runs of Only Selected Pair Track */
+        int s = selected[PRT_LEFT] ? PRT_LEFT : PRT_RIGHT;
+        for(int r = 0; r < ranges[s].length(); r++)
+        {
+            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+            {
+                run.first_segment[t] = (t == s) ? ranges[t][r].first_segment : 0;
+                run.num_segments[t] = (t == s) ? ranges[t][r].num_segments : 0;
+                run.first_photon[t] = (t == s) ? ranges[t][r].first_photon : 0;
+                run.num_photons[t] = (t == s) ? ranges[t][r].num_photons : 0;
+            }
+            runs.add(run);
+        }
+    }
+    else if(ranges[PRT_LEFT].length() == ranges[PRT_RIGHT].length())
+    {
+        for(int r = 0; r < ranges[PRT_LEFT].length(); r++)
+        {
+            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+            {
+                run.first_segment[t] = ranges[t][r].first_segment;
+                run.num_segments[t] = ranges[t][r].num_segments;
+                run.first_photon[t] = ranges[t][r].first_photon;
+                run.num_photons[t] = ranges[t][r].num_photons;
+            }
+            runs.add(run);
+        }
+    }
+    else
+    {
+        /* Along-Track Span of Each Run (segment ids are shared by the pair tracks) */
+        List<int32_t> first_id[PAIR_TRACKS_PER_GROUND_TRACK];
+        List<int32_t> last_id[PAIR_TRACKS_PER_GROUND_TRACK];
+        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+        {
+            for(int r = 0; r < ranges[t].length(); r++)
+            {
+                range_t& range = ranges[t][r];
+                first_id[t].add(segmentId(info, context, t, range.first_segment));
+                last_id[t].add(segmentId(info, context, t, range.first_segment + range.num_segments - 1));
             }
+        }
 
-            /* Create Extent Record */
-            if(extent_valid[PRT_LEFT] || extent_valid[PRT_RIGHT] || reader->parms->pass_invalid)
+        /* Group Overlapping Runs in Along-Track Order */
+        int next[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 }; // first run not yet grouped
+        while(next[PRT_LEFT] < ranges[PRT_LEFT].length() || next[PRT_RIGHT] < ranges[PRT_RIGHT].length())
+        {
+            /* Start Group at Run Starting First */
+            int s;
+            if(next[PRT_LEFT] >= ranges[PRT_LEFT].length()) s = PRT_RIGHT;
+            else if(next[PRT_RIGHT] >= ranges[PRT_RIGHT].length()) s = PRT_LEFT;
+            else s = (first_id[PRT_RIGHT][next[PRT_RIGHT]] < first_id[PRT_LEFT][next[PRT_LEFT]]) ? PRT_RIGHT : PRT_LEFT;
+            int first[PAIR_TRACKS_PER_GROUND_TRACK] = { next[PRT_LEFT], next[PRT_RIGHT] };
+            int32_t end_id = last_id[s][next[s]++];
+
+            /* Add Runs of Either Pair Track Starting Within Group */
+            bool grown = true;
+            while(grown)
             {
-                /* Calculate Extent Record Size */
-                int num_photons = extent_photons[PRT_LEFT].length() + extent_photons[PRT_RIGHT].length();
-                int extent_bytes = sizeof(extent_t) + (sizeof(photon_t) * num_photons);
-
-                /* Allocate and Initialize Extent Record */
-                RecordObject record(exRecType, extent_bytes);
-                extent_t* extent = (extent_t*)record.getRecordData();
-                extent->reference_pair_track = track;
-                extent->spacecraft_orientation = (*reader->sc_orient)[0];
-                extent->reference_ground_track_start = (*reader->start_rgt)[0];
-                extent->cycle_start = (*reader->start_cycle)[0];
-
-                /* Populate Extent */
-                uint32_t ph_out = 0;
+                grown = false;
                 for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
                 {
-                    /* Find Background */
-                    double background_rate = bckgrd_rate.gt[t][bckgrd_rate.gt[t].size - 1];
-                    while(bckgrd_in[t] < bckgrd_rate.gt[t].size)
-                    {
-                        double curr_bckgrd_time = bckgrd_delta_time.gt[t][bckgrd_in[t]];
-                        double segment_time = segment_delta_time.gt[t][extent_segment[t]];
-                        if(curr_bckgrd_time >= segment_time)
-                        {
-                            /* Interpolate Background Rate */
-                            if(bckgrd_in[t] > 0)
-                            {
-                                double prev_bckgrd_time = bckgrd_delta_time.gt[t][bckgrd_in[t] - 1];
-                                double prev_bckgrd_rate = bckgrd_rate.gt[t][bckgrd_in[t] - 1];
-                                double curr_bckgrd_rate = bckgrd_rate.gt[t][bckgrd_in[t]];
-
-                                double bckgrd_run = curr_bckgrd_time - prev_bckgrd_time;
-                                double bckgrd_rise = curr_bckgrd_rate - prev_bckgrd_rate;
-                                double segment_to_bckgrd_delta = segment_time - prev_bckgrd_time;
-
-                                background_rate = ((bckgrd_rise / bckgrd_run) * segment_to_bckgrd_delta) + prev_bckgrd_rate;
-                            }
-                            else
-                            {
-                                /* Use First Background Rate (no interpolation) */
-                                background_rate = bckgrd_rate.gt[t][0];
-                            }
-                            break;
-                        }
-                        else
-                        {
-                            /* Go To Next Background Rate */
-                            bckgrd_in[t]++;
-                        }
-                    }
-
-                    /* Calculate Spacecraft Velocity */
-                    int32_t sc_v_offset = extent_segment[t] * 3;
-                    double sc_v1 = velocity_sc.gt[t][sc_v_offset + 0];
-                    double sc_v2 = velocity_sc.gt[t][sc_v_offset + 1];
-                    double sc_v3 = velocity_sc.gt[t][sc_v_offset + 2];
-                    double spacecraft_velocity = sqrt((sc_v1*sc_v1) + (sc_v2*sc_v2) + (sc_v3*sc_v3));
-
-                    /* Calculate Segment ID (attempt to arrive at closest ATL06 segment ID represented by extent) */
-                    double atl06_segment_id = (double)segment_id.gt[t][extent_segment[t]];              // start with first segment in extent
-                    atl06_segment_id += start_seg_portion[t];                                           // add portion of first segment that first photon is included
-                    atl06_segment_id += (reader->parms->extent_length / ATL03_SEGMENT_LENGTH) / 2.0;    // add half the left of the extent
-
-                    /* Populate Attributes */
-                    extent->valid[t]                = extent_valid[t];
-                    extent->segment_id[t]           = (uint32_t)(atl06_segment_id + 0.5);
-                    extent->extent_length[t]        = reader->parms->extent_length;
-                    extent->spacecraft_velocity[t]  = spacecraft_velocity;
-                    extent->background_rate[t]      = background_rate;
-                    extent->photon_count[t]         = extent_photons[t].length();
-
-                    /* Populate Photons */
-                    if(num_photons > 0)
+                    while(next[t] < ranges[t].length() && first_id[t][next[t]] <= end_id)
                     {
-                        for(int32_t p = 0; p < extent_photons[t].length(); p++)
-                        {
-                            extent->photons[ph_out++] = extent_photons[t][p];
-                        }
+                        end_id = MAX(end_id, last_id[t][next[t]]);
+                        next[t]++;
+                        grown = true;
                     }
                 }
+            }
 
-                /* Set Photon Pointer Fields */
-                extent->photon_offset[PRT_LEFT] = sizeof(extent_t); // pointers are set to offset from start of record data
-                extent->photon_offset[PRT_RIGHT] = sizeof(extent_t) + (sizeof(photon_t) * extent->photon_count[PRT_LEFT]);
-
-                /* Post Segment Record */
-                uint8_t* rec_buf = NULL;
-                int rec_bytes = record.serialize(&rec_buf, RecordObject::REFERENCE);
-                int post_status = MsgQ::STATE_TIMEOUT;
-                while(reader->active && (post_status = reader->outQ->postCopy(rec_buf, rec_bytes, SYS_TIMEOUT)) == MsgQ::STATE_TIMEOUT)
-                {
-                    local_stats.extents_retried++;
-                }
-
-                /* Update Statistics */
-                if(post_status > 0)
+            /* Span Runs of Group (pair track with no run in group is empty) */
+            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+            {
+                if(next[t] > first[t])
                 {
-                    local_stats.extents_sent++;
+                    range_t& first_range = ranges[t][first[t]];
+                    range_t& last_range = ranges[t][next[t] - 1];
+                    run.first_segment[t] = first_range.first_segment;
+                    run.num_segments[t] = last_range.first_segment + last_range.num_segments - first_range.first_segment;
+                    run.first_photon[t] = first_range.first_photon;
+                    run.num_photons[t] = last_range.first_photon + last_range.num_photons - first_range.first_photon;
                 }
                 else
                 {
-                    mlog(ERROR, "Atl03 reader failed to post to stream %s: %d", reader->outQ->getName(), post_status);
-                    local_stats.extents_dropped++;
+                    run.first_segment[t] = 0;
+                    run.num_segments[t] = 0;
+                    run.first_photon[t] = 0;
+                    run.num_photons[t] = 0;
                 }
             }
-            else // neither pair in extent valid
-            {
-                local_stats.extents_filtered++;
-            }
-
+            runs.add(run);
         }
     }
-    catch(const RunTimeException& e)
+}
+
+/*----------------------------------------------------------------------------
+ * Region::segmentId
+ *
+ *  reads the segment id of a single segment
+ *----------------------------------------------------------------------------*/
+int32_t Atl03Reader::Region::segmentId (info_t* info, H5Api::context_t* context, int t, long segment)
+{
+    char side = (t == PRT_LEFT) ? 'l' : 'r';
+    H5Array<int32_t> segment_id(info->asset, info->resource, SafeString("/gt%d%c/geolocation/segment_id", info->track, side).getString(), context, 0, segment, 1);
+    return segment_id[0];
+}
+
+/*----------------------------------------------------------------------------
+ * Region::selectedRows
+ *
+ *  rows to read of datasets read in full (none for pair tracks not selected)
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::Region::selectedRows (long* rows)
+{
+    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
     {
-        mlog(e.level(), "Failure during processing of resource %s track %d: %s", resource, track, e.what());
+        rows[t] = selected[t] ? H5Api::ALL_ROWS : 0;
     }
+}
 
-    /* Handle Global Reader Updates */
-    reader->threadMut.lock();
-    {
-        /* Update Statistics */
-        reader->stats.segments_read += local_stats.segments_read;
-        reader->stats.extents_filtered += local_stats.extents_filtered;
-        reader->stats.extents_sent += local_stats.extents_sent;
-        reader->stats.extents_dropped += local_stats.extents_dropped;
-        reader->stats.extents_retried += local_stats.extents_retried;
+/*----------------------------------------------------------------------------
+ * Region::referenceTrack
+ *
+ *  pair track whose first segment selects the projection (left unless only
+ *  the right is selected)
+ *----------------------------------------------------------------------------*/
+int Atl03Reader::Region::referenceTrack (void)
+{
+    return selected[PRT_LEFT] ? PRT_LEFT : PRT_RIGHT;
+}
 
-        /* Count Completion */
-        reader->numComplete++;
+/*----------------------------------------------------------------------------
+ * Region::selectProjection
+ *----------------------------------------------------------------------------*/
+MathLib::proj_t Atl03Reader::Region::selectProjection (double latitude)
+{
+    if(latitude > 60.0) return MathLib::NORTH_POLAR;
+    else if(latitude < -60.0) return MathLib::SOUTH_POLAR;
+    else return MathLib::PLATE_CARREE;
+}
+
+/*----------------------------------------------------------------------------
+ * PhotonWindow::Constructor
+ *----------------------------------------------------------------------------*/
+Atl03Reader::PhotonWindow::PhotonWindow (void)
+{
+    size = INITIAL_SIZE;
+    ring = new entry_t [size];
+    head = 0;
+    count = 0;
+}
+
+/*----------------------------------------------------------------------------
+ * PhotonWindow::Destructor
+ *----------------------------------------------------------------------------*/
+Atl03Reader::PhotonWindow::~PhotonWindow (void)
+{
+    delete [] ring;
+}
+
+/*----------------------------------------------------------------------------
+ * PhotonWindow::add
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::PhotonWindow::add (const entry_t& entry)
+{
+    /* Grow Ring (unwrapping entries into new ring) */
+    if(count == size)
+    {
+        entry_t* new_ring = new entry_t [size * 2];
+        for(int i = 0; i < count; i++)
+        {
+            new_ring[i] = ring[(head + i) & (size - 1)];
+        }
+        delete [] ring;
+        ring = new_ring;
+        size *= 2;
+        head = 0;
+    }
+
+    /* Add Entry to Tail */
+    ring[(head + count) & (size - 1)] = entry;
+    count++;
+}
+
+/*----------------------------------------------------------------------------
+ * PhotonWindow::trim
+ *
+ *  removes all entries from the head of the window whose photon index is less
+ *  than the supplied index (i.e. photons no longer in any extent)
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::PhotonWindow::trim (int32_t first_index)
+{
+    while(count > 0 && ring[head].index < first_index)
+    {
+        head = (head + 1) & (size - 1);
+        count--;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * PhotonWindow::length
+ *----------------------------------------------------------------------------*/
+int Atl03Reader::PhotonWindow::length (void)
+{
+    return count;
+}
+
+/*----------------------------------------------------------------------------
+ * PhotonWindow::operator[]
+ *----------------------------------------------------------------------------*/
+Atl03Reader::PhotonWindow::entry_t& Atl03Reader::PhotonWindow::operator[] (int i)
+{
+    return ring[(head + i) & (size - 1)];
+}
+
+/*----------------------------------------------------------------------------
+ * PhotonStreams::Constructor
+ *
+ *  starts streaming the photon data of the rows given (of each pair track)
+ *----------------------------------------------------------------------------*/
+Atl03Reader::PhotonStreams::PhotonStreams (info_t* info, const long* first_photon, const long* num_photons, long stream_rows):
+    dist_ph_along   (info->asset, info->resource, info->track, "heights/dist_ph_along", &info->reader->context, 0, first_photon, num_photons, stream_rows),
+    h_ph            (info->asset, info->resource, info->track, "heights/h_ph", &info->reader->context, 0, first_photon, num_photons, stream_rows),
+    signal_conf_ph  (info->asset, info->resource, info->track, "heights/signal_conf_ph", &info->reader->context, info->reader->parms->surface_type, first_photon, num_photons, stream_rows),
+    lat_ph          (info->asset, info->resource, info->track, "heights/lat_ph", &info->reader->context, 0, first_photon, num_photons, stream_rows),
+    lon_ph          (info->asset, info->resource, info->track, "heights/lon_ph", &info->reader->context, 0, first_photon, num_photons, stream_rows),
+    delta_time      (info->asset, info->resource, info->track, "heights/delta_time", &info->reader->context, 0, first_photon, num_photons, stream_rows)
+{
+}
+
+/*----------------------------------------------------------------------------
+ * PhotonStreams::Destructor
+ *----------------------------------------------------------------------------*/
+Atl03Reader::PhotonStreams::~PhotonStreams (void)
+{
+}
+
+/*----------------------------------------------------------------------------
+ * PhotonStreams::join
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::PhotonStreams::join (void)
+{
+    dist_ph_along.join();
+    h_ph.join();
+    signal_conf_ph.join();
+    lat_ph.join();
+    lon_ph.join();
+    delta_time.join();
+}
+
+/*----------------------------------------------------------------------------
+ * PhotonStreams::release
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::PhotonStreams::release (const int32_t* ph_in)
+{
+    dist_ph_along.release(ph_in);
+    h_ph.release(ph_in);
+    signal_conf_ph.release(ph_in);
+    lat_ph.release(ph_in);
+    lon_ph.release(ph_in);
+    delta_time.release(ph_in);
+}
+
+/*----------------------------------------------------------------------------
+ * PhotonStreams::countWindows
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::PhotonStreams::countWindows (stats_t* local_stats)
+{
+    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+    {
+        local_stats->windows_read += dist_ph_along.gt[t].windows_read + h_ph.gt[t].windows_read + signal_conf_ph.gt[t].windows_read +
+                                     lat_ph.gt[t].windows_read + lon_ph.gt[t].windows_read + delta_time.gt[t].windows_read;
+        local_stats->windows_waited += dist_ph_along.gt[t].windows_waited + h_ph.gt[t].windows_waited + signal_conf_ph.gt[t].windows_waited +
+                                       lat_ph.gt[t].windows_waited + lon_ph.gt[t].windows_waited + delta_time.gt[t].windows_waited;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * PostStage::Constructor
+ *
+ *  the records queued by the thread generating extents are posted by the
+ *  poster of the reader, a thread of its own (not a pool worker, so it is
+ *  never starved by tasks generating extents), so that a slow subscriber
+ *  only stalls extent generation once the queue is full
+ *----------------------------------------------------------------------------*/
+Atl03Reader::PostStage::PostStage (Atl03Reader* _reader):
+    queue(POST_QUEUE_DEPTH)
+{
+    reader = _reader;
+    pushed = 0;
+    posted = 0;
+    LocalLib::set(&stats, 0, sizeof(stats));
+
+    /* Register with Poster */
+    reader->postCond.lock();
+    {
+        reader->postStages.add(this);
+    }
+    reader->postCond.unlock();
+}
+
+/*----------------------------------------------------------------------------
+ * PostStage::Destructor
+ *----------------------------------------------------------------------------*/
+Atl03Reader::PostStage::~PostStage (void)
+{
+    complete();
+
+    /* Unregister from Poster (no longer touched once its records are posted) */
+    reader->postCond.lock();
+    {
+        for(int i = 0; i < reader->postStages.length(); i++)
+        {
+            if(reader->postStages[i] == this)
+            {
+                reader->postStages.remove(i);
+                break;
+            }
+        }
+    }
+    reader->postCond.unlock();
+}
+
+/*----------------------------------------------------------------------------
+ * PostStage::post
+ *
+ *  queues a serialized record, waiting for the poster to make room while
+ *  the queue is full
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::PostStage::post (unsigned char* buffer, int size, int count, stats_t* local_stats)
+{
+    post_t record = { buffer, size, count };
+
+    local_stats->posts_queued++;
+    local_stats->posts_waiting += queue.length();
+
+    if(!queue.push(record))
+    {
+        local_stats->posts_stalled++;
+        do
+        {
+            queue.waitPush(SYS_TIMEOUT);
+        }
+        while(!queue.push(record));
+    }
+    pushed++;
+
+    reader->wakePoster();
+}
+
+/*----------------------------------------------------------------------------
+ * PostStage::finish
+ *
+ *  waits for the records queued to be posted and adds the statistics of
+ *  posting them
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::PostStage::finish (stats_t* local_stats)
+{
+    complete();
+
+    reader->postCond.lock();
+    {
+        local_stats->extents_sent += stats.extents_sent;
+        local_stats->extents_dropped += stats.extents_dropped;
+        local_stats->extents_retried += stats.extents_retried;
+        local_stats->posts_idled += stats.posts_idled;
+        LocalLib::set(&stats, 0, sizeof(stats));
+    }
+    reader->postCond.unlock();
+}
+
+/*----------------------------------------------------------------------------
+ * PostStage::drain
+ *
+ *  posts the records queued, up to a queue full at a time so that the other
+ *  stages are not held up; called by the poster with the lock held, which
+ *  is released while posting (the stage is not deleted while a record it
+ *  queued is not yet counted as posted); returns whether any were posted
+ *----------------------------------------------------------------------------*/
+bool Atl03Reader::PostStage::drain (void)
+{
+    int drained = 0;
+
+    post_t record;
+    while(drained < POST_QUEUE_DEPTH && queue.pop(record))
+    {
+        reader->postCond.unlock();
+        {
+            reader->postRecord(record.buffer, record.size, record.count, &stats);
+        }
+        reader->postCond.lock();
+        posted++;
+        drained++;
+    }
+
+    if(drained > 0)
+    {
+        if(queue.length() == 0) stats.posts_idled++;
+        reader->postCond.signal(POSTED_SIG, Cond::NOTIFY_ALL);
+    }
+
+    return drained > 0;
+}
+
+/*----------------------------------------------------------------------------
+ * PostStage::waiting
+ *
+ *  whether records are queued
+ *----------------------------------------------------------------------------*/
+bool Atl03Reader::PostStage::waiting (void)
+{
+    return queue.length() > 0;
+}
+
+/*----------------------------------------------------------------------------
+ * PostStage::complete
+ *
+ *  waits for the poster to post the records queued
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::PostStage::complete (void)
+{
+    reader->postCond.lock();
+    {
+        while(posted < pushed)
+        {
+            reader->postCond.wait(POSTED_SIG, SYS_TIMEOUT);
+        }
+    }
+    reader->postCond.unlock();
+}
+
+/*----------------------------------------------------------------------------
+ * ExtentBuilder::Constructor
+ *----------------------------------------------------------------------------*/
+Atl03Reader::ExtentBuilder::ExtentBuilder (void)
+{
+    segment_ph_cnt = NULL;
+    segment_dist_x = NULL;
+    dist_ph_along = NULL;
+    h_ph = NULL;
+    signal_conf_ph = NULL;
+    lat_ph = NULL;
+    lon_ph = NULL;
+    delta_time = NULL;
+    classes = NULL;
+    photons = 0;
+    entries = 0;
+    next_ph = 0;
+    next_seg = 0;
+    next_seg_ph = 0;
+    selection = 0;
+    selection_ph = 0;
+    selection_end = 0;
+}
+
+/*----------------------------------------------------------------------------
+ * ExtentBuilder::Destructor
+ *----------------------------------------------------------------------------*/
+Atl03Reader::ExtentBuilder::~ExtentBuilder (void)
+{
+}
+
+/*----------------------------------------------------------------------------
+ * ExtentBuilder::start
+ *
+ *  starts classifying photons at the first photon of the cursor given (the
+ *  cursor of the first extent built)
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::ExtentBuilder::start (const cursor_t& c)
+{
+    next_ph = c.ph_in;
+    next_seg = c.seg_in;
+    next_seg_ph = c.seg_ph;
+    selection = 0;
+    selection_ph = 0;
+    selection_end = 0;
+}
+
+/*----------------------------------------------------------------------------
+ * ExtentBuilder::build
+ *
+ *  builds the extent at the cursor, moving the cursor to the next extent;
+ *  photons are classified and filtered once, the first time an extent
+ *  visits them, and kept in the window until an extent starts past them;
+ *  the photons of the extent are the first entries of the window that are
+ *  marked in the extent; returns whether the extent is valid
+ *----------------------------------------------------------------------------*/
+bool Atl03Reader::ExtentBuilder::build (cursor_t& c, const atl06_parms_t* parms, bool* segments_missing)
+{
+    photons = 0;
+    entries = 0;
+
+    /* Drop Photons Preceding Extent from Window */
+    window.trim(c.ph_in);
+
+    /* Walk Photons of Extent (moving cursor to next extent) */
+    int32_t end_photon = walkExtent(c, *segment_ph_cnt, *segment_dist_x, *dist_ph_along, parms, segments_missing);
+
+    /* Classify and Filter Photons Not Yet Visited by a Previous Extent */
+    while(next_ph < end_photon)
+    {
+        int32_t current_photon = next_ph;
+
+        /* Go to Photon's Segment */
+        next_seg_ph++;
+        while((next_seg_ph > (*segment_ph_cnt)[next_seg]) &&
+              (next_seg < segment_dist_x->size) )
+        {
+            next_seg_ph = 1; // reset photons in segment
+            next_seg++; // go to next segment
+        }
+
+        /* Select Next Block of Photons */
+        if(current_photon >= selection_end)
+        {
+            selection_ph = current_photon;
+            selection_end = MIN(current_photon + SELECTION_BLOCK_PHOTONS, signal_conf_ph->size);
+            selection = selectPhotons(*signal_conf_ph, classes, parms, selection_ph, selection_end - selection_ph);
+        }
+
+        /* Add Photon Accepted by Signal Confidence Level and Classification */
+        if((selection >> (current_photon - selection_ph)) & 1)
+        {
+            atl08_classification_t classification = ATL08_UNCLASSIFIED;
+            if(classes) classification = (atl08_classification_t)classes[current_photon];
+            int8_t cnf = (*signal_conf_ph)[current_photon];
+            PhotonWindow::entry_t entry = {
+                .index = current_photon,
+                .in_extent = false,
+                .segment_dist_x = (*segment_dist_x)[next_seg],
+                .dist_ph_along = (*dist_ph_along)[current_photon],
+                .photon = {
+                    .delta_time = (*delta_time)[current_photon],
+                    .latitude = (*lat_ph)[current_photon],
+                    .longitude = (*lon_ph)[current_photon],
+                    .distance = 0.0, // relative to extent
+                    .height = (*h_ph)[current_photon],
+                    .atl08_class = (uint16_t)classification,
+                    .atl03_cnf = (int16_t)cnf
+                }
+            };
+            window.add(entry);
+        }
+
+        /* Mark Photon as Classified */
+        next_ph = current_photon + 1;
+    }
+
+    /* Select Photons in Window within Extent's Length */
+    double first_distance = 0.0;
+    double last_distance = 0.0;
+    while(entries < window.length() && window[entries].index < end_photon)
+    {
+        PhotonWindow::entry_t& entry = window[entries++];
+        double delta_distance = entry.segment_dist_x - c.start_distance;
+        double along_track_distance = delta_distance + entry.dist_ph_along;
+        entry.in_extent = along_track_distance < parms->extent_length;
+        if(entry.in_extent)
+        {
+            entry.photon.distance = along_track_distance - (parms->extent_length / 2.0);
+            if(photons == 0) first_distance = entry.photon.distance;
+            last_distance = entry.photon.distance;
+            photons++;
+        }
+    }
+
+    /* Step Start of Extent */
+    stepStart(c, *segment_dist_x, parms);
+
+    /* Check Photon Count */
+    bool valid = true;
+    if(photons < parms->minimum_photon_count)
+    {
+        valid = false;
+    }
+
+    /* Check Along Track Spread */
+    if(photons > 1)
+    {
+        double along_track_spread = last_distance - first_distance;
+        if(along_track_spread < parms->along_track_spread)
+        {
+            valid = false;
+        }
+    }
+
+    return valid;
+}
+
+/*----------------------------------------------------------------------------
+ * planReads
+ *
+ *  works out which of the optional datasets the request needs: the segment
+ *  geolocation is only needed to subset to a polygon, and the spacecraft
+ *  velocity and background rate are only needed by the least squares fit
+ *  (when the extents are fit) or when returned in the extents (i.e. not
+ *  compact)
+ *----------------------------------------------------------------------------*/
+Atl03Reader::read_plan_t Atl03Reader::planReads (const atl06_parms_t* parms)
+{
+    read_plan_t plan;
+
+    bool fit = parms->consumer == CONSUMER_ATL06 && parms->stages[STAGE_LSF];
+    plan.geolocation = parms->points_in_polygon > 0;
+    plan.velocity = fit || !parms->compact;
+    plan.background = fit || !parms->compact;
+    plan.atl08 = parms->use_atl08_classification;
+
+    return plan;
+}
+
+/*----------------------------------------------------------------------------
+ * selectPairTrack
+ *
+ *  a pair track is read when both its ground track and its spot are
+ *  selected; the spot depends on the orientation of the spacecraft, and
+ *  when the orientation is in transition the spot selection is not applied
+ *----------------------------------------------------------------------------*/
+bool Atl03Reader::selectPairTrack (int track, int pair_track)
+{
+    /* Check Ground Track (beams are in gt_t order: gt1l, gt1r, gt2l, ...) */
+    if(!parms->beams[((track - 1) * PAIR_TRACKS_PER_GROUND_TRACK) + pair_track]) return false;
+
+    /* Check Spot */
+    int spot = getSpot((sc_orient_t)(*sc_orient)[0], (track_t)track, pair_track);
+    if(spot == 0)
+    {
+        mlog(WARNING, "Spacecraft orientation in transition, spots of track %d not selected by %s", track, LUA_PARM_SPOTS);
+        return true;
+    }
+
+    return parms->spots[spot - 1];
+}
+
+/*----------------------------------------------------------------------------
+ * atl06Thread
+ *----------------------------------------------------------------------------*/
+void* Atl03Reader::atl06Thread (void* parm)
+{
+    /* Get Thread Info */
+    info_t* info = (info_t*)parm;
+    Atl03Reader* reader = info->reader;
+    const Asset* asset = info->asset;
+    const char* resource = info->resource;
+    int track = info->track;
+    stats_t local_stats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    /* Rows Read of Datasets Not Needed, and of Datasets Read in Full */
+    const long no_rows[PAIR_TRACKS_PER_GROUND_TRACK] = {0, 0};
+    const long all_rows[PAIR_TRACKS_PER_GROUND_TRACK] = {
+        info->selected[PRT_LEFT] ? H5Api::ALL_ROWS : 0,
+        info->selected[PRT_RIGHT] ? H5Api::ALL_ROWS : 0
+    };
+
+    /* ATL08 Resource Name (outlives the ATL08 reads) */
+    SafeString atl08_resource("%s", resource);
+    atl08_resource.setChar('8', 4); // change "ATL03 to ATL08"
+
+    /* ATL08 Variables (dynamically allocated) */
+    GTStream<int32_t>* atl08_ph_segment_id = NULL;
+    uint8_t* atl08_class_ph[PAIR_TRACKS_PER_GROUND_TRACK] = { NULL, NULL }; // ATL08 class of each photon of run
+    long atl08_class_size[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 };
+
+    /* Segment Tables of Run (dynamically allocated) */
+    double* background_rates[PAIR_TRACKS_PER_GROUND_TRACK] = { NULL, NULL }; // background rate at each segment of run
+    double* spacecraft_speeds[PAIR_TRACKS_PER_GROUND_TRACK] = { NULL, NULL }; // spacecraft speed at each segment of run
+    long segment_table_size[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 };
+
+    /* Extent Record Being Populated (posted by a posting stage unless fit in reader) */
+    batch_t batch = { NULL, 0, 0, NULL, 0, NULL };
+    if(!reader->atl06) batch.poster = new PostStage(reader);
+
+    /* Start Trace */
+    uint32_t trace_id = start_trace(INFO, reader->traceId, "atl03_reader", "{\"asset\":\"%s\", \"resource\":\"%s\", \"track\":%d}", info->asset->getName(), resource, track);
+    EventLib::stashId (trace_id); // set thread specific trace id for H5Api
+
+    try
+    {
+        /* Start Reading ATL08 Segment Ids from HDF5 File (searched for the photons of each run) */
+        if(reader->plan.atl08)
+        {
+            atl08_ph_segment_id = new GTStream<int32_t>(asset, atl08_resource.getString(), track, "signal_photons/ph_segment_id", &reader->context08, 0, GTArray<int32_t>::DefaultStartRow, all_rows);
+        }
+
+        /* Start Reading Background Times from HDF5 File (searched for the background rates of each run) */
+        const long* bckgrd_rows = reader->plan.background ? all_rows : no_rows;
+        GTStream<double> bckgrd_delta_time (asset, resource, track, "bckgrd_atlas/delta_time", &reader->context, 0, GTArray<double>::DefaultStartRow, bckgrd_rows);
+
+        /* Subset to Region of Interest */
+        Region region(info, &reader->context);
+
+        /* Count Bytes of Segments and Photons Outside Region */
+        if(reader->plan.geolocation)
+        {
+            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+            {
+                long region_segments = 0;
+                long region_photons = 0;
+                for(int r = 0; r < region.runs.length(); r++)
+                {
+                    region_segments += region.runs[r].num_segments[t];
+                    region_photons += region.runs[r].num_photons[t];
+                }
+                local_stats.bytes_avoided += (region.track_segments[t] - region_segments) * (SEGMENT_ROW_BYTES + VELOCITY_ROW_BYTES);
+                local_stats.bytes_avoided += (region.track_photons[t] - region_photons) * PHOTON_ROW_BYTES;
+            }
+        }
+
+        /* Initialize Track Scope Variables (runs are in along-track order) */
+        long bckgrd_rows_read[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 }; // background rates spanning runs
+        long atl08_rows_read[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 }; // ATL08 photons classifying runs
+
+        /* Size Windows of Photon Streams to Read Budget (whole runs when no budget; segment, background, and ATL08 data are read whole outside the budget) */
+        long stream_rows = H5Api::ALL_ROWS;
+        if(reader->parms->read_budget > 0)
+        {
+            long budget = ((long)reader->parms->read_budget * 0x100000) / reader->threadCount;
+            long rows = budget / (PAIR_TRACKS_PER_GROUND_TRACK * STREAM_WINDOWS * PHOTON_ROW_BYTES);
+            stream_rows = MAX(rows / PHOTON_CHUNK_ROWS, 1) * PHOTON_CHUNK_ROWS;
+        }
+
+        /* Generate Extents Run by Run */
+        for(int r = 0; reader->active && r < region.runs.length(); r++)
+        {
+            Region::run_t& run = region.runs[r];
+
+            /* Start Reading ATL03 Segment Data of Run from HDF5 File */
+            const long* velocity_rows = reader->plan.velocity ? run.num_segments : no_rows;
+            GTStream<int32_t>   segment_ph_cnt      (asset, resource, track, "geolocation/segment_ph_cnt", &reader->context, 0, run.first_segment, run.num_segments);
+            GTStream<float>     velocity_sc         (asset, resource, track, "geolocation/velocity_sc", &reader->context, H5Api::ALL_COLS, run.first_segment, velocity_rows);
+            GTStream<double>    segment_delta_time  (asset, resource, track, "geolocation/delta_time", &reader->context, 0, run.first_segment, run.num_segments);
+            GTStream<int32_t>   segment_id          (asset, resource, track, "geolocation/segment_id", &reader->context, 0, run.first_segment, run.num_segments);
+            GTStream<double>    segment_dist_x      (asset, resource, track, "geolocation/segment_dist_x", &reader->context, 0, run.first_segment, run.num_segments);
+
+            /* Count Photons of Run (known from the region when subset, otherwise from the photon counts) */
+            long run_photons[PAIR_TRACKS_PER_GROUND_TRACK] = { run.num_photons[PRT_LEFT], run.num_photons[PRT_RIGHT] };
+            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+            {
+                if(run_photons[t] == H5Api::ALL_ROWS)
+                {
+                    segment_ph_cnt.gt[t].join();
+                    run_photons[t] = 0;
+                    for(long s = 0; s < segment_ph_cnt.gt[t].size; s++)
+                    {
+                        run_photons[t] += segment_ph_cnt.gt[t][s];
+                    }
+                }
+            }
+
+            /* Split Large Runs into Ranges of Extents (generated in parallel by the reader pool) */
+            long max_ranges = MIN(MIN(ReaderPool::getConcurrency(), MAX_RANGES), (run_photons[PRT_LEFT] + run_photons[PRT_RIGHT]) / MIN_RANGE_PHOTONS);
+            bool split_run = max_ranges > 1;
+
+            /* Start Streaming Photon Data of Run from HDF5 File (only the distances when split; each range streams its own photons) */
+            PhotonStreams       photons             (info, run.first_photon, split_run ? no_rows : run_photons, stream_rows);
+            GTStream<float>     split_dist_ph_along (asset, resource, track, "heights/dist_ph_along", &reader->context, 0, run.first_photon, split_run ? run_photons : no_rows, stream_rows);
+
+            /* Find ATL08 Photons of Run (while the ATL03 reads above are in progress) */
+            long atl08_first[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 };
+            long atl08_rows[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 };
+            if(reader->plan.atl08)
+            {
+                segment_id.join();
+                atl08_ph_segment_id->join();
+                for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+                {
+                    if(segment_id.gt[t].size <= 0) continue;
+                    atl08_first[t] = atl08_ph_segment_id->gt[t].find(segment_id.gt[t][0]);
+                    atl08_rows[t] = atl08_ph_segment_id->gt[t].find(segment_id.gt[t][segment_id.gt[t].size - 1] + 1) - atl08_first[t];
+                    atl08_rows_read[t] += atl08_rows[t];
+                }
+            }
+
+            /* Find Background Rates Spanning Run (from the one before its first segment to the one after its last) */
+            long bckgrd_first[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 };
+            long bckgrd_num[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 };
+            if(reader->plan.background)
+            {
+                segment_delta_time.join();
+                bckgrd_delta_time.join();
+                for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+                {
+                    long bckgrd_size = bckgrd_delta_time.gt[t].size;
+                    if(segment_delta_time.gt[t].size <= 0 || bckgrd_size <= 0) continue;
+                    long first = bckgrd_delta_time.gt[t].find(segment_delta_time.gt[t][0]);
+                    long last = bckgrd_delta_time.gt[t].find(segment_delta_time.gt[t][segment_delta_time.gt[t].size - 1]);
+                    bckgrd_first[t] = MAX(first - 1, 0);
+                    bckgrd_num[t] = MIN(last, bckgrd_size - 1) - bckgrd_first[t] + 1;
+                    bckgrd_rows_read[t] += bckgrd_num[t];
+                }
+            }
+
+            /* Start Reading Background Rates of Run from HDF5 File */
+            GTStream<float>     bckgrd_rate         (asset, resource, track, "bckgrd_atlas/bckgrd_rate", &reader->context, 0, bckgrd_first, bckgrd_num);
+
+            /* Start Reading ATL08 Classifications of Run from HDF5 File */
+            GTStream<int32_t>   atl08_classed_pc_indx (asset, atl08_resource.getString(), track, "signal_photons/classed_pc_indx", &reader->context08, 0, atl08_first, atl08_rows);
+            GTStream<int8_t>    atl08_classed_pc_flag (asset, atl08_resource.getString(), track, "signal_photons/classed_pc_flag", &reader->context08, 0, atl08_first, atl08_rows);
+
+            /* Wait for Reads Issued Above */
+            segment_ph_cnt.join();
+            velocity_sc.join();
+            segment_delta_time.join();
+            segment_id.join();
+            segment_dist_x.join();
+            bckgrd_rate.join();
+            atl08_classed_pc_indx.join();
+            atl08_classed_pc_flag.join();
+            photons.join();
+            split_dist_ph_along.join();
+
+            /* Increment Read Statistics */
+            long run_segments = segment_ph_cnt.gt[PRT_LEFT].size + segment_ph_cnt.gt[PRT_RIGHT].size;
+            local_stats.segments_read += run_segments;
+            if(!reader->plan.geolocation) local_stats.bytes_avoided += run_segments * GEOLOCATION_ROW_BYTES;
+            if(!reader->plan.velocity) local_stats.bytes_avoided += run_segments * VELOCITY_ROW_BYTES;
+
+            /* Build Segment Tables of Run */
+            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+            {
+                long num_segments = segment_delta_time.gt[t].size;
+                if(num_segments > segment_table_size[t])
+                {
+                    delete [] background_rates[t];
+                    delete [] spacecraft_speeds[t];
+                    background_rates[t] = new double [num_segments];
+                    spacecraft_speeds[t] = new double [num_segments];
+                    segment_table_size[t] = num_segments;
+                }
+                if(reader->plan.background) interpolateBackground(background_rates[t], segment_delta_time.gt[t], bckgrd_delta_time.gt[t], bckgrd_first[t], bckgrd_rate.gt[t]);
+                if(reader->plan.velocity) calculateSpeeds(spacecraft_speeds[t], velocity_sc.gt[t], num_segments);
+            }
+
+            /* Expand ATL08 Classifications of Run */
+            if(reader->plan.atl08)
+            {
+                for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+                {
+                    if(run_photons[t] > atl08_class_size[t])
+                    {
+                        delete [] atl08_class_ph[t];
+                        atl08_class_ph[t] = new uint8_t [run_photons[t]];
+                        atl08_class_size[t] = run_photons[t];
+                    }
+                    classifyPhotons(atl08_class_ph[t], segment_ph_cnt.gt[t], segment_id.gt[t], atl08_ph_segment_id->gt[t], atl08_first[t], atl08_classed_pc_indx.gt[t], atl08_classed_pc_flag.gt[t]);
+                }
+            }
+
+            /* Share Data of Run with its Ranges */
+            Cond range_cond;
+            run_data_t data = {
+                .info = info,
+                .run = &run,
+                .segment_ph_cnt = &segment_ph_cnt,
+                .segment_id = &segment_id,
+                .segment_dist_x = &segment_dist_x,
+                .background_rates = { background_rates[PRT_LEFT], background_rates[PRT_RIGHT] },
+                .spacecraft_speeds = { spacecraft_speeds[PRT_LEFT], spacecraft_speeds[PRT_RIGHT] },
+                .atl08_class_ph = { atl08_class_ph[PRT_LEFT], atl08_class_ph[PRT_RIGHT] },
+                .stream_rows = stream_rows,
+                .range_cond = &range_cond,
+                .ranges_complete = 0
+            };
+
+            if(!split_run)
+            {
+                /* Generate All Extents of Run */
+                extent_range_t range;
+                range.data = &data;
+                initCursors(&data, range.cursor);
+                for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+                {
+                    range.first_photon[t] = 0;
+                    range.num_photons[t] = run_photons[t];
+                }
+                range.num_extents = ALL_EXTENTS;
+                generateExtents(&range, &photons, &batch, &local_stats);
+                photons.countWindows(&local_stats);
+            }
+            else
+            {
+                /* Plan Ranges of Extents */
+                extent_range_t ranges[MAX_RANGES];
+                int num_ranges = planRanges(&data, split_dist_ph_along, run_photons, ranges, max_ranges);
+
+                /* Divide Read Budget Among Ranges */
+                if(stream_rows != H5Api::ALL_ROWS)
+                {
+                    data.stream_rows = MAX(stream_rows / (num_ranges * PHOTON_CHUNK_ROWS), 1) * PHOTON_CHUNK_ROWS;
+                }
+
+                /* Submit All But First Range to Reader Pool */
+                for(int i = 1; i < num_ranges; i++)
+                {
+                    ReaderPool::submit(rangeThread, &ranges[i], &data);
+                }
+
+                /* Generate First Range, then Ranges No Worker Has Started */
+                rangeThread(&ranges[0]);
+                List<void*> withdrawn;
+                ReaderPool::withdraw(&data, &withdrawn);
+                for(int i = 0; i < withdrawn.length(); i++)
+                {
+                    rangeThread(withdrawn[i]);
+                }
+                EventLib::stashId (trace_id); // restore trace id of track
+
+                /* Wait for Ranges Generated by Workers */
+                range_cond.lock();
+                {
+                    while(data.ranges_complete < num_ranges)
+                    {
+                        range_cond.wait(0, SYS_TIMEOUT);
+                    }
+                }
+                range_cond.unlock();
+
+                /* Add Statistics of Ranges */
+                for(int i = 0; i < num_ranges; i++)
+                {
+                    local_stats.extents_filtered += ranges[i].stats.extents_filtered;
+                    local_stats.extents_sent += ranges[i].stats.extents_sent;
+                    local_stats.extents_dropped += ranges[i].stats.extents_dropped;
+                    local_stats.extents_retried += ranges[i].stats.extents_retried;
+                    local_stats.windows_read += ranges[i].stats.windows_read;
+                    local_stats.windows_waited += ranges[i].stats.windows_waited;
+                    local_stats.posts_stalled += ranges[i].stats.posts_stalled;
+                    local_stats.posts_idled += ranges[i].stats.posts_idled;
+                    local_stats.posts_queued += ranges[i].stats.posts_queued;
+                    local_stats.posts_waiting += ranges[i].stats.posts_waiting;
+                }
+            }
+        }
+
+        /* Count Bytes of Background Rates Outside Runs */
+        if(reader->plan.background)
+        {
+            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+            {
+                local_stats.bytes_avoided += (bckgrd_delta_time.gt[t].size - bckgrd_rows_read[t]) * BACKGROUND_ROW_BYTES;
+            }
+        }
+
+        /* Count Bytes of ATL08 Classifications Outside Runs */
+        if(reader->plan.atl08)
+        {
+            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+            {
+                local_stats.bytes_avoided += (atl08_ph_segment_id->gt[t].size - atl08_rows_read[t]) * ATL08_ROW_BYTES;
+            }
+        }
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Failure during processing of resource %s track %d: %s", resource, track, e.what());
+    }
+
+    /* Post Remaining Extents */
+    reader->postExtents(&batch, &local_stats);
+    if(batch.poster) batch.poster->finish(&local_stats);
+
+    /* Handle Global Reader Updates */
+    reader->threadCond.lock();
+    {
+        /* Update Statistics */
+        reader->stats.segments_read += local_stats.segments_read;
+        reader->stats.extents_filtered += local_stats.extents_filtered;
+        reader->stats.extents_sent += local_stats.extents_sent;
+        reader->stats.extents_dropped += local_stats.extents_dropped;
+        reader->stats.extents_retried += local_stats.extents_retried;
+        reader->stats.bytes_avoided += local_stats.bytes_avoided;
+        reader->stats.windows_read += local_stats.windows_read;
+        reader->stats.windows_waited += local_stats.windows_waited;
+        reader->stats.posts_stalled += local_stats.posts_stalled;
+        reader->stats.posts_idled += local_stats.posts_idled;
+        reader->stats.posts_queued += local_stats.posts_queued;
+        reader->stats.posts_waiting += local_stats.posts_waiting;
+
+        /* Count Completion */
+        reader->numComplete++;
         if(reader->numComplete == reader->threadCount)
         {
-            mlog(CRITICAL, "Completed processing resource %s", resource);
+            mlog(CRITICAL, "Completed processing resource %s", resource);
+
+            /* Flush Elevations Fit in Reader */
+            if(reader->atl06) reader->atl06->flushResults();
+
+            /* Indicate End of Data */
+            reader->outQ->postCopy("", 0);
+            reader->signalComplete();
+        }
+
+        /* Wake Destructor Waiting on Readers */
+        reader->threadCond.signal();
+    }
+    reader->threadCond.unlock();
+
+    /* Clean Up ATL08 Variables */
+    if(atl08_ph_segment_id) delete atl08_ph_segment_id;
+    delete [] atl08_class_ph[PRT_LEFT];
+    delete [] atl08_class_ph[PRT_RIGHT];
+
+    /* Clean Up Segment Tables */
+    delete [] background_rates[PRT_LEFT];
+    delete [] background_rates[PRT_RIGHT];
+    delete [] spacecraft_speeds[PRT_LEFT];
+    delete [] spacecraft_speeds[PRT_RIGHT];
+
+    /* Clean Up Extent Buffer and Posting Stage */
+    if(batch.buffer) delete [] batch.buffer;
+    if(batch.poster) delete batch.poster;
+
+    /* Clean Up Info */
+    delete [] info->resource;
+    delete info;
+
+    /* Stop Trace */
+    stop_trace(INFO, trace_id);
+
+    /* Return */
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+ * rangeThread
+ *
+ *  generates a range of extents of a run with its own photon streams and
+ *  batch; run by the reader pool, or by the thread of the track when no
+ *  worker has started it
+ *----------------------------------------------------------------------------*/
+void* Atl03Reader::rangeThread (void* parm)
+{
+    /* Get Range */
+    extent_range_t* range = (extent_range_t*)parm;
+    run_data_t* data = range->data;
+    info_t* info = data->info;
+    Atl03Reader* reader = info->reader;
+
+    /* Extent Record Being Populated (posted by a posting stage unless fit in reader) */
+    batch_t batch = { NULL, 0, 0, NULL, 0, NULL };
+    if(!reader->atl06) batch.poster = new PostStage(reader);
+
+    /* Start Trace */
+    uint32_t trace_id = start_trace(INFO, reader->traceId, "atl03_range", "{\"resource\":\"%s\", \"track\":%d}", info->resource, info->track);
+    EventLib::stashId (trace_id); // set thread specific trace id for H5Api
+
+    try
+    {
+        /* Start Streaming Photon Data of Range from HDF5 File */
+        long first_photon[PAIR_TRACKS_PER_GROUND_TRACK];
+        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+        {
+            first_photon[t] = data->run->first_photon[t] + range->first_photon[t];
+        }
+        PhotonStreams photons(info, first_photon, range->num_photons, data->stream_rows);
+        photons.join();
+
+        /* Generate Extents of Range */
+        generateExtents(range, &photons, &batch, &range->stats);
+        photons.countWindows(&range->stats);
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Failure during processing of resource %s track %d: %s", info->resource, info->track, e.what());
+    }
+
+    /* Post Remaining Extents */
+    reader->postExtents(&batch, &range->stats);
+    if(batch.poster) batch.poster->finish(&range->stats);
+    if(batch.buffer) delete [] batch.buffer;
+    if(batch.poster) delete batch.poster;
+
+    /* Count Completion (the run is freed once its last range completes) */
+    data->range_cond->lock();
+    {
+        data->ranges_complete++;
+        data->range_cond->signal();
+    }
+    data->range_cond->unlock();
+
+    /* Stop Trace */
+    stop_trace(INFO, trace_id);
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+ * initCursors
+ *
+ *  cursors at the first extent of a run (starting at the first segment of
+ *  the pair tracks with segments in the run)
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::initCursors (run_data_t* data, cursor_t* cursor)
+{
+    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+    {
+        /* Pair Tracks Not Selected or Not in Run Are Complete */
+        bool empty = !data->info->selected[t] || data->segment_dist_x->gt[t].size <= 0;
+
+        cursor[t].ph_in = 0;
+        cursor[t].seg_in = 0;
+        cursor[t].seg_ph = 0;
+        cursor[t].start_segment = 0;
+        cursor[t].start_distance = empty ? 0.0 : data->segment_dist_x->gt[t][0];
+        cursor[t].extent_segment = 0;
+        cursor[t].start_seg_portion = 0.0;
+        cursor[t].track_complete = empty;
+        cursor[t].end_ph = -1;
+        cursor[t].end_seg = 0;
+        cursor[t].end_seg_ph = 0;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * planRanges
+ *
+ *  walks the along-track distances of the photons of a run exactly as
+ *  generateExtents steps from extent to extent (without selecting photons)
+ *  and splits the extents into ranges of about the same number of photons;
+ *  each range starts at the cursors of its first extent, so the ranges
+ *  together generate the same extents as the run as a whole; returns the
+ *  number of ranges
+ *----------------------------------------------------------------------------*/
+int Atl03Reader::planRanges (run_data_t* data, GTStream<float>& dist_ph_along, const long* run_photons, extent_range_t* ranges, int max_ranges)
+{
+    info_t* info = data->info;
+    const atl06_parms_t* parms = info->reader->parms;
+    GTStream<int32_t>& segment_ph_cnt = *data->segment_ph_cnt;
+    GTStream<double>& segment_dist_x = *data->segment_dist_x;
+
+    /* Start at First Extent of Run */
+    cursor_t cursor[PAIR_TRACKS_PER_GROUND_TRACK];
+    initCursors(data, cursor);
+    long last_photon[PAIR_TRACKS_PER_GROUND_TRACK] = { 0, 0 }; // last photon visited
+    long total_photons = 0;
+    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+    {
+        if(info->selected[t]) total_photons += run_photons[t];
+    }
+
+    /* Step Through Extents of Run */
+    int num_ranges = 0;
+    long range_extent = 0; // first extent of current range
+    for(long e = 0; info->reader->active && (!cursor[PRT_LEFT].track_complete || !cursor[PRT_RIGHT].track_complete); e++)
+    {
+        /* Start Next Range Once Photons of Current Range Reach Their Share */
+        long photons_stepped = 0;
+        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+        {
+            if(info->selected[t]) photons_stepped += cursor[t].track_complete ? run_photons[t] : cursor[t].ph_in;
+        }
+        if(num_ranges < max_ranges && photons_stepped >= (total_photons * num_ranges) / max_ranges)
+        {
+            /* Complete Current Range (at the last photon its extents visit) */
+            if(num_ranges > 0)
+            {
+                extent_range_t& range = ranges[num_ranges - 1];
+                range.num_extents = e - range_extent;
+                for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+                {
+                    if(!range.cursor[t].track_complete) range.num_photons[t] = MIN(last_photon[t] + 1, run_photons[t]) - range.first_photon[t];
+                }
+            }
+
+            /* Start Range at Cursors of Extent */
+            extent_range_t& range = ranges[num_ranges++];
+            range.data = data;
+            LocalLib::set(&range.stats, 0, sizeof(stats_t));
+            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+            {
+                range.cursor[t] = cursor[t];
+                range.first_photon[t] = cursor[t].track_complete ? 0 : cursor[t].ph_in;
+                range.num_photons[t] = 0;
+            }
+            range_extent = e;
+        }
+
+        /* Release Streamed Distances Preceding Extent */
+        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+        {
+            dist_ph_along.gt[t].release(cursor[t].ph_in);
+        }
+
+        /* Step Each Pair Track to Next Extent */
+        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+        {
+            cursor_t& c = cursor[t];
+            if(c.track_complete) continue;
+
+            /* Walk Photons of Extent (reported when the extents are generated) */
+            bool segments_missing = false;
+            last_photon[t] = MAX(last_photon[t], c.ph_in);
+            int32_t end_photon = walkExtent(c, segment_ph_cnt.gt[t], segment_dist_x.gt[t], dist_ph_along.gt[t], parms, &segments_missing);
+            last_photon[t] = MAX(last_photon[t], end_photon);
+
+            /* Step Start of Extent */
+            stepStart(c, segment_dist_x.gt[t], parms);
+        }
+    }
+
+    /* Last Range Runs to End of Run */
+    if(num_ranges > 0)
+    {
+        extent_range_t& range = ranges[num_ranges - 1];
+        range.num_extents = ALL_EXTENTS;
+        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+        {
+            if(!range.cursor[t].track_complete) range.num_photons[t] = run_photons[t] - range.first_photon[t];
+        }
+    }
+
+    return num_ranges;
+}
+
+/*----------------------------------------------------------------------------
+ * generateExtents
+ *
+ *  generates the extents of a range starting at its cursors; the photon
+ *  streams and batch are those of the thread generating the range, and the
+ *  photon indices are relative to the first photons of the range
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::generateExtents (extent_range_t* range, PhotonStreams* photons, batch_t* batch, stats_t* local_stats)
+{
+    run_data_t* data = range->data;
+    info_t* info = data->info;
+    Atl03Reader* reader = info->reader;
+    const char* resource = info->resource;
+    int track = info->track;
+
+    /* Segment Data of Run */
+    GTStream<int32_t>& segment_ph_cnt = *data->segment_ph_cnt;
+    GTStream<int32_t>& segment_id = *data->segment_id;
+    GTStream<double>& segment_dist_x = *data->segment_dist_x;
+    double** background_rates = data->background_rates;
+    double** spacecraft_speeds = data->spacecraft_speeds;
+
+    /* Classifications of Range */
+    uint8_t* atl08_class_ph[PAIR_TRACKS_PER_GROUND_TRACK] = { NULL, NULL };
+    if(reader->plan.atl08)
+    {
+        atl08_class_ph[PRT_LEFT] = data->atl08_class_ph[PRT_LEFT] + range->first_photon[PRT_LEFT];
+        atl08_class_ph[PRT_RIGHT] = data->atl08_class_ph[PRT_RIGHT] + range->first_photon[PRT_RIGHT];
+    }
+
+    /* Initialize Range Scope Variables (from cursors at first extent of range) */
+    cursor_t cursor[PAIR_TRACKS_PER_GROUND_TRACK]; // photon indices relative to range
+    int32_t ph_in[PAIR_TRACKS_PER_GROUND_TRACK]; // first photon of extent (released before)
+    ExtentBuilder builder[PAIR_TRACKS_PER_GROUND_TRACK]; // reads photon data of range
+    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+    {
+        cursor[t] = range->cursor[t];
+        cursor[t].ph_in -= range->first_photon[t];
+        cursor[t].end_ph = -1; // walk of first extent starts at its first photon
+        ph_in[t] = cursor[t].ph_in;
+
+        builder[t].segment_ph_cnt = &segment_ph_cnt.gt[t];
+        builder[t].segment_dist_x = &segment_dist_x.gt[t];
+        builder[t].dist_ph_along = &photons->dist_ph_along.gt[t];
+        builder[t].h_ph = &photons->h_ph.gt[t];
+        builder[t].signal_conf_ph = &photons->signal_conf_ph.gt[t];
+        builder[t].lat_ph = &photons->lat_ph.gt[t];
+        builder[t].lon_ph = &photons->lon_ph.gt[t];
+        builder[t].delta_time = &photons->delta_time.gt[t];
+        builder[t].classes = atl08_class_ph[t];
+        builder[t].start(cursor[t]);
+    }
+
+    /* Traverse All Photons In Range */
+    for(long e = 0; reader->active && (!cursor[PRT_LEFT].track_complete || !cursor[PRT_RIGHT].track_complete) && (range->num_extents == ALL_EXTENTS || e < range->num_extents); e++)
+    {
+        bool extent_valid[PAIR_TRACKS_PER_GROUND_TRACK] = { false, false };
+
+        /* Release Streamed Photons Preceding Extent */
+        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+        {
+            ph_in[t] = cursor[t].ph_in;
+        }
+        photons->release(ph_in);
 
-            /* Indicate End of Data */
-            reader->outQ->postCopy("", 0);
-            reader->signalComplete();
+        /* Select Photons for Extent from each Track */
+        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+        {
+            /* Skip Completed Tracks */
+            if(cursor[t].track_complete)
+            {
+                builder[t].photons = 0;
+                builder[t].entries = 0;
+                continue;
+            }
+
+            /* Build Extent (moving cursor to next extent) */
+            bool segments_missing = false;
+            extent_valid[t] = builder[t].build(cursor[t], reader->parms, &segments_missing);
+            if(segments_missing)
+            {
+                mlog(ERROR, "Photons with no segments are detected is %s!", resource);
+            }
+        }
+
+        /* Create Extent Record */
+        if(extent_valid[PRT_LEFT] || extent_valid[PRT_RIGHT] || reader->parms->pass_invalid)
+        {
+            /* Calculate Extent Record Size */
+            int num_photons = builder[PRT_LEFT].photons + builder[PRT_RIGHT].photons;
+            int extent_bytes = sizeof(extent_t) + (sizeof(photon_t) * num_photons);
+
+            /* Allocate and Initialize Extent */
+            extent_t* extent = reader->allocExtent(batch, extent_bytes, local_stats);
+            extent->reference_pair_track = track;
+            extent->spacecraft_orientation = (*reader->sc_orient)[0];
+            extent->reference_ground_track_start = (*reader->start_rgt)[0];
+            extent->cycle_start = (*reader->start_cycle)[0];
+
+            /* Populate Extent */
+            uint32_t ph_out = 0;
+            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+            {
+                /* Leave Pair Track Not Selected or Not in Run Empty */
+                if(!info->selected[t] || segment_id.gt[t].size <= 0)
+                {
+                    extent->valid[t]                = false;
+                    extent->segment_id[t]           = 0;
+                    extent->extent_length[t]        = reader->parms->extent_length;
+                    extent->spacecraft_velocity[t]  = 0.0;
+                    extent->background_rate[t]      = 0.0;
+                    extent->photon_count[t]         = 0;
+                    continue;
+                }
+
+                /* Look Up Background Rate and Spacecraft Velocity (when read) */
+                double background_rate = reader->plan.background ? background_rates[t][cursor[t].extent_segment] : 0.0;
+                double spacecraft_velocity = reader->plan.velocity ? spacecraft_speeds[t][cursor[t].extent_segment] : 0.0;
+
+                /* Calculate Segment ID (attempt to arrive at closest ATL06 segment ID represented by extent) */
+                double atl06_segment_id = (double)segment_id.gt[t][cursor[t].extent_segment];       // start with first segment in extent
+                atl06_segment_id += cursor[t].start_seg_portion;                                    // add portion of first segment that first photon is included
+                atl06_segment_id += (reader->parms->extent_length / ATL03_SEGMENT_LENGTH) / 2.0;    // add half the left of the extent
+
+                /* Populate Attributes */
+                extent->valid[t]                = extent_valid[t];
+                extent->segment_id[t]           = (uint32_t)(atl06_segment_id + 0.5);
+                extent->extent_length[t]        = reader->parms->extent_length;
+                extent->spacecraft_velocity[t]  = spacecraft_velocity;
+                extent->background_rate[t]      = background_rate;
+                extent->photon_count[t]         = builder[t].photons;
+
+                /* Populate Photons (from view of window spanned by extent) */
+                for(int32_t i = 0; i < builder[t].entries; i++)
+                {
+                    if(builder[t].window[i].in_extent)
+                    {
+                        extent->photons[ph_out++] = builder[t].window[i].photon;
+                    }
+                }
+            }
+
+            /* Set Photon Pointer Fields (pointers are set to offset from start of record data) */
+            extent->photon_offset[PRT_LEFT] = batch->size + sizeof(extent_t);
+            extent->photon_offset[PRT_RIGHT] = batch->size + sizeof(extent_t) + (sizeof(photon_t) * extent->photon_count[PRT_LEFT]);
+
+            /* Send Extent */
+            reader->sendExtent(batch, local_stats);
+        }
+        else // neither pair in extent valid
+        {
+            local_stats->extents_filtered++;
         }
+
     }
-    reader->threadMut.unlock();
+}
 
-    /* Clean Up ATL08 Variables */
-    if(atl08_ph_segment_id) delete atl08_ph_segment_id;
-    if(atl08_classed_pc_indx) delete atl08_classed_pc_indx;
-    if(atl08_classed_pc_flag) delete atl08_classed_pc_flag;
+/*----------------------------------------------------------------------------
+ * walkExtent
+ *
+ *  walks the photons of an extent of a pair track to find the first photon
+ *  of the next extent (the first at or beyond the extent step) and the end
+ *  of the extent (the first photon at or beyond the extent length), moving
+ *  the cursor to the next extent; the photons are walked in order and the
+ *  walk stops at the later of the two, so the photons before the photon
+ *  returned (or the end of the pair track, which completes it) are those
+ *  the extent visits; as the start of the extent only moves forward, the
+ *  end of the next extent is no earlier than the end of this one, and the
+ *  walk to it resumes there - so each photon is walked about twice however
+ *  much the extents overlap
+ *----------------------------------------------------------------------------*/
+int32_t Atl03Reader::walkExtent (cursor_t& c, GTStream<int32_t>::Track& segment_ph_cnt, GTStream<double>::Track& segment_dist_x, GTStream<float>::Track& dist_ph_along, const atl06_parms_t* parms, bool* segments_missing)
+{
+    /* Set Extent Segment */
+    c.extent_segment = c.seg_in;
+    c.start_seg_portion = dist_ph_along[c.ph_in] / ATL03_SEGMENT_LENGTH;
+
+    /* Find First Photon of Next Extent */
+    int32_t step_ph = c.ph_in;
+    int32_t step_seg = c.seg_in;
+    int32_t step_seg_ph = c.seg_ph;
+    walk_t step = findPhoton(step_ph, step_seg, step_seg_ph, parms->extent_step, c.start_distance, segment_ph_cnt, segment_dist_x, dist_ph_along);
+
+    /* Find End of Extent (resuming at end of previous extent) */
+    if(c.end_ph < c.ph_in)
+    {
+        c.end_ph = c.ph_in;
+        c.end_seg = c.seg_in;
+        c.end_seg_ph = c.seg_ph;
+    }
+    walk_t end = findPhoton(c.end_ph, c.end_seg, c.end_seg_ph, parms->extent_length, c.start_distance, segment_ph_cnt, segment_dist_x, dist_ph_along);
 
-    /* Clean Up Info */
-    delete [] info->resource;
-    delete info;
+    /* Determine Photons Visited */
+    int32_t end_photon;
+    if(step == PHOTON_FOUND && end == PHOTON_FOUND)
+    {
+        end_photon = MAX(step_ph, c.end_ph) + 1;
+        if(end_photon >= dist_ph_along.size) c.track_complete = true;
+    }
+    else
+    {
+        /* Photons Ran Out (at the photon without a segment when segments ran out) */
+        if(step == OUT_OF_SEGMENTS)     end_photon = step_ph;
+        else if(end == OUT_OF_SEGMENTS) end_photon = c.end_ph;
+        else                            end_photon = dist_ph_along.size;
+        *segments_missing = (step == OUT_OF_SEGMENTS) || (end == OUT_OF_SEGMENTS);
+        c.track_complete = true;
+    }
 
-    /* Stop Trace */
-    stop_trace(INFO, trace_id);
+    /* Set Next Extent's First Photon */
+    if(step == PHOTON_FOUND)
+    {
+        c.ph_in = step_ph;
+        c.seg_in = step_seg;
+        c.seg_ph = step_seg_ph;
+    }
+
+    return end_photon;
+}
+
+/*----------------------------------------------------------------------------
+ * findPhoton
+ *
+ *  walks the photons of a pair track from the photon given (along with its
+ *  segment and the photons of the segment preceding it) to the first photon
+ *  whose along-track distance from the start distance is at least the
+ *  distance given, leaving the photon, segment, and photons preceding it in
+ *  the segment at that photon; when the photons or segments run out first
+ *  they are left at the photon that could not be walked
+ *----------------------------------------------------------------------------*/
+Atl03Reader::walk_t Atl03Reader::findPhoton (int32_t& photon, int32_t& segment, int32_t& seg_ph, double distance, double start_distance, GTStream<int32_t>::Track& segment_ph_cnt, GTStream<double>::Track& segment_dist_x, GTStream<float>::Track& dist_ph_along)
+{
+    while(photon < dist_ph_along.size)
+    {
+        /* Go to Photon's Segment */
+        int32_t current_segment = segment;
+        int32_t current_count = seg_ph + 1;
+        while((current_count > segment_ph_cnt[current_segment]) &&
+              (current_segment < segment_dist_x.size) )
+        {
+            current_count = 1; // reset photons in segment
+            current_segment++; // go to next segment
+        }
+
+        /* Check Current Segment */
+        if(current_segment >= segment_dist_x.size)
+        {
+            return OUT_OF_SEGMENTS;
+        }
+
+        /* Update Along Track Distance */
+        double delta_distance = segment_dist_x[current_segment] - start_distance;
+        double along_track_distance = delta_distance + dist_ph_along[photon];
+
+        /* Check Photon */
+        segment = current_segment;
+        if(along_track_distance >= distance)
+        {
+            seg_ph = current_count - 1;
+            return PHOTON_FOUND;
+        }
+
+        /* Go to Next Photon */
+        seg_ph = current_count;
+        photon++;
+    }
+
+    return OUT_OF_PHOTONS;
+}
+
+/*----------------------------------------------------------------------------
+ * stepStart
+ *
+ *  moves the start of the extent of a cursor forward by the extent step,
+ *  correcting for the distance between segments; should the correction
+ *  move the start back, the end of the previous extent is no longer a
+ *  bound on the end of the next one and its walk restarts
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::stepStart (cursor_t& c, GTStream<double>::Track& segment_dist_x, const atl06_parms_t* parms)
+{
+    double previous_distance = c.start_distance;
+
+    /* Add Step to Start Distance */
+    c.start_distance += parms->extent_step;
+
+    /* Apply Segment Distance Correction and Update Start Segment */
+    while( ((c.start_segment + 1) < segment_dist_x.size) &&
+            (c.start_distance >= segment_dist_x[c.start_segment + 1]) )
+    {
+        c.start_distance += segment_dist_x[c.start_segment + 1] - segment_dist_x[c.start_segment];
+        c.start_distance -= ATL03_SEGMENT_LENGTH;
+        c.start_segment++;
+    }
+
+    /* Restart Walk to End of Extent */
+    if(c.start_distance < previous_distance)
+    {
+        c.end_ph = -1;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * interpolateBackground
+ *
+ *  interpolates the background rate at the time of each segment of a run
+ *  from the background rates before and after it (bckgrd_rate holds the
+ *  rows of bckgrd_delta_time starting at first_row); segments before the
+ *  first background rate use the first and segments after the last use the
+ *  last; the segments and background rates are both in time order, so a
+ *  single merge walk covers the run
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::interpolateBackground (double* rates, GTStream<double>::Track& segment_delta_time, GTStream<double>::Track& bckgrd_delta_time, long first_row, GTStream<float>::Track& bckgrd_rate)
+{
+    long num_segments = segment_delta_time.size;
+    long num_rows = bckgrd_rate.size;
+    if(num_rows <= 0)
+    {
+        for(long s = 0; s < num_segments; s++) rates[s] = 0.0;
+        return;
+    }
+
+    long row = 0; // first background rate at or after segment
+    for(long s = 0; s < num_segments; s++)
+    {
+        double segment_time = segment_delta_time[s];
+        while(row < num_rows && bckgrd_delta_time[first_row + row] < segment_time)
+        {
+            row++;
+        }
+
+        if(row >= num_rows)
+        {
+            /* Use Last Background Rate (no interpolation) */
+            rates[s] = bckgrd_rate[num_rows - 1];
+        }
+        else if(first_row + row == 0)
+        {
+            /* Use First Background Rate (no interpolation) */
+            rates[s] = bckgrd_rate[0];
+        }
+        else
+        {
+            /* Interpolate Background Rate */
+            double prev_bckgrd_time = bckgrd_delta_time[first_row + row - 1];
+            double curr_bckgrd_time = bckgrd_delta_time[first_row + row];
+            double prev_bckgrd_rate = bckgrd_rate[row - 1];
+            double curr_bckgrd_rate = bckgrd_rate[row];
+
+            double bckgrd_run = curr_bckgrd_time - prev_bckgrd_time;
+            double bckgrd_rise = curr_bckgrd_rate - prev_bckgrd_rate;
+            double segment_to_bckgrd_delta = segment_time - prev_bckgrd_time;
+
+            rates[s] = ((bckgrd_rise / bckgrd_run) * segment_to_bckgrd_delta) + prev_bckgrd_rate;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * calculateSpeeds
+ *
+ *  magnitude of the spacecraft velocity at each segment of a run
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::calculateSpeeds (double* speeds, GTStream<float>::Track& velocity_sc, long num_segments)
+{
+    for(long s = 0; s < num_segments; s++)
+    {
+        double sc_v1 = velocity_sc[(s * 3) + 0];
+        double sc_v2 = velocity_sc[(s * 3) + 1];
+        double sc_v3 = velocity_sc[(s * 3) + 2];
+        speeds[s] = sqrt((sc_v1*sc_v1) + (sc_v2*sc_v2) + (sc_v3*sc_v3));
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * selectPhotons
+ *
+ *  returns a bit per photon of a block (bit zero for the first photon) set
+ *  when the photon passes the signal confidence and, when classes are
+ *  provided, the ATL08 classification filters; the filters are applied to
+ *  the whole block without branching
+ *----------------------------------------------------------------------------*/
+uint64_t Atl03Reader::selectPhotons (GTStream<int8_t>::Track& signal_conf_ph, const uint8_t* classes, const atl06_parms_t* parms, long first_photon, int num_photons)
+{
+    int8_t cnf[SELECTION_BLOCK_PHOTONS];
+    uint8_t accept[SELECTION_BLOCK_PHOTONS];
+
+    /* Gather Block */
+    for(int i = 0; i < num_photons; i++)
+    {
+        cnf[i] = signal_conf_ph[first_photon + i];
+    }
+
+    /* Check Signal Confidence Level */
+    for(int i = 0; i < num_photons; i++)
+    {
+        accept[i] = cnf[i] >= parms->signal_confidence;
+    }
+
+    /* Check ATL08 Classification */
+    if(classes)
+    {
+        for(int i = 0; i < num_photons; i++)
+        {
+            accept[i] &= parms->atl08_class[classes[first_photon + i]];
+        }
+    }
+
+    /* Pack Block */
+    uint64_t selection = 0;
+    for(int i = 0; i < num_photons; i++)
+    {
+        selection |= (uint64_t)accept[i] << i;
+    }
+    return selection;
+}
+
+/*----------------------------------------------------------------------------
+ * classifyPhotons
+ *
+ *  expands the ATL08 classifications of the photons of a run into a class
+ *  per photon (ATL08_UNCLASSIFIED when not classified by ATL08); the ATL08
+ *  photons are ordered by segment id and by index within the segment, so a
+ *  single merge walk over the ATL08 photons of the run (starting at
+ *  first_row of ph_segment_id) covers the run
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::classifyPhotons (uint8_t* classes, GTStream<int32_t>::Track& segment_ph_cnt, GTStream<int32_t>::Track& segment_id,
+                                   GTStream<int32_t>::Track& ph_segment_id, long first_row, GTStream<int32_t>::Track& classed_pc_indx, GTStream<int8_t>::Track& classed_pc_flag)
+{
+    long photon = 0; // first photon of segment
+    long in = 0; // ATL08 photon of run
+    for(long s = 0; s < segment_ph_cnt.size; s++)
+    {
+        int32_t ph_cnt = segment_ph_cnt[s];
+        LocalLib::set(&classes[photon], ATL08_UNCLASSIFIED, ph_cnt);
+
+        /* Go To Segment */
+        while(in < classed_pc_indx.size && ph_segment_id[first_row + in] < segment_id[s])
+        {
+            in++;
+        }
+
+        /* Classify Photons of Segment (indices start at one, the first classification of a photon is used) */
+        int32_t last_pc = 0;
+        while(in < classed_pc_indx.size && ph_segment_id[first_row + in] == segment_id[s])
+        {
+            int32_t pc = classed_pc_indx[in];
+            if(pc > last_pc && pc <= ph_cnt)
+            {
+                int8_t classification = classed_pc_flag[in];
+                if(classification < 0 || classification >= NUM_ATL08_CLASSES)
+                {
+                    throw RunTimeException(CRITICAL, "invalid atl08 classification: %d", classification);
+                }
+                classes[photon + pc - 1] = classification;
+                last_pc = pc;
+            }
+            in++;
+        }
+
+        photon += ph_cnt;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * allocExtent
+ *
+ *  returns an extent of the requested size inside the record being populated;
+ *  when batching, the current batch is posted first if the extent does not fit
+ *----------------------------------------------------------------------------*/
+Atl03Reader::extent_t* Atl03Reader::allocExtent (batch_t* batch, int extent_bytes, stats_t* local_stats)
+{
+    if(atl06)
+    {
+        /* Grow Extent Buffer (reused for every extent fit in reader) */
+        if(extent_bytes > batch->buffer_size)
+        {
+            if(batch->buffer) delete [] batch->buffer;
+            batch->buffer_size = MAX(extent_bytes, 2 * batch->buffer_size);
+            batch->buffer = new unsigned char [batch->buffer_size];
+        }
+
+        /* Clear Extent Header */
+        extent_t* extent = (extent_t*)batch->buffer;
+        LocalLib::set(extent, 0, sizeof(extent_t));
+        return extent;
+    }
+    else if(parms->extent_batch <= 1)
+    {
+        /* Allocate Individual Extent Record (photons are fully written by caller so only the header is cleared) */
+        batch->record = new RecordObject(exRecType, extent_bytes, false);
+        batch->size = 0;
+    }
+    else
+    {
+        /* Post Batch if Extent Does Not Fit */
+        if(batch->record && (batch->size + extent_bytes) > batch->record->getAllocatedDataSize())
+        {
+            postExtents(batch, local_stats);
+        }
+
+        /* Allocate Batch Record */
+        if(!batch->record)
+        {
+            int batch_bytes = MAX(BATCH_RECORD_SIZE, (int)sizeof(extent_batch_t) + extent_bytes);
+            batch->record = new RecordObject(batchRecType, batch_bytes, false);
+            batch->size = sizeof(extent_batch_t);
+            batch->count = 0;
+
+            /* Populate Shared Header */
+            extent_batch_t* extent_batch = (extent_batch_t*)batch->record->getRecordData();
+            LocalLib::set(extent_batch, 0, sizeof(extent_batch_t));
+            extent_batch->spacecraft_orientation = (*sc_orient)[0];
+            extent_batch->reference_ground_track_start = (*start_rgt)[0];
+            extent_batch->cycle_start = (*start_cycle)[0];
+        }
+    }
+
+    /* Clear Extent Header */
+    extent_t* extent = (extent_t*)(batch->record->getRecordData() + batch->size);
+    LocalLib::set(extent, 0, sizeof(extent_t));
+    return extent;
+}
+
+/*----------------------------------------------------------------------------
+ * sendExtent
+ *
+ *  adds the most recently allocated extent to the record being populated and
+ *  posts the record once it is full
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::sendExtent (batch_t* batch, stats_t* local_stats)
+{
+    /* Fit Extent in Reader */
+    if(atl06)
+    {
+        atl06->processExtent((extent_t*)batch->buffer);
+        local_stats->extents_sent++;
+        return;
+    }
+
+    extent_t* extent = (extent_t*)(batch->record->getRecordData() + batch->size);
+    int extent_bytes = sizeof(extent_t) + (sizeof(photon_t) * (extent->photon_count[PRT_LEFT] + extent->photon_count[PRT_RIGHT]));
+
+    /* Add Extent to Batch */
+    if(parms->extent_batch > 1)
+    {
+        extent_batch_t* extent_batch = (extent_batch_t*)batch->record->getRecordData();
+        extent_batch->reference_pair_track = extent->reference_pair_track;
+        extent_batch->extent_offset[batch->count] = batch->size;
+        extent_batch->extent_count = batch->count + 1;
+    }
+
+    /* Update Batch */
+    batch->count++;
+    batch->size += extent_bytes;
+
+    /* Post Full Batch */
+    if(batch->count >= MIN(parms->extent_batch, MAX_EXTENTS_PER_BATCH))
+    {
+        postExtents(batch, local_stats);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * postExtents
+ *
+ *  serializes the record being populated and hands it to the posting stage
+ *  of the batch (or posts it directly when there is none)
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::postExtents (batch_t* batch, stats_t* local_stats)
+{
+    if(!batch->record) return;
+
+    /* Serialize Record (ownership of record memory is passed to the queue) */
+    uint8_t* rec_buf = NULL;
+    int rec_bytes = batch->record->serialize(&rec_buf, RecordObject::TAKE_OWNERSHIP);
+    rec_bytes -= batch->record->getAllocatedDataSize() - batch->size; // only post populated extents
+
+    /* Post Record */
+    if(batch->poster) batch->poster->post(rec_buf, rec_bytes, batch->count, local_stats);
+    else postRecord(rec_buf, rec_bytes, batch->count, local_stats);
+
+    /* Reset Batch */
+    delete batch->record;
+    batch->record = NULL;
+    batch->count = 0;
+    batch->size = 0;
+}
+
+/*----------------------------------------------------------------------------
+ * postRecord
+ *
+ *  posts a serialized record to the output queue, retrying while the queue
+ *  is full; the record memory is freed when the queue does not take it
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::postRecord (unsigned char* rec_buf, int rec_bytes, int count, stats_t* local_stats)
+{
+    /* Post Record */
+    int post_status = MsgQ::STATE_TIMEOUT;
+    if(count > 0)
+    {
+        while(active && (post_status = outQ->postRef(rec_buf, rec_bytes, SYS_TIMEOUT)) == MsgQ::STATE_TIMEOUT)
+        {
+            local_stats->extents_retried++;
+        }
+    }
+
+    /* Update Statistics */
+    if(post_status > 0)
+    {
+        local_stats->extents_sent += count;
+    }
+    else
+    {
+        if(count > 0) mlog(ERROR, "Atl03 reader failed to post to stream %s: %d", outQ->getName(), post_status);
+        local_stats->extents_dropped += count;
+        delete [] rec_buf; // record memory not taken by queue
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * wakePoster
+ *
+ *  called after queuing records; the poster sets its flag before checking
+ *  the queues of the stages and a stage checks the flag after queuing, so
+ *  either the poster sees the record or it is signaled once asleep (it
+ *  holds the lock from its check until it waits)
+ *----------------------------------------------------------------------------*/
+void Atl03Reader::wakePoster (void)
+{
+    if(posterAsleep.load())
+    {
+        postCond.lock();
+        {
+            postCond.signal(RECORD_SIG);
+        }
+        postCond.unlock();
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * postThread
+ *
+ *  posts the records queued by the posting stages of the reader, visiting
+ *  the stages in turn, until the reader stops it
+ *----------------------------------------------------------------------------*/
+void* Atl03Reader::postThread (void* parm)
+{
+    Atl03Reader* reader = (Atl03Reader*)parm;
+
+    reader->postCond.lock();
+    {
+        while(reader->posting)
+        {
+            /* Post Records of Each Stage (stages can be added and removed while posting) */
+            bool posted = false;
+            for(int i = 0; i < reader->postStages.length(); i++)
+            {
+                if(reader->postStages[i]->drain()) posted = true;
+            }
+
+            /* Wait for Records */
+            if(!posted)
+            {
+                reader->posterAsleep = true;
+                bool waiting = false;
+                for(int i = 0; i < reader->postStages.length(); i++)
+                {
+                    if(reader->postStages[i]->waiting()) waiting = true;
+                }
+                if(!waiting && reader->posting)
+                {
+                    reader->postCond.wait(RECORD_SIG, SYS_TIMEOUT);
+                }
+                reader->posterAsleep = false;
+            }
+        }
+    }
+    reader->postCond.unlock();
 
-    /* Return */
     return NULL;
 }
 
@@ -794,6 +2644,10 @@ int Atl03Reader::luaParms (lua_State* L)
         LuaEngine::setAttrInt(L, LUA_PARM_MIN_PHOTON_COUNT,     lua_obj->parms->minimum_photon_count);
         LuaEngine::setAttrNum(L, LUA_PARM_EXTENT_LENGTH,        lua_obj->parms->extent_length);
         LuaEngine::setAttrNum(L, LUA_PARM_EXTENT_STEP,          lua_obj->parms->extent_step);
+        LuaEngine::setAttrInt(L, LUA_PARM_EXTENT_BATCH,         lua_obj->parms->extent_batch);
+        LuaEngine::setAttrInt(L, LUA_PARM_POLYGON_STRIDE,       lua_obj->parms->polygon_stride);
+        LuaEngine::setAttrInt(L, LUA_PARM_READ_BUDGET,          lua_obj->parms->read_budget);
+        LuaEngine::setAttrInt(L, LUA_PARM_CONSUMER,             lua_obj->parms->consumer);
 
         /* Set Success */
         status = true;
@@ -839,6 +2693,13 @@ int Atl03Reader::luaStats (lua_State* L)
         LuaEngine::setAttrInt(L, LUA_STAT_EXTENTS_SENT,         lua_obj->stats.extents_sent);
         LuaEngine::setAttrInt(L, LUA_STAT_EXTENTS_DROPPED,      lua_obj->stats.extents_dropped);
         LuaEngine::setAttrInt(L, LUA_STAT_EXTENTS_RETRIED,      lua_obj->stats.extents_retried);
+        LuaEngine::setAttrInt(L, LUA_STAT_BYTES_AVOIDED,        lua_obj->stats.bytes_avoided);
+        LuaEngine::setAttrInt(L, LUA_STAT_WINDOWS_READ,         lua_obj->stats.windows_read);
+        LuaEngine::setAttrInt(L, LUA_STAT_WINDOWS_WAITED,       lua_obj->stats.windows_waited);
+        LuaEngine::setAttrInt(L, LUA_STAT_POSTS_STALLED,        lua_obj->stats.posts_stalled);
+        LuaEngine::setAttrInt(L, LUA_STAT_POSTS_IDLED,          lua_obj->stats.posts_idled);
+        LuaEngine::setAttrInt(L, LUA_STAT_POSTS_QUEUED,         lua_obj->stats.posts_queued);
+        LuaEngine::setAttrInt(L, LUA_STAT_POSTS_WAITING,        lua_obj->stats.posts_waiting);
 
         /* Clear if Requested */
         if(with_clear) LocalLib::set(&lua_obj->stats, 0, sizeof(lua_obj->stats));
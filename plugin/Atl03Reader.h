@@ -42,11 +42,21 @@
 #include "LuaObject.h"
 #include "RecordObject.h"
 #include "MsgQ.h"
+#include "MathLib.h"
 #include "OsApi.h"
 
 #include "GTArray.h"
+#include "GTStream.h"
+#include "SpscQueue.h"
+#include "Atl03Indexer.h"
 #include "lua_parms.h"
 
+/******************************************************************************
+ * FORWARD DECLARATIONS
+ ******************************************************************************/
+
+class Atl06Dispatch;
+
 /******************************************************************************
  * ATL03 READER
  ******************************************************************************/
@@ -55,6 +65,12 @@ class Atl03Reader: public LuaObject
 {
     public:
 
+        /*--------------------------------------------------------------------
+         * Constants
+         *--------------------------------------------------------------------*/
+
+        static const int MAX_EXTENTS_PER_BATCH = 256;
+
         /*--------------------------------------------------------------------
          * Types
          *--------------------------------------------------------------------*/
@@ -86,6 +102,17 @@ class Atl03Reader: public LuaObject
             photon_t        photons[]; // zero length field
         } extent_t;
 
+        /* Extent Batch Record */
+        typedef struct {
+            uint8_t         reference_pair_track; // 1, 2, or 3
+            uint8_t         spacecraft_orientation; // sc_orient_t
+            uint16_t        reference_ground_track_start;
+            uint16_t        cycle_start;
+            uint16_t        extent_count;
+            uint32_t        extent_offset[MAX_EXTENTS_PER_BATCH]; // offset from start of record data
+            uint8_t         extents[]; // zero length field
+        } extent_batch_t;
+
         /* Statistics */
         typedef struct {
             uint32_t segments_read;
@@ -93,6 +120,13 @@ class Atl03Reader: public LuaObject
             uint32_t extents_sent;
             uint32_t extents_dropped;
             uint32_t extents_retried;
+            uint64_t bytes_avoided;
+            uint32_t windows_read;      // photon windows read ahead of extent generation
+            uint32_t windows_waited;    // photon windows extent generation waited on
+            uint32_t posts_stalled;     // records extent generation waited to queue (posting behind)
+            uint32_t posts_idled;       // times posting ran out of records (extent generation behind)
+            uint32_t posts_queued;      // records queued for posting
+            uint64_t posts_waiting;     // records already waiting to be posted when each record was queued (occupancy)
         } stats_t;
 
         /*--------------------------------------------------------------------
@@ -105,6 +139,9 @@ class Atl03Reader: public LuaObject
         static const char* exRecType;
         static const RecordObject::fieldDef_t exRecDef[];
 
+        static const char* batchRecType;
+        static const RecordObject::fieldDef_t batchRecDef[];
+
         static const char* OBJECT_TYPE;
 
         static const char* LuaMetaName;
@@ -116,6 +153,7 @@ class Atl03Reader: public LuaObject
 
         static int  luaCreate   (lua_State* L);
         static void init        (void);
+        static int  getSpot     (sc_orient_t sc_orient, track_t track, int pair_track);
 
     private:
 
@@ -128,44 +166,283 @@ class Atl03Reader: public LuaObject
             const Asset*    asset;
             const char*     resource;
             int             track;
+            bool            selected[PAIR_TRACKS_PER_GROUND_TRACK]; // pair tracks read (beams and spots)
         } info_t;
 
+        class PostStage;
+
+        /* Extent Record Being Populated */
+        typedef struct {
+            RecordObject*   record; // atl03rec or atl03rec.batch
+            int             count;  // number of extents in record
+            int             size;   // bytes of record data used
+            unsigned char*  buffer; // extent memory when fitting in reader (no record)
+            int             buffer_size;
+            PostStage*      poster; // posts records when not fitting in reader
+        } batch_t;
+
+        /* Datasets Needed by Request */
+        typedef struct {
+            bool            geolocation;    // reference_photon_lat/lon (polygon subsetting)
+            bool            velocity;       // velocity_sc
+            bool            background;     // bckgrd_atlas
+            bool            atl08;          // ATL08 signal_photons
+        } read_plan_t;
+
         /* Region Subclass */
         class Region
         {
             public:
 
+                /* Segments and Photons of a Contiguous Run Through the Polygon */
+                typedef struct {
+                    long            first_segment[PAIR_TRACKS_PER_GROUND_TRACK];
+                    long            num_segments[PAIR_TRACKS_PER_GROUND_TRACK];
+                    long            first_photon[PAIR_TRACKS_PER_GROUND_TRACK];
+                    long            num_photons[PAIR_TRACKS_PER_GROUND_TRACK];
+                } run_t;
+
                 Region  (info_t* info, H5Api::context_t* context);
                 ~Region (void);
 
-                GTArray<double>     segment_lat;
-                GTArray<double>     segment_lon;
-                GTArray<int32_t>    segment_ph_cnt;
+                List<run_t>         runs; // in along-track order, pair tracks matched by along-track span
+                long                track_segments[PAIR_TRACKS_PER_GROUND_TRACK]; // ALL_ROWS when not subset
+                long                track_photons[PAIR_TRACKS_PER_GROUND_TRACK]; // ALL_ROWS when not subset
+
+            private:
+
+                /* Run of a Single Pair Track */
+                typedef struct {
+                    long            first_segment;
+                    long            num_segments;
+                    long            first_photon;
+                    long            num_photons;
+                } range_t;
+
+                bool                selected[PAIR_TRACKS_PER_GROUND_TRACK];
+                List<range_t>       ranges[PAIR_TRACKS_PER_GROUND_TRACK];
+                bool                in_range[PAIR_TRACKS_PER_GROUND_TRACK];
+                range_t             range[PAIR_TRACKS_PER_GROUND_TRACK]; // range being built
+                long                photon_index[PAIR_TRACKS_PER_GROUND_TRACK]; // first photon of next segment added
+
+                void                subsetByScan    (info_t* info, H5Api::context_t* context);
+                void                subsetBySidecar (info_t* info, H5Api::context_t* context, Atl03Indexer::sidecar_t** sidecar);
+                void                subsetByBisection (info_t* info, H5Api::context_t* context);
+                bool                sampleInclusion (info_t* info, H5Api::context_t* context, int t, long segment, MathLib::proj_t projection);
+                void                addSegment      (int t, long segment, bool inclusion, int32_t ph_cnt);
+                void                endTrack        (int t, long num_segments);
+                void                matchRanges     (info_t* info, H5Api::context_t* context);
+                int32_t             segmentId       (info_t* info, H5Api::context_t* context, int t, long segment);
+                void                selectedRows    (long* rows);
+                int                 referenceTrack  (void);
+
+                static MathLib::proj_t      selectProjection    (double latitude);
+        };
+
+        /* Photon Window Subclass */
+        class PhotonWindow
+        {
+            public:
+
+                typedef struct {
+                    int32_t         index;          // photon index into heights datasets
+                    bool            in_extent;      // set when extent is built
+                    double          segment_dist_x; // along-track distance of photon's segment
+                    float           dist_ph_along;  // along-track distance of photon within segment
+                    photon_t        photon;         // distance is populated when extent is built
+                } entry_t;
+
+                PhotonWindow    (void);
+                ~PhotonWindow   (void);
+
+                void                add         (const entry_t& entry);
+                void                trim        (int32_t first_index);
+                int                 length      (void);
+                entry_t&            operator[]  (int i);
+
+            private:
 
-                long                first_segment[PAIR_TRACKS_PER_GROUND_TRACK];
-                long                num_segments[PAIR_TRACKS_PER_GROUND_TRACK];
-                long                first_photon[PAIR_TRACKS_PER_GROUND_TRACK];
-                long                num_photons[PAIR_TRACKS_PER_GROUND_TRACK];
+                static const int    INITIAL_SIZE = 1024; // must be a power of two
+
+                entry_t*            ring;
+                int                 size;
+                int                 head;
+                int                 count;
+        };
+
+        /* Photon Streams Subclass */
+        class PhotonStreams
+        {
+            public:
+
+                PhotonStreams   (info_t* info, const long* first_photon, const long* num_photons, long stream_rows);
+                ~PhotonStreams  (void);
+
+                void                join        (void);
+                void                release     (const int32_t* ph_in);
+                void                countWindows (stats_t* local_stats);
+
+                GTStream<float>     dist_ph_along;
+                GTStream<float>     h_ph;
+                GTStream<int8_t>    signal_conf_ph;
+                GTStream<double>    lat_ph;
+                GTStream<double>    lon_ph;
+                GTStream<double>    delta_time;
+        };
+
+        /* Posting Stage Subclass (queues the records of a thread generating extents for the poster of the reader) */
+        class PostStage
+        {
+            public:
+
+                PostStage   (Atl03Reader* _reader);
+                ~PostStage  (void);
+
+                void                post        (unsigned char* buffer, int size, int count, stats_t* local_stats);
+                void                finish      (stats_t* local_stats);
+                bool                drain       (void);
+                bool                waiting     (void);
+
+            private:
+
+                typedef struct {
+                    unsigned char*  buffer;     // serialized record
+                    int             size;
+                    int             count;      // extents in record
+                } post_t;
+
+                void                complete    (void);
+
+                Atl03Reader*        reader;
+                SpscQueue<post_t>   queue;
+                long                pushed;     // records queued (by the thread generating extents)
+                long                posted;     // records posted (protected by postCond of reader)
+                stats_t             stats;      // of records posted (protected by postCond of reader)
+        };
+
+        /* Extent Generation at the Start of an Extent (of a pair track) */
+        typedef struct {
+            int32_t         ph_in;              // first photon of extent (index into run)
+            int32_t         seg_in;             // segment of first photon
+            int32_t         seg_ph;             // photons of segment preceding first photon
+            int32_t         start_segment;
+            double          start_distance;
+            int32_t         extent_segment;     // first segment of extent (kept once pair track completes)
+            double          start_seg_portion;
+            bool            track_complete;
+            int32_t         end_ph;             // first photon beyond previous extent (walk resumes there, negative when not known)
+            int32_t         end_seg;
+            int32_t         end_seg_ph;
+        } cursor_t;
+
+        /* Result of Walking Photons */
+        typedef enum {
+            PHOTON_FOUND,
+            OUT_OF_PHOTONS,
+            OUT_OF_SEGMENTS
+        } walk_t;
+
+        /* Extent Builder Subclass (selects the photons of each extent of a pair track in turn) */
+        class ExtentBuilder
+        {
+            public:
+
+                ExtentBuilder   (void);
+                ~ExtentBuilder  (void);
+
+                void                start       (const cursor_t& c);
+                bool                build       (cursor_t& c, const atl06_parms_t* parms, bool* segments_missing);
+
+                GTStream<int32_t>::Track*   segment_ph_cnt;
+                GTStream<double>::Track*    segment_dist_x;
+                GTStream<float>::Track*     dist_ph_along;
+                GTStream<float>::Track*     h_ph;
+                GTStream<int8_t>::Track*    signal_conf_ph;
+                GTStream<double>::Track*    lat_ph;
+                GTStream<double>::Track*    lon_ph;
+                GTStream<double>::Track*    delta_time;
+                const uint8_t*              classes;        // ATL08 class of each photon (NULL when not classified)
+
+                PhotonWindow                window;         // accepted photons not yet stepped past
+                int32_t                     photons;        // photons in extent
+                int32_t                     entries;        // window entries spanned by extent
+
+            private:
+
+                int32_t                     next_ph;        // next photon to be classified
+                int32_t                     next_seg;       // segment of next photon to be classified
+                int32_t                     next_seg_ph;    // photons of segment preceding next photon to be classified
+                uint64_t                    selection;      // bit per photon of block accepted by filters
+                int32_t                     selection_ph;   // first photon of block
+                int32_t                     selection_end;  // first photon after block
         };
 
+        /* Data of a Run Shared by its Ranges of Extents */
+        typedef struct {
+            info_t*             info;
+            const Region::run_t* run;
+            GTStream<int32_t>*  segment_ph_cnt;
+            GTStream<int32_t>*  segment_id;
+            GTStream<double>*   segment_dist_x;
+            double*             background_rates[PAIR_TRACKS_PER_GROUND_TRACK];
+            double*             spacecraft_speeds[PAIR_TRACKS_PER_GROUND_TRACK];
+            uint8_t*            atl08_class_ph[PAIR_TRACKS_PER_GROUND_TRACK];
+            long                stream_rows;        // rows of windows of photon streams of each range
+            Cond*               range_cond;         // signaled when a range completes
+            int                 ranges_complete;
+        } run_data_t;
+
+        /* Range of Extents of a Run (generated by a single thread) */
+        typedef struct {
+            run_data_t*     data;
+            cursor_t        cursor[PAIR_TRACKS_PER_GROUND_TRACK];       // at first extent of range
+            long            first_photon[PAIR_TRACKS_PER_GROUND_TRACK]; // photons of run visited by range
+            long            num_photons[PAIR_TRACKS_PER_GROUND_TRACK];
+            long            num_extents;        // ALL_EXTENTS for last range of run
+            stats_t         stats;
+        } extent_range_t;
+
         /*--------------------------------------------------------------------
          * Constants
          *--------------------------------------------------------------------*/
 
         static const double ATL03_SEGMENT_LENGTH;
+        static const long PHOTON_CHUNK_ROWS = 10000; // chunk size of ATL03 photon datasets
+        static const int PHOTON_ROW_BYTES = (2 * sizeof(float)) + sizeof(int8_t) + (3 * sizeof(double)); // a row of each streamed photon dataset
+        static const int STREAM_WINDOWS = 3; // windows held by a stream while advancing (current, next, and carried over)
+        static const int SEGMENT_ROW_BYTES = (2 * sizeof(int32_t)) + (2 * sizeof(double)); // a row of each segment dataset always read
+        static const int VELOCITY_ROW_BYTES = 3 * sizeof(float); // a row of velocity_sc
+        static const int GEOLOCATION_ROW_BYTES = 2 * sizeof(double); // a row of reference_photon_lat and reference_photon_lon
+        static const int BACKGROUND_ROW_BYTES = sizeof(float); // a row of bckgrd_rate
+        static const int ATL08_ROW_BYTES = sizeof(int32_t) + sizeof(int8_t); // a row of classed_pc_indx and classed_pc_flag
+        static const long MIN_RANGE_PHOTONS = 1000000; // photons (of both pair tracks) worth generating extents of in parallel
+        static const int MAX_RANGES = 64; // ranges of extents a run is split into
+        static const long ALL_EXTENTS = -1;
+        static const int SELECTION_BLOCK_PHOTONS = 64; // photons selected at a time (bits in a selection)
+        static const int BATCH_RECORD_SIZE = 0x100000; // bytes of record data allocated for a batch
+        static const int POST_QUEUE_DEPTH = 16; // records queued for posting per thread generating extents
+        static const int RECORD_SIG = 0; // wakes the poster when records are queued
+        static const int POSTED_SIG = 1; // wakes stages waiting for their records to be posted
+        static const int NUM_POST_SIGS = 2;
 
         /*--------------------------------------------------------------------
          * Data
          *--------------------------------------------------------------------*/
 
         bool                active;
-        Thread*             readerPid[NUM_TRACKS];
-        Mutex               threadMut;
+        Cond                threadCond; // signaled when a track completes
         int                 threadCount;
         int                 numComplete;
         Asset*              asset;
         Publisher*          outQ;
+        Atl06Dispatch*      atl06; // fits extents in reader threads when provided
+        Thread*             postPid; // poster of records queued by posting stages (not started when fit in reader)
+        Cond                postCond;
+        List<PostStage*>    postStages; // stages with records to post (protected by postCond)
+        bool                posting; // cleared to stop the poster (protected by postCond)
+        std::atomic<bool>   posterAsleep; // set while the poster waits for records
         atl06_parms_t*      parms;
+        read_plan_t         plan;
         stats_t             stats;
 
         H5Api::context_t    context; // for ATL03 file
@@ -179,12 +456,35 @@ class Atl03Reader: public LuaObject
          * Methods
          *--------------------------------------------------------------------*/
 
-                            Atl03Reader         (lua_State* L, Asset* _asset, const char* resource, const char* outq_name, atl06_parms_t* _parms, int track=ALL_TRACKS);
+                            Atl03Reader         (lua_State* L, Asset* _asset, const char* resource, const char* outq_name, atl06_parms_t* _parms, int track=ALL_TRACKS, Atl06Dispatch* _atl06=NULL);
                             ~Atl03Reader        (void);
 
+        static read_plan_t  planReads           (const atl06_parms_t* parms);
+        bool                selectPairTrack     (int track, int pair_track);
         static void*        atl06Thread         (void* parm);
+        static void*        rangeThread         (void* parm);
+        static void         initCursors         (run_data_t* data, cursor_t* cursor);
+        static int          planRanges          (run_data_t* data, GTStream<float>& dist_ph_along, const long* run_photons, extent_range_t* ranges, int max_ranges);
+        static void         generateExtents     (extent_range_t* range, PhotonStreams* photons, batch_t* batch, stats_t* local_stats);
+        static int32_t      walkExtent          (cursor_t& c, GTStream<int32_t>::Track& segment_ph_cnt, GTStream<double>::Track& segment_dist_x, GTStream<float>::Track& dist_ph_along, const atl06_parms_t* parms, bool* segments_missing);
+        static walk_t       findPhoton          (int32_t& photon, int32_t& segment, int32_t& seg_ph, double distance, double start_distance, GTStream<int32_t>::Track& segment_ph_cnt, GTStream<double>::Track& segment_dist_x, GTStream<float>::Track& dist_ph_along);
+        static void         stepStart           (cursor_t& c, GTStream<double>::Track& segment_dist_x, const atl06_parms_t* parms);
+        static void         interpolateBackground (double* rates, GTStream<double>::Track& segment_delta_time, GTStream<double>::Track& bckgrd_delta_time, long first_row, GTStream<float>::Track& bckgrd_rate);
+        static void         calculateSpeeds     (double* speeds, GTStream<float>::Track& velocity_sc, long num_segments);
+        static uint64_t     selectPhotons       (GTStream<int8_t>::Track& signal_conf_ph, const uint8_t* classes, const atl06_parms_t* parms, long first_photon, int num_photons);
+        static void         classifyPhotons     (uint8_t* classes, GTStream<int32_t>::Track& segment_ph_cnt, GTStream<int32_t>::Track& segment_id,
+                                                 GTStream<int32_t>::Track& ph_segment_id, long first_row, GTStream<int32_t>::Track& classed_pc_indx, GTStream<int8_t>::Track& classed_pc_flag);
+        extent_t*           allocExtent         (batch_t* batch, int extent_bytes, stats_t* local_stats);
+        void                sendExtent          (batch_t* batch, stats_t* local_stats);
+        void                postExtents         (batch_t* batch, stats_t* local_stats);
+        void                postRecord          (unsigned char* rec_buf, int rec_bytes, int count, stats_t* local_stats);
+        void                wakePoster          (void);
+        static void*        postThread          (void* parm);
         static int          luaParms            (lua_State* L);
         static int          luaStats            (lua_State* L);
+
+        /* Unit Tests */
+        friend class UT_Atl03Reader;
 };
 
 #endif  /* __atl03_reader__ */
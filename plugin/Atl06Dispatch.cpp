@@ -121,6 +121,8 @@ const RecordObject::fieldDef_t Atl06Dispatch::atRecDef[] = {
     {"elevation",               RecordObject::USER,     offsetof(atl06_t, elevation),               0,  elRecType, NATIVE_FLAGS}
 };
 
+std::atomic<uint64_t> Atl06Dispatch::instanceCount(0);
+
 const char* Atl06Dispatch::LuaMetaName = "Atl06Dispatch";
 const struct luaL_Reg Atl06Dispatch::LuaMetaTable[] = {
     {"stats",       luaStats},
@@ -176,6 +178,41 @@ void Atl06Dispatch::init (void)
 
     rc = RecordObject::defineRecord(atCompactRecType, NULL, offsetof(atl06_compact_t, elevation[1]), atCompactRecDef, sizeof(atCompactRecDef) / sizeof(RecordObject::fieldDef_t), 4);
     if(rc != RecordObject::SUCCESS_DEF) mlog(CRITICAL, "Failed to define %s: %d", atCompactRecType, rc);
+
+    /* Select Vectorized Kernels */
+    Atl06Kernels::init();
+}
+
+/*----------------------------------------------------------------------------
+ * processExtent
+ *----------------------------------------------------------------------------*/
+void Atl06Dispatch::processExtent (Atl03Reader::extent_t* extent)
+{
+    fitExtents(&extent, 1);
+}
+
+/*----------------------------------------------------------------------------
+ * flushResults
+ *
+ *  posts the elevations not yet posted in every thread's batch; used when
+ *  extents are processed outside of a dispatcher (which otherwise flushes
+ *  on timeout)
+ *----------------------------------------------------------------------------*/
+void Atl06Dispatch::flushResults (void)
+{
+    batchMutex.lock();
+    {
+        for(int i = 0; i < batches.length(); i++)
+        {
+            batch_t* batch = batches[i];
+            batch->mutex.lock();
+            {
+                postBatch(batch);
+            }
+            batch->mutex.unlock();
+        }
+    }
+    batchMutex.unlock();
 }
 
 /******************************************************************************
@@ -194,28 +231,11 @@ Atl06Dispatch::Atl06Dispatch (lua_State* L, const char* outq_name, const atl06_p
     /* Initialize Parameters */
     parms = _parms;
 
-    /*
-     * Note: when allocating memory for this record, the full record size is used;
-     * this extends the memory available past the one elevation provided in the
-     * definition.
-     */
-    if(!parms->compact)
-    {
-        recObj = new RecordObject(atRecType, sizeof(atl06_t));
-        recData = (atl06_t*)recObj->getRecordData();
-    }
-    else
-    {
-        recObj = new RecordObject(atCompactRecType, sizeof(atl06_compact_t));
-        recCompactData = (atl06_compact_t*)recObj->getRecordData();
-    }
-
     /* Initialize Publisher */
     outQ = new Publisher(outq_name);
-    elevationIndex = 0;
 
-    /* Initialize Statistics */
-    LocalLib::set(&stats, 0, sizeof(stats));
+    /* Identify Instance (for per thread batches) */
+    instanceId = ++instanceCount;
 }
 
 /*----------------------------------------------------------------------------
@@ -224,8 +244,14 @@ Atl06Dispatch::Atl06Dispatch (lua_State* L, const char* outq_name, const atl06_p
 Atl06Dispatch::~Atl06Dispatch(void)
 {
     delete outQ;
-    delete recObj;
-    delete parms;
+    freeAtl06Parms(parms);
+
+    /* Free Batches */
+    for(int i = 0; i < batches.length(); i++)
+    {
+        delete batches[i]->record;
+        delete batches[i];
+    }
 }
 
 /*----------------------------------------------------------------------------
@@ -235,60 +261,24 @@ bool Atl06Dispatch::processRecord (RecordObject* record, okey_t key)
 {
     (void)key;
 
-    result_t result[PAIR_TRACKS_PER_GROUND_TRACK];
-
-    /* Bump Statistics */
-    stats.h5atl03_rec_cnt++;
-
-    /* Get Extent */
-    Atl03Reader::extent_t* extent = (Atl03Reader::extent_t*)record->getRecordData();
-
-    /* Clear Results */
-    LocalLib::set(&result, 0, sizeof(result_t) * PAIR_TRACKS_PER_GROUND_TRACK);
-
-    /* Initialize Results */
-    int first_photon = 0;
-    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
-    {
-        /* Elevation Attributes */
-        result[t].elevation.segment_id = extent->segment_id[t];
-        result[t].elevation.rgt = extent->reference_ground_track_start;
-        result[t].elevation.cycle = extent->cycle_start;
-
-        /* Copy In Initial Set of Photons */
-        result[t].elevation.photon_count = extent->photon_count[t];
-        if(result[t].elevation.photon_count > 0)
-        {
-            result[t].photons = new point_t[result[t].elevation.photon_count];
-            for(int p = 0; p < result[t].elevation.photon_count; p++)
-            {
-                result[t].photons[p].p = first_photon + p;  // extent->photons[]
-            }
-            first_photon += result[t].elevation.photon_count;
-        }
-    }
-    /* Calcualte Beam Number */
-    calculateBeam((sc_orient_t)extent->spacecraft_orientation, (track_t)extent->reference_pair_track, result);
-
-    /* Execute Algorithm Stages */
-    if(parms->stages[STAGE_LSF]) iterativeFitStage(extent, result);
+    unsigned char* rec_data = record->getRecordData();
 
-    /* Post Elevation  */
-    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+    if(record->isRecordType(Atl03Reader::batchRecType))
     {
-        if(result[t].provided)
+        /* Fit All Extents in Batch Together */
+        Atl03Reader::extent_batch_t* batch = (Atl03Reader::extent_batch_t*)rec_data;
+        Atl03Reader::extent_t* extents[Atl03Reader::MAX_EXTENTS_PER_BATCH];
+        int num_extents = MIN(batch->extent_count, Atl03Reader::MAX_EXTENTS_PER_BATCH);
+        for(int e = 0; e < num_extents; e++)
         {
-            postResult(&result[t].elevation);
+            extents[e] = (Atl03Reader::extent_t*)(rec_data + batch->extent_offset[e]);
         }
+        fitExtents(extents, num_extents);
     }
-
-    /* Clean Up Results */
-    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+    else
     {
-        if(result[t].photons)
-        {
-            delete [] result[t].photons;
-        }
+        /* Process Single Extent */
+        processExtent((Atl03Reader::extent_t*)rec_data);
     }
 
     /* Return Status */
@@ -300,7 +290,7 @@ bool Atl06Dispatch::processRecord (RecordObject* record, okey_t key)
  *----------------------------------------------------------------------------*/
 bool Atl06Dispatch::processTimeout (void)
 {
-    postResult(NULL);
+    flushResults();
     return true;
 }
 
@@ -319,113 +309,262 @@ bool Atl06Dispatch::processTermination (void)
  *----------------------------------------------------------------------------*/
 void Atl06Dispatch::calculateBeam (sc_orient_t sc_orient, track_t track, result_t* result)
 {
-    if(sc_orient == SC_BACKWARD)
+    static const gt_t gts[NUM_TRACKS][PAIR_TRACKS_PER_GROUND_TRACK] = { {GT1L, GT1R}, {GT2L, GT2R}, {GT3L, GT3R} };
+
+    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
     {
-        if(track == RPT_1)
-        {
-            result[PRT_LEFT].elevation.spot = SPOT_5;
-            result[PRT_RIGHT].elevation.spot = SPOT_6;
-            result[PRT_LEFT].elevation.gt = (uint8_t)GT1L;
-            result[PRT_RIGHT].elevation.gt = (uint8_t)GT1R;
-        }
-        else if(track == RPT_2)
-        {
-            result[PRT_LEFT].elevation.spot = SPOT_3;
-            result[PRT_RIGHT].elevation.spot = SPOT_4;
-            result[PRT_LEFT].elevation.gt = (uint8_t)GT2L;
-            result[PRT_RIGHT].elevation.gt = (uint8_t)GT2R;
-        }
-        else if(track == RPT_3)
+        int spot = Atl03Reader::getSpot(sc_orient, track, t); // same mapping used to select spots when reading
+        if(spot != 0)
         {
-            result[PRT_LEFT].elevation.spot = SPOT_1;
-            result[PRT_RIGHT].elevation.spot = SPOT_2;
-            result[PRT_LEFT].elevation.gt = (uint8_t)GT3L;
-            result[PRT_RIGHT].elevation.gt = (uint8_t)GT3R;
+            result[t].elevation.spot = spot;
+            result[t].elevation.gt = (uint8_t)gts[track - 1][t];
         }
     }
-    else if(sc_orient == SC_FORWARD)
+}
+
+/*----------------------------------------------------------------------------
+ * getBatch
+ *
+ *  returns the calling thread's output batch for this dispatcher, creating
+ *  it on the thread's first call; the thread's cache is searched without
+ *  taking any lock
+ *----------------------------------------------------------------------------*/
+Atl06Dispatch::batch_t* Atl06Dispatch::getBatch (void)
+{
+    static thread_local batch_entry_t cache[BATCH_CACHE_SIZE] = {};
+    static thread_local int next_entry = 0;
+
+    /* Look Up Thread's Batch */
+    for(int i = 0; i < BATCH_CACHE_SIZE; i++)
     {
-        if(track == RPT_1)
-        {
-            result[PRT_LEFT].elevation.spot = SPOT_2;
-            result[PRT_RIGHT].elevation.spot = SPOT_1;
-            result[PRT_LEFT].elevation.gt = (uint8_t)GT1L;
-            result[PRT_RIGHT].elevation.gt = (uint8_t)GT1R;
-        }
-        else if(track == RPT_2)
+        if(cache[i].instance == instanceId)
         {
-            result[PRT_LEFT].elevation.spot = SPOT_4;
-            result[PRT_RIGHT].elevation.spot = SPOT_3;
-            result[PRT_LEFT].elevation.gt = (uint8_t)GT2L;
-            result[PRT_RIGHT].elevation.gt = (uint8_t)GT2R;
-        }
-        else if(track == RPT_3)
-        {
-            result[PRT_LEFT].elevation.spot = SPOT_6;
-            result[PRT_RIGHT].elevation.spot = SPOT_5;
-            result[PRT_LEFT].elevation.gt = (uint8_t)GT3L;
-            result[PRT_RIGHT].elevation.gt = (uint8_t)GT3R;
+            return cache[i].batch;
         }
     }
+
+    /* Create Batch */
+    batch_t* batch = new batch_t;
+    batch->record = NULL;
+    batch->count = 0;
+    LocalLib::set(&batch->stats, 0, sizeof(batch->stats));
+
+    /* Register Batch (so that it is flushed and its statistics read) */
+    batchMutex.lock();
+    {
+        batches.add(batch);
+    }
+    batchMutex.unlock();
+
+    /* Cache Batch (replacing oldest entry; an evicted batch is still flushed) */
+    cache[next_entry].instance = instanceId;
+    cache[next_entry].batch = batch;
+    next_entry = (next_entry + 1) % BATCH_CACHE_SIZE;
+
+    return batch;
 }
 
 /*----------------------------------------------------------------------------
- * postResult
+ * addElevation
+ *
+ *  caller must hold batch mutex
  *----------------------------------------------------------------------------*/
-void Atl06Dispatch::postResult (elevation_t* elevation)
+void Atl06Dispatch::addElevation (batch_t* batch, elevation_t* elevation)
 {
+    /*
+     * Note: when allocating memory for this record, the full record size is used;
+     * this extends the memory available past the one elevation provided in the
+     * definition.
+     */
+    if(!batch->record)
+    {
+        if(!parms->compact) batch->record = new RecordObject(atRecType, sizeof(atl06_t));
+        else                batch->record = new RecordObject(atCompactRecType, sizeof(atl06_compact_t));
+    }
+
+    /* Populate Elevation */
+    if(!parms->compact)
+    {
+        atl06_t* data = (atl06_t*)batch->record->getRecordData();
+        data->elevation[batch->count++] = *elevation;
+    }
+    else
+    {
+        atl06_compact_t* data = (atl06_compact_t*)batch->record->getRecordData();
+        data->elevation[batch->count].delta_time = elevation->delta_time;
+        data->elevation[batch->count].latitude = elevation->latitude;
+        data->elevation[batch->count].longitude = elevation->longitude;
+        data->elevation[batch->count].h_mean = elevation->h_mean;
+        batch->count++;
+    }
 
-    elevationMutex.lock();
+    /* Post Full Batch */
+    if(batch->count == BATCH_SIZE)
     {
-        /* Populate Elevation */
-        if(elevation)
+        postBatch(batch);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * postBatch
+ *
+ *  caller must hold batch mutex
+ *----------------------------------------------------------------------------*/
+void Atl06Dispatch::postBatch (batch_t* batch)
+{
+    if(!batch->record) return;
+
+    /* Serialize Record (ownership of record memory is passed to the queue) */
+    unsigned char* buffer = NULL;
+    int size = batch->record->serialize(&buffer, RecordObject::TAKE_OWNERSHIP);
+
+    /* Adjust Size (according to number of elevations) */
+    if(!parms->compact)
+    {
+        size -= (BATCH_SIZE - batch->count) * sizeof(elevation_t);
+    }
+    else
+    {
+        size -= (BATCH_SIZE - batch->count) * sizeof(elevation_compact_t);
+    }
+
+    /* Post Record */
+    if(outQ->postRef(buffer, size, SYS_TIMEOUT) > 0)
+    {
+        batch->stats.post_success_cnt++;
+    }
+    else
+    {
+        batch->stats.post_dropped_cnt++;
+        delete [] buffer; // record memory not taken by queue
+    }
+
+    /* Reset Batch */
+    delete batch->record;
+    batch->record = NULL;
+    batch->count = 0;
+}
+
+/*----------------------------------------------------------------------------
+ * fitExtents
+ *
+ *  stages the photons of every track of every extent into one set of packed
+ *  arrays so that the fit stages run across all of the extents together;
+ *  results are posted in the order of the extents
+ *----------------------------------------------------------------------------*/
+void Atl06Dispatch::fitExtents (Atl03Reader::extent_t** extents, int num_extents)
+{
+    int num_fits = num_extents * PAIR_TRACKS_PER_GROUND_TRACK;
+
+    /* Count Photons to Stage */
+    int num_points = 0;
+    for(int e = 0; e < num_extents; e++)
+    {
+        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
         {
-            if(!parms->compact)
-            {
-                recData->elevation[elevationIndex++] = *elevation;
-            }
-            else
-            {
-                recCompactData->elevation[elevationIndex].delta_time = elevation->delta_time;
-                recCompactData->elevation[elevationIndex].latitude = elevation->latitude;
-                recCompactData->elevation[elevationIndex].longitude = elevation->longitude;
-                recCompactData->elevation[elevationIndex].h_mean = elevation->h_mean;
-                elevationIndex++;
-            }
+            if(extents[e]->valid[t]) num_points += extents[e]->photon_count[t];
         }
+    }
+    int stride = (num_points + POINT_ALIGNMENT - 1) & ~(POINT_ALIGNMENT - 1); // each staged array starts on a cache line
+
+    /* Get Memory (stack for a typical single extent, thread's arena otherwise) */
+    static thread_local Arena arena;
+    result_t stack_results[PAIR_TRACKS_PER_GROUND_TRACK];
+    fit_t stack_fits[PAIR_TRACKS_PER_GROUND_TRACK];
+    alignas(64) point_t stack_points[STACK_POINTS];
+    alignas(64) double stack_staged[STAGED_ARRAYS * STACK_POINTS];
+    uint8_t stack_flags[STAGED_FLAGS * STACK_POINTS];
+    result_t* results = stack_results;
+    fit_t* fits = stack_fits;
+    point_t* points = stack_points;
+    double* staged_arrays = stack_staged;
+    uint8_t* staged_flags = stack_flags;
+    if(num_fits > PAIR_TRACKS_PER_GROUND_TRACK || stride > STACK_POINTS)
+    {
+        arena.reset();
+        results = (result_t*)arena.alloc(sizeof(result_t) * num_fits);
+        fits = (fit_t*)arena.alloc(sizeof(fit_t) * num_fits);
+        points = (point_t*)arena.alloc(sizeof(point_t) * stride);
+        staged_arrays = (double*)arena.alloc(sizeof(double) * STAGED_ARRAYS * stride);
+        staged_flags = (uint8_t*)arena.alloc(sizeof(uint8_t) * STAGED_FLAGS * stride);
+    }
 
-        /* Check If ATL06 Record Should Be Posted*/
-        if((!elevation && elevationIndex > 0) || elevationIndex == BATCH_SIZE)
-        {
-            /* Serialize Record */
-            unsigned char* buffer;
-            int size = recObj->serialize(&buffer, RecordObject::REFERENCE);
+    /* Assign Staged Arrays */
+    staged_t staged;
+    staged.points       = points;
+    staged.x            = &staged_arrays[0 * stride];
+    staged.y            = &staged_arrays[1 * stride];
+    staged.r            = &staged_arrays[2 * stride];
+    staged.h            = &staged_arrays[3 * stride];
+    staged.slope        = &staged_arrays[4 * stride];
+    staged.spread       = &staged_arrays[5 * stride];
+    staged.residuals    = &staged_arrays[6 * stride];
+    staged.ranked       = &staged_flags[0 * stride];
+    staged.in_window    = &staged_flags[1 * stride];
 
-            /* Adjust Size (according to number of elevations) */
-            if(!parms->compact)
-            {
-                size -= (BATCH_SIZE - elevationIndex) * sizeof(elevation_t);
-            }
-            else
-            {
-                size -= (BATCH_SIZE - elevationIndex) * sizeof(elevation_compact_t);
-            }
+    /* Clear Results */
+    LocalLib::set(results, 0, sizeof(result_t) * num_fits);
 
-            /* Reset Elevation Index */
-            elevationIndex = 0;
+    /* Initialize Results and Stage Photons */
+    int num_staged = 0;
+    for(int e = 0; e < num_extents; e++)
+    {
+        Atl03Reader::extent_t* extent = extents[e];
+        result_t* result = &results[e * PAIR_TRACKS_PER_GROUND_TRACK];
+        fit_t* fit = &fits[e * PAIR_TRACKS_PER_GROUND_TRACK];
 
-            /* Post Record */
-            if(outQ->postCopy(buffer, size, SYS_TIMEOUT) > 0)
+        int first_photon = 0;
+        for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+        {
+            /* Elevation Attributes */
+            result[t].elevation.segment_id = extent->segment_id[t];
+            result[t].elevation.rgt = extent->reference_ground_track_start;
+            result[t].elevation.cycle = extent->cycle_start;
+            result[t].elevation.photon_count = extent->photon_count[t];
+
+            /* Track's Fit */
+            fit[t].extent = extent;
+            fit[t].result = &result[t];
+            fit[t].track = t;
+            fit[t].first = num_staged;
+
+            /* Copy In Initial Set of Photons */
+            if(extent->valid[t])
             {
-                stats.post_success_cnt++;
+                result[t].photons = &staged.points[num_staged];
+                for(int p = 0; p < result[t].elevation.photon_count; p++)
+                {
+                    Atl03Reader::photon_t* ph = &extent->photons[first_photon + p];
+                    staged.points[num_staged].p = first_photon + p;  // extent->photons[]
+                    staged.x[num_staged] = ph->distance;
+                    staged.y[num_staged] = ph->height;
+                    num_staged++;
+                }
             }
-            else
+            first_photon += result[t].elevation.photon_count;
+        }
+
+        /* Calcualte Beam Number */
+        calculateBeam((sc_orient_t)extent->spacecraft_orientation, (track_t)extent->reference_pair_track, result);
+    }
+
+    /* Execute Algorithm Stages */
+    if(parms->stages[STAGE_LSF]) iterativeFitStage(fits, num_fits, &staged, num_staged);
+
+    /* Post Elevations (to calling thread's batch) */
+    batch_t* batch = getBatch();
+    batch->mutex.lock();
+    {
+        batch->stats.h5atl03_rec_cnt += num_extents;
+        for(int f = 0; f < num_fits; f++)
+        {
+            if(results[f].provided)
             {
-                stats.post_dropped_cnt++;
+                addElevation(batch, &results[f].elevation);
             }
         }
     }
-    elevationMutex.unlock();
+    batch->mutex.unlock();
 }
 
 /*----------------------------------------------------------------------------
@@ -434,17 +573,41 @@ void Atl06Dispatch::postResult (elevation_t* elevation)
  *  Note: Section 5.5 - Signal selection based on ATL03 flags
  *        Procedures 4b and after
  *
+ *  The fits are iterated in lock-step: the residuals and window selection of
+ *  every photon of every active fit are calculated together, so that the
+ *  photons of small extents fill the vector lanes of the kernels; after each
+ *  iteration the photons of the fits still active are packed to the front
+ *  of the staged arrays.
+ *
+ *  The photons are never sorted by residual, so the least squares sums add
+ *  them in along-track order; only the robust dispersion estimate is
+ *  bit-identical to that of a sorted fit, and the other fields of the
+ *  elevation can differ from it in the last bits.
+ *
  *  TODO: replace spacecraft ground speed constant with value provided in ATL03
  *----------------------------------------------------------------------------*/
-void Atl06Dispatch::iterativeFitStage (Atl03Reader::extent_t* extent, result_t* result)
+void Atl06Dispatch::iterativeFitStage (fit_t* fits, int num_fits, staged_t* staged, int num_photons)
 {
-    /* Process Tracks */
-    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+    const Atl06Kernels::kernels_t* kernels = Atl06Kernels::active;
+    int num_active = 0;
+
+    /* Initialize Fits */
+    for(int f = 0; f < num_fits; f++)
     {
+        fit_t* fit = &fits[f];
+        Atl03Reader::extent_t* extent = fit->extent;
+        result_t* result = fit->result;
+        int t = fit->track;
+
+        /* Initial Conditions */
+        fit->done = false;
+        fit->invalid = false;
+        fit->iteration = 0;
+
         /* Check Valid Extent */
-        if(extent->valid[t] && result[t].elevation.photon_count > 0)
+        if(extent->valid[t] && result->elevation.photon_count > 0)
         {
-            result[t].provided = true;
+            result->provided = true;
         }
         else
         {
@@ -452,209 +615,245 @@ void Atl06Dispatch::iterativeFitStage (Atl03Reader::extent_t* extent, result_t*
             // a valid extent, but given that the code below is invalid
             // if the number of photons is less than or equal to zero,
             // the check is provided explicitly
+            fit->done = true;
             continue;
         }
 
-        /* Initial Conditions */
-        bool done = false;
-        bool invalid = false;
-        int iteration = 0;
-
         /* Initial Per Track Calculations */
-        double pulses_in_extent     = (extent->extent_length[t] * PULSE_REPITITION_FREQUENCY) / extent->spacecraft_velocity[t]; // N_seg_pulses, section 5.4, procedure 1d
-        double background_density   = pulses_in_extent * extent->background_rate[t] / (SPEED_OF_LIGHT / 2.0); // BG_density, section 5.7, procedure 1c
+        double pulses_in_extent = (extent->extent_length[t] * PULSE_REPITITION_FREQUENCY) / extent->spacecraft_velocity[t]; // N_seg_pulses, section 5.4, procedure 1d
+        fit->background_density = pulses_in_extent * extent->background_rate[t] / (SPEED_OF_LIGHT / 2.0); // BG_density, section 5.7, procedure 1c
+
+        /* Initial Sums for Least Squares Fit */
+        fit->sums.n = result->elevation.photon_count;
+        kernels->sums(&staged->x[fit->first], &staged->y[fit->first], result->elevation.photon_count, &fit->sums.x, &fit->sums.xx, &fit->sums.y, &fit->sums.xy);
+
+        num_active++;
+    }
 
-        /* Iterate Processing of Photons */
-        while(!done)
+    /* Iterate Processing of Photons */
+    while(num_active > 0)
+    {
+        /* Calculate Least Squares Fits */
+        for(int f = 0; f < num_fits; f++)
         {
-            int num_photons = result[t].elevation.photon_count;
+            fit_t* fit = &fits[f];
+            if(fit->done) continue;
 
-            /* Calculate Least Squares Fit */
-            lsf_t fit = lsf(extent, result[t].photons, num_photons, false);
-            result[t].elevation.h_mean = fit.height;
-            result[t].elevation.along_track_slope = fit.slope;
-            result[t].elevation.h_sigma = fit.y_sigma; // scaled by rms below
+            result_t* result = fit->result;
+            lsf_t lsf_fit = lsfSolve(&fit->sums);
+            result->elevation.h_mean = lsf_fit.height;
+            result->elevation.along_track_slope = lsf_fit.slope;
+            result->elevation.h_sigma = lsf_fit.y_sigma; // scaled by rms below
 
-            /* Calculate Residuals */
-            for(int p = 0; p < num_photons; p++)
+            /* Broadcast Fit to Photons */
+            for(int p = fit->first; p < fit->first + result->elevation.photon_count; p++)
             {
-                double x = extent->photons[result[t].photons[p].p].distance;
-                double y = extent->photons[result[t].photons[p].p].height;
-                result[t].photons[p].r = y - (fit.height + (x * fit.slope));
+                staged->h[p] = lsf_fit.height;
+                staged->slope[p] = lsf_fit.slope;
             }
+        }
+
+        /* Calculate Residuals */
+        kernels->residuals(staged->x, staged->y, staged->h, staged->slope, num_photons, staged->r);
+
+        /* Calculate Windows */
+        for(int f = 0; f < num_fits; f++)
+        {
+            fit_t* fit = &fits[f];
+            if(fit->done) continue;
 
-            /* Sort Points by Residuals */
-            quicksort(result[t].photons, 0, num_photons-1);
+            result_t* result = fit->result;
+            int num_fit_photons = result->elevation.photon_count;
+            double* r = &staged->r[fit->first];
 
             /* Calculate Inputs to Robust Dispersion Estimate */
             double  background_count;       // N_BG
             double  window_lower_bound;     // zmin
             double  window_upper_bound;     // zmax;
-            if(iteration == 0)
+            if(fit->iteration == 0)
             {
-                window_lower_bound  = result[t].photons[0].r; // section 5.5, procedure 4c
-                window_upper_bound  = result[t].photons[num_photons - 1].r; // section 5.5, procedure 4c
-                background_count    = background_density * (window_upper_bound - window_lower_bound); // section 5.5, procedure 4b; pe_select_mod.f90 initial_select()
+                window_lower_bound  = r[0];
+                window_upper_bound  = r[0];
+                for(int p = 1; p < num_fit_photons; p++)
+                {
+                    if(r[p] < window_lower_bound) window_lower_bound = r[p]; // section 5.5, procedure 4c
+                    if(r[p] > window_upper_bound) window_upper_bound = r[p]; // section 5.5, procedure 4c
+                }
+                background_count    = fit->background_density * (window_upper_bound - window_lower_bound); // section 5.5, procedure 4b; pe_select_mod.f90 initial_select()
             }
             else
             {
-                background_count    = background_density * result[t].elevation.window_height; // section 5.7, procedure 2c
-                window_lower_bound  = -(result[t].elevation.window_height / 2.0); // section 5.7, procedure 2c
-                window_upper_bound  = result[t].elevation.window_height / 2.0; // section 5.7, procedure 2c
+                background_count    = fit->background_density * result->elevation.window_height; // section 5.7, procedure 2c
+                window_lower_bound  = -(result->elevation.window_height / 2.0); // section 5.7, procedure 2c
+                window_upper_bound  = result->elevation.window_height / 2.0; // section 5.7, procedure 2c
             }
 
-            /* Continued Inputs to Robust Dispersion Estimate */
-            double background_rate  = background_count / (window_upper_bound - window_lower_bound); // bckgrd, section 5.9, procedure 1a
-            double signal_count     = num_photons - background_count; // N_sig, section 5.9, procedure 1b
-            double sigma_r          = 0.0; // sigma_r
-
             /* Calculate Robust Dispersion Estimate */
-            if(signal_count <= 1)
-            {
-                sigma_r = (window_upper_bound - window_lower_bound) / num_photons; // section 5.9, procedure 1c
-            }
-            else
+            double sigma_r = 0.0; // sigma_r
+            LocalLib::copy(&staged->residuals[fit->first], r, sizeof(double) * num_fit_photons);
+            if(!robustDispersion(&staged->residuals[fit->first], &staged->ranked[fit->first], num_fit_photons, window_lower_bound, window_upper_bound, background_count, &sigma_r))
             {
-                /* Find Smallest Potential Percentiles (0) */
-                int32_t i0 = 0;
-                while(i0 < num_photons)
-                {
-                    double spp = (0.25 * signal_count) + ((result[t].photons[i0].r - window_lower_bound) * background_rate); // section 5.9, procedure 4a
-                    if( (((double)i0) + 1.0 - 0.5 + 1.0) < spp )    i0++;   // +1 adjusts for 0 vs 1 based indices, -.5 rounds, +1 looks ahead
-                    else                                            break;
-                }
-
-                /* Find Smallest Potential Percentiles (1) */
-                int32_t i1 = num_photons - 1;
-                while(i1 >= 0)
-                {
-                    double spp = (0.75 * signal_count) + ((result[t].photons[i1].r - window_lower_bound) * background_rate); // section 5.9, procedure 4a
-                    if( (((double)i1) + 1.0 - 0.5 - 1.0) > spp )    i1--;   // +1 adjusts for 0 vs 1 based indices, -.5 rounds, +1 looks ahead
-                    else                                            break;
-                }
-
-                /* Check Need to Refind Percentiles */
-                if(i1 < i0)
-                {
-                    /* Find Spread of Central Values (0) */
-                    double spp0 = (num_photons / 2.0) - (signal_count / 4.0); // section 5.9, procedure 5a
-                    i0 = (int32_t)(spp0 + 0.5) - 1;
-
-                    /* Find Spread of Central Values (1) */
-                    double spp1 = (num_photons / 2.0) + (signal_count / 4.0); // section 5.9, procedure 5b
-                    i1 = (int32_t)(spp1 + 0.5);
-                }
-
-                /* Check Validity of Percentiles */
-                if(i0 >= 0 && i1 < num_photons)
-                {
-                    /* Calculate Robust Dispersion Estimate */
-                    sigma_r = (result[t].photons[i1].r - result[t].photons[i0].r) / RDE_SCALE_FACTOR; // section 5.9, procedure 6
-                }
-                else
-                {
-                    mlog(CRITICAL, "Out of bounds condition caught: %d, %d, %d", i0, i1, num_photons);
-                    result[t].elevation.pflags |= PFLAG_OUT_OF_BOUNDS;
-                    invalid = true;
-                }
+                result->elevation.pflags |= PFLAG_OUT_OF_BOUNDS;
+                fit->invalid = true;
             }
 
             /* Calculate Sigma Expected */
             double se1 = pow((SPEED_OF_LIGHT / 2.0) * SIGMA_XMIT, 2);
-            double se2 = pow(SIGMA_BEAM, 2) * pow(result[t].elevation.along_track_slope, 2);
+            double se2 = pow(SIGMA_BEAM, 2) * pow(result->elevation.along_track_slope, 2);
             double sigma_expected = sqrt(se1 + se2); // sigma_expected, section 5.5, procedure 4d
 
             /* Calculate Window Height */
             if(sigma_r > parms->maximum_robust_dispersion) sigma_r = parms->maximum_robust_dispersion;
             double new_window_height = MAX(MAX(parms->minimum_window, 6.0 * sigma_expected), 6.0 * sigma_r); // H_win, section 5.5, procedure 4e
-            result[t].elevation.window_height = MAX(new_window_height, 0.75 * result[t].elevation.window_height); // section 5.7, procedure 2e
-            double window_spread = result[t].elevation.window_height / 2.0;
+            result->elevation.window_height = MAX(new_window_height, 0.75 * result->elevation.window_height); // section 5.7, procedure 2e
+            double window_spread = result->elevation.window_height / 2.0;
+
+            /* Broadcast Window to Photons */
+            for(int p = fit->first; p < fit->first + num_fit_photons; p++)
+            {
+                staged->spread[p] = window_spread;
+            }
+        }
+
+        /* Select Photons in Windows */
+        kernels->window(staged->r, staged->spread, num_photons, staged->in_window);
+
+        /* Check Conditions of Next Iteration (section 5.7, procedure 2h) */
+        for(int f = 0; f < num_fits; f++)
+        {
+            fit_t* fit = &fits[f];
+            if(fit->done) continue;
+
+            result_t* result = fit->result;
+            int num_fit_photons = result->elevation.photon_count;
 
-            /* Precalculate Next Iteration's Conditions (section 5.7, procedure 2h) */
+            /* Precalculate Next Iteration's Conditions */
             int32_t next_num_photons = 0;
             double x_min = DBL_MAX;
             double x_max = DBL_MIN;
-            for(int p = 0; p < num_photons; p++)
+            for(int p = fit->first; p < fit->first + num_fit_photons; p++)
             {
-                if(abs(result[t].photons[p].r) < window_spread)
+                if(staged->in_window[p])
                 {
                     next_num_photons++;
-                    double x = extent->photons[result[t].photons[p].p].distance;
-                    if(x < x_min) x_min = x;
-                    if(x > x_max) x_max = x;
+                    if(staged->x[p] < x_min) x_min = staged->x[p];
+                    if(staged->x[p] > x_max) x_max = staged->x[p];
                 }
             }
 
             /* Check Photon Count */
             if(next_num_photons < parms->minimum_photon_count)
             {
-                result[t].elevation.pflags |= PFLAG_TOO_FEW_PHOTONS;
-                invalid = true;
-                done = true;
+                result->elevation.pflags |= PFLAG_TOO_FEW_PHOTONS;
+                fit->invalid = true;
+                fit->done = true;
             }
             /* Check Spread */
             else if((x_max - x_min) < parms->along_track_spread)
             {
-                result[t].elevation.pflags |= PFLAG_SPREAD_TOO_SHORT;
-                invalid = true;
-                done = true;
+                result->elevation.pflags |= PFLAG_SPREAD_TOO_SHORT;
+                fit->invalid = true;
+                fit->done = true;
             }
             /* Check Change in Number of Photons */
-            else if(next_num_photons == num_photons)
+            else if(next_num_photons == num_fit_photons)
             {
-                done = true;
+                fit->done = true;
             }
             /* Check Iterations */
-            else if(++iteration >= parms->max_iterations)
+            else if(++fit->iteration >= parms->max_iterations)
             {
-                result[t].elevation.pflags |= PFLAG_MAX_ITERATIONS_REACHED;
-                done = true;
+                result->elevation.pflags |= PFLAG_MAX_ITERATIONS_REACHED;
+                fit->done = true;
             }
-            /* Filtered Out Photons in Results and Iterate Again (section 5.5, procedure 4f) */
-            else
+
+            /* Finish Fit (before its photons are packed over) */
+            if(fit->done)
             {
-                int32_t ph_in = 0;
-                for(int p = 0; p < num_photons; p++)
-                {
-                    if(abs(result[t].photons[p].r) < window_spread)
-                    {
-                        result[t].photons[ph_in++] = result[t].photons[p];
-                    }
-                }
-                result[t].elevation.photon_count = ph_in;
+                finalizeFit(fit, staged);
+                num_active--;
             }
         }
 
-        /*
-         *  Note: Section 3.6 - Signal, Noise, and Error Estimates
-         *        Section 5.7, procedure 5
-         */
-
-        /* Sum Deltas in Photon Heights */
-        double delta_sum = 0.0;
-        for(int p = 0; p < result[t].elevation.photon_count; p++)
+        /* Filter Out Photons of Active Fits and Pack Them (section 5.5, procedure 4f) */
+        int num_packed = 0;
+        for(int f = 0; f < num_fits; f++)
         {
-            delta_sum += (result[t].photons[p].r * result[t].photons[p].r);
-        }
+            fit_t* fit = &fits[f];
+            if(fit->done) continue;
 
-        /* Calculate RMS and Scale h_sigma */
-        if(!invalid && result[t].elevation.photon_count > 0)
-        {
-            result[t].elevation.rms_misfit = sqrt(delta_sum / (double)result[t].elevation.photon_count);
-            result[t].elevation.h_sigma = result[t].elevation.rms_misfit * result[t].elevation.h_sigma;
-        }
-        else
-        {
-            result[t].elevation.rms_misfit = 0.0;
-            result[t].elevation.h_sigma = 0.0;
+            result_t* result = fit->result;
+            int num_fit_photons = result->elevation.photon_count;
+            int32_t ph_in = 0;
+            for(int p = fit->first; p < fit->first + num_fit_photons; p++)
+            {
+                if(staged->in_window[p])
+                {
+                    staged->points[num_packed + ph_in] = staged->points[p];
+                    staged->x[num_packed + ph_in] = staged->x[p];
+                    staged->y[num_packed + ph_in] = staged->y[p];
+                    ph_in++;
+                }
+                else
+                {
+                    /* Remove Photon from Sums */
+                    fit->sums.n -= 1.0;
+                    fit->sums.x -= staged->x[p];
+                    fit->sums.xx -= staged->x[p] * staged->x[p];
+                    fit->sums.y -= staged->y[p];
+                    fit->sums.xy -= staged->x[p] * staged->y[p];
+                }
+            }
+            fit->first = num_packed;
+            result->photons = &staged->points[num_packed];
+            result->elevation.photon_count = ph_in;
+            num_packed += ph_in;
+
+            /* Recalculate Sums When Most Photons Removed (limits cancellation error) */
+            if(ph_in < (num_fit_photons - ph_in))
+            {
+                fit->sums.n = ph_in;
+                kernels->sums(&staged->x[fit->first], &staged->y[fit->first], ph_in, &fit->sums.x, &fit->sums.xx, &fit->sums.y, &fit->sums.xy);
+            }
         }
+        num_photons = num_packed;
+    }
+}
 
-        /* Calculate Latitude, Longitude, and GPS Time using Least Squares Fit */
-        lsf_t fit = lsf(extent, result[t].photons, result[t].elevation.photon_count, true);
-        result[t].elevation.latitude = fit.latitude;
-        result[t].elevation.longitude = fit.longitude;
-        result[t].elevation.delta_time = fit.delta_time;
+/*----------------------------------------------------------------------------
+ * finalizeFit
+ *
+ *  Note: Section 3.6 - Signal, Noise, and Error Estimates
+ *        Section 5.7, procedure 5
+ *----------------------------------------------------------------------------*/
+void Atl06Dispatch::finalizeFit (fit_t* fit, staged_t* staged)
+{
+    result_t* result = fit->result;
+
+    /* Sum Deltas in Photon Heights */
+    double delta_sum = 0.0;
+    for(int p = fit->first; p < fit->first + result->elevation.photon_count; p++)
+    {
+        delta_sum += (staged->r[p] * staged->r[p]);
     }
+
+    /* Calculate RMS and Scale h_sigma */
+    if(!fit->invalid && result->elevation.photon_count > 0)
+    {
+        result->elevation.rms_misfit = sqrt(delta_sum / (double)result->elevation.photon_count);
+        result->elevation.h_sigma = result->elevation.rms_misfit * result->elevation.h_sigma;
+    }
+    else
+    {
+        result->elevation.rms_misfit = 0.0;
+        result->elevation.h_sigma = 0.0;
+    }
+
+    /* Calculate Latitude, Longitude, and GPS Time using Least Squares Fit */
+    lsf_t lsf_fit = lsf(fit->extent, result->photons, result->elevation.photon_count, true);
+    result->elevation.latitude = lsf_fit.latitude;
+    result->elevation.longitude = lsf_fit.longitude;
+    result->elevation.delta_time = lsf_fit.delta_time;
 }
 
 /*----------------------------------------------------------------------------
@@ -673,14 +872,31 @@ int Atl06Dispatch::luaStats (lua_State* L)
         /* Get Clear Parameter */
         bool with_clear = getLuaBoolean(L, 2, true, false);
 
+        /* Merge Statistics of Each Thread (optionally clearing) */
+        stats_t stats;
+        LocalLib::set(&stats, 0, sizeof(stats));
+        lua_obj->batchMutex.lock();
+        {
+            for(int i = 0; i < lua_obj->batches.length(); i++)
+            {
+                batch_t* batch = lua_obj->batches[i];
+                batch->mutex.lock();
+                {
+                    stats.h5atl03_rec_cnt += batch->stats.h5atl03_rec_cnt;
+                    stats.post_success_cnt += batch->stats.post_success_cnt;
+                    stats.post_dropped_cnt += batch->stats.post_dropped_cnt;
+                    if(with_clear) LocalLib::set(&batch->stats, 0, sizeof(batch->stats));
+                }
+                batch->mutex.unlock();
+            }
+        }
+        lua_obj->batchMutex.unlock();
+
         /* Create Statistics Table */
         lua_newtable(L);
-        LuaEngine::setAttrInt(L, "h5atl03",         lua_obj->stats.h5atl03_rec_cnt);
-        LuaEngine::setAttrInt(L, "posted",          lua_obj->stats.post_success_cnt);
-        LuaEngine::setAttrInt(L, "dropped",         lua_obj->stats.post_dropped_cnt);
-
-        /* Optionally Clear */
-        if(with_clear) LocalLib::set(&lua_obj->stats, 0, sizeof(lua_obj->stats));
+        LuaEngine::setAttrInt(L, "h5atl03",         stats.h5atl03_rec_cnt);
+        LuaEngine::setAttrInt(L, "posted",          stats.post_success_cnt);
+        LuaEngine::setAttrInt(L, "dropped",         stats.post_dropped_cnt);
 
         /* Set Success */
         status = true;
@@ -695,6 +911,158 @@ int Atl06Dispatch::luaStats (lua_State* L)
     return returnLuaStatus(L, status, num_obj_to_return);
 }
 
+/*----------------------------------------------------------------------------
+ * Arena::Constructor
+ *----------------------------------------------------------------------------*/
+Atl06Dispatch::Arena::Arena (void)
+{
+    size = INITIAL_SIZE;
+    memory = new unsigned char [size + ALIGNMENT];
+    block = (unsigned char*)(((uintptr_t)memory + ALIGNMENT - 1) & ~((uintptr_t)ALIGNMENT - 1));
+    used = 0;
+    demand = 0;
+}
+
+/*----------------------------------------------------------------------------
+ * Arena::Destructor
+ *----------------------------------------------------------------------------*/
+Atl06Dispatch::Arena::~Arena (void)
+{
+    reset();
+    delete [] memory;
+}
+
+/*----------------------------------------------------------------------------
+ * Arena::alloc
+ *
+ *  returns aligned memory valid until the next reset; requests that do not
+ *  fit in the block are allocated separately and the block is grown to the
+ *  total requested on the next reset
+ *----------------------------------------------------------------------------*/
+void* Atl06Dispatch::Arena::alloc (int bytes)
+{
+    int aligned_bytes = (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    demand += aligned_bytes;
+
+    /* Allocate from Block */
+    if(used + aligned_bytes <= size)
+    {
+        void* ptr = &block[used];
+        used += aligned_bytes;
+        return ptr;
+    }
+
+    /* Allocate Overflow */
+    unsigned char* overflow_memory = new unsigned char [aligned_bytes + ALIGNMENT];
+    overflow.add(overflow_memory);
+    return (void*)(((uintptr_t)overflow_memory + ALIGNMENT - 1) & ~((uintptr_t)ALIGNMENT - 1));
+}
+
+/*----------------------------------------------------------------------------
+ * Arena::reset
+ *----------------------------------------------------------------------------*/
+void Atl06Dispatch::Arena::reset (void)
+{
+    /* Free Overflow */
+    for(int i = 0; i < overflow.length(); i++)
+    {
+        delete [] overflow[i];
+    }
+    overflow.clear();
+
+    /* Grow Block to Previous Demand */
+    if(demand > size)
+    {
+        while(size < demand) size *= 2;
+        delete [] memory;
+        memory = new unsigned char [size + ALIGNMENT];
+        block = (unsigned char*)(((uintptr_t)memory + ALIGNMENT - 1) & ~((uintptr_t)ALIGNMENT - 1));
+    }
+
+    /* Reset Usage */
+    used = 0;
+    demand = 0;
+}
+
+/*----------------------------------------------------------------------------
+ * OrderStatistics::Constructor
+ *----------------------------------------------------------------------------*/
+Atl06Dispatch::OrderStatistics::OrderStatistics (double* _values, uint8_t* _ranked, int _size)
+{
+    values = _values;
+    ranked = _ranked;
+    size = _size;
+    LocalLib::set(ranked, 0, sizeof(uint8_t) * size);
+}
+
+/*----------------------------------------------------------------------------
+ * OrderStatistics::Destructor
+ *----------------------------------------------------------------------------*/
+Atl06Dispatch::OrderStatistics::~OrderStatistics (void)
+{
+}
+
+/*----------------------------------------------------------------------------
+ * OrderStatistics::get
+ *
+ *  quickselect that remembers every value it places in sorted position, so
+ *  walking the order statistics from either end only partitions the values
+ *  that have not yet been ranked; the values returned are identical to those
+ *  of a full sort
+ *----------------------------------------------------------------------------*/
+double Atl06Dispatch::OrderStatistics::get (int k)
+{
+    if(!ranked[k])
+    {
+        /* Find Unranked Span Containing k */
+        int lo = k;
+        int hi = k;
+        while(lo > 0 && !ranked[lo - 1]) lo--;
+        while(hi < size - 1 && !ranked[hi + 1]) hi++;
+
+        /* Partition Span Until k is Ranked */
+        while(true)
+        {
+            /* Median of Three Pivot */
+            double a = values[lo];
+            double b = values[lo + ((hi - lo) / 2)];
+            double c = values[hi];
+            double pivot = MAX(MIN(a, b), MIN(MAX(a, b), c));
+
+            /* Three Way Partition (values equal to pivot are ranked) */
+            int lt = lo;
+            int gt = hi;
+            int i = lo;
+            while(i <= gt)
+            {
+                double v = values[i];
+                if(v < pivot)
+                {
+                    values[i++] = values[lt];
+                    values[lt++] = v;
+                }
+                else if(v > pivot)
+                {
+                    values[i] = values[gt];
+                    values[gt--] = v;
+                }
+                else
+                {
+                    i++;
+                }
+            }
+            for(int j = lt; j <= gt; j++) ranked[j] = true;
+
+            /* Select Side Containing k */
+            if(k < lt)      hi = lt - 1;
+            else if(k > gt) lo = gt + 1;
+            else            break;
+        }
+    }
+
+    return values[k];
+}
+
 /*----------------------------------------------------------------------------
  * lsf - least squares fit
  *
@@ -724,111 +1092,195 @@ int Atl06Dispatch::luaStats (lua_State* L)
  *----------------------------------------------------------------------------*/
 Atl06Dispatch::lsf_t Atl06Dispatch::lsf (Atl03Reader::extent_t* extent, point_t* array, int size, bool final)
 {
-    lsf_t fit;
+    /* Calculate Sums */
+    lsf_sums_t sums;
+    lsfSums(extent, array, size, &sums);
 
-    /* Initialize Fit */
-    fit.height = 0.0;
-    fit.slope = 0.0;
-    fit.y_sigma = 0.0;
-
-    /* Calculate G^T*G and GT*h*/
-    double gtg_11 = size;
-    double gtg_12_21 = 0.0;
-    double gtg_22 = 0.0;
-    for(int p = 0; p < size; p++)
+    /* Height */
+    lsf_t fit = lsfSolve(&sums);
+    if(!final)
     {
-        double x = extent->photons[array[p].p].distance;
-
-        /* Perform Matrix Operation */
-        gtg_12_21 += x;
-        gtg_22 += x * x;
+        return fit;
     }
 
     /* Calculate (G^T*G)^-1 */
-    double det = 1.0 / ((gtg_11 * gtg_22) - (gtg_12_21 * gtg_12_21));
-    double igtg_11 = gtg_22 * det;
-    double igtg_12_21 = -1 * gtg_12_21 * det;
-    double igtg_22 = gtg_11 * det;
+    double det = 1.0 / ((sums.n * sums.xx) - (sums.x * sums.x));
+    double igtg_11 = sums.xx * det;
+    double igtg_12_21 = -1 * sums.x * det;
 
-    if(!final) /* Height */
+    /* Latitude, Longitude, GPS Time */
+    fit.latitude = 0.0;
+    fit.longitude = 0.0;
+    fit.delta_time = 0.0;
+
+    if(size > 0)
     {
+        /* Check Need to Shift Longitudes
+                assumes that there isn't a set of photons with
+                longitudes that extend for more than 30 degrees */
+        double shift_lon = false;
+        double first_lon = extent->photons[array[0].p].longitude;
+        if(first_lon < -150.0 || first_lon > 150.0)
+        {
+            shift_lon = true;
+        }
+
         /* Calculate G^-g and m */
         for(int p = 0; p < size; p++)
         {
             Atl03Reader::photon_t* ph = &extent->photons[array[p].p];
             double x = ph->distance;
-            double y = ph->height;
+            double lat_y = ph->latitude;
+            double lon_y = ph->longitude;
+            double gps_y = ph->delta_time;
+
+            /* Shift Longitudes */
+            if(shift_lon)
+            {
+                if(lon_y < 0.0) lon_y = -lon_y;
+                else            lon_y = 360.0 - lon_y;
+            }
 
             /* Perform Matrix Operation */
             double gig_1 = igtg_11 + (igtg_12_21 * x);   // G^-g row 1 element
-            double gig_2 = igtg_12_21 + (igtg_22 * x);   // G^-g row 2 element
 
             /* Calculate m */
-            fit.height += gig_1 * y;
-            fit.slope += gig_2 * y;
+            fit.latitude += gig_1 * lat_y;
+            fit.longitude += gig_1 * lon_y;
+            fit.delta_time += gig_1 * gps_y;
+        }
 
-            /* Accumulate y_sigma */
-            fit.y_sigma += gig_1 * gig_1;
+        /* Check if Longitude Needs to be Shifted Back */
+        if(shift_lon)
+        {
+            if(fit.longitude < 180.0)   fit.longitude = -fit.longitude;
+            else                        fit.longitude = 360.0 - fit.longitude;
         }
 
-        /* Calculate y_sigma */
-        fit.y_sigma = sqrt(fit.y_sigma);
     }
-    else /* Latitude, Longitude, GPS Time */
+
+    /* Return Fit */
+    return fit;
+}
+
+/*----------------------------------------------------------------------------
+ * lsfSums - running sums from which the least squares fit is solved
+ *
+ *  iterativeFitStage subtracts the photons removed by each iteration from
+ *  the sums instead of recalculating them
+ *----------------------------------------------------------------------------*/
+void Atl06Dispatch::lsfSums (Atl03Reader::extent_t* extent, point_t* array, int size, lsf_sums_t* sums)
+{
+    sums->n = size;
+    sums->x = 0.0;
+    sums->xx = 0.0;
+    sums->y = 0.0;
+    sums->xy = 0.0;
+
+    for(int p = 0; p < size; p++)
     {
-        fit.latitude = 0.0;
-        fit.longitude = 0.0;
-        fit.delta_time = 0.0;
+        Atl03Reader::photon_t* ph = &extent->photons[array[p].p];
+        double x = ph->distance;
+        double y = ph->height;
+
+        sums->x += x;
+        sums->xx += x * x;
+        sums->y += y;
+        sums->xy += x * y;
+    }
+}
 
-        if(size > 0)
-        {
-            /* Check Need to Shift Longitudes
-                    assumes that there isn't a set of photons with
-                    longitudes that extend for more than 30 degrees */
-            double shift_lon = false;
-            double first_lon = extent->photons[array[0].p].longitude;
-            if(first_lon < -150.0 || first_lon > 150.0)
-            {
-                shift_lon = true;
-            }
+/*----------------------------------------------------------------------------
+ * lsfSolve - height, slope, and y_sigma from running sums
+ *
+ *  G^T*G = [n, sum(x); sum(x), sum(x^2)] and G^T*z = [sum(y), sum(x*y)], so
+ *  m = (G^T*G)^-1 * G^T*z; and since G^-g * G^-gT = (G^T*G)^-1, y_sigma is the
+ *  square root of (G^T*G)^-1 at row 1, column 1
+ *----------------------------------------------------------------------------*/
+Atl06Dispatch::lsf_t Atl06Dispatch::lsfSolve (const lsf_sums_t* sums)
+{
+    lsf_t fit;
 
-            /* Calculate G^-g and m */
-            for(int p = 0; p < size; p++)
-            {
-                Atl03Reader::photon_t* ph = &extent->photons[array[p].p];
-                double x = ph->distance;
-                double lat_y = ph->latitude;
-                double lon_y = ph->longitude;
-                double gps_y = ph->delta_time;
-
-                /* Shift Longitudes */
-                if(shift_lon)
-                {
-                    if(lon_y < 0.0) lon_y = -lon_y;
-                    else            lon_y = 360.0 - lon_y;
-                }
+    /* Calculate (G^T*G)^-1 */
+    double det = 1.0 / ((sums->n * sums->xx) - (sums->x * sums->x));
+    double igtg_11 = sums->xx * det;
+    double igtg_12_21 = -1 * sums->x * det;
+    double igtg_22 = sums->n * det;
 
-                /* Perform Matrix Operation */
-                double gig_1 = igtg_11 + (igtg_12_21 * x);   // G^-g row 1 element
+    /* Calculate m */
+    fit.height = (igtg_11 * sums->y) + (igtg_12_21 * sums->xy);
+    fit.slope = (igtg_12_21 * sums->y) + (igtg_22 * sums->xy);
 
-                /* Calculate m */
-                fit.latitude += gig_1 * lat_y;
-                fit.longitude += gig_1 * lon_y;
-                fit.delta_time += gig_1 * gps_y;
-            }
+    /* Calculate y_sigma */
+    fit.y_sigma = sqrt(igtg_11);
 
-            /* Check if Longitude Needs to be Shifted Back */
-            if(shift_lon)
-            {
-                if(fit.longitude < 180.0)   fit.longitude = -fit.longitude;
-                else                        fit.longitude = 360.0 - fit.longitude;
-            }
+    return fit;
+}
 
-        }
+/*----------------------------------------------------------------------------
+ * robustDispersion - robust dispersion estimate of residuals (section 5.9)
+ *
+ *  the residuals are reordered; only the order statistics visited by the
+ *  percentile searches are ranked, which gives the same sigma_r as sorting
+ *  all of the residuals; returns false if the percentiles are out of bounds
+ *----------------------------------------------------------------------------*/
+bool Atl06Dispatch::robustDispersion (double* residuals, uint8_t* ranked, int size, double window_lower_bound, double window_upper_bound, double background_count, double* sigma_r)
+{
+    OrderStatistics residual(residuals, ranked, size);
+
+    /* Continued Inputs to Robust Dispersion Estimate */
+    double background_rate  = background_count / (window_upper_bound - window_lower_bound); // bckgrd, section 5.9, procedure 1a
+    double signal_count     = size - background_count; // N_sig, section 5.9, procedure 1b
+
+    /* Calculate Robust Dispersion Estimate */
+    if(signal_count <= 1)
+    {
+        *sigma_r = (window_upper_bound - window_lower_bound) / size; // section 5.9, procedure 1c
+        return true;
     }
 
-    /* Return Fit */
-    return fit;
+    /* Find Smallest Potential Percentiles (0) */
+    int32_t i0 = 0;
+    while(i0 < size)
+    {
+        double spp = (0.25 * signal_count) + ((residual.get(i0) - window_lower_bound) * background_rate); // section 5.9, procedure 4a
+        if( (((double)i0) + 1.0 - 0.5 + 1.0) < spp )    i0++;   // +1 adjusts for 0 vs 1 based indices, -.5 rounds, +1 looks ahead
+        else                                            break;
+    }
+
+    /* Find Smallest Potential Percentiles (1) */
+    int32_t i1 = size - 1;
+    while(i1 >= 0)
+    {
+        double spp = (0.75 * signal_count) + ((residual.get(i1) - window_lower_bound) * background_rate); // section 5.9, procedure 4a
+        if( (((double)i1) + 1.0 - 0.5 - 1.0) > spp )    i1--;   // +1 adjusts for 0 vs 1 based indices, -.5 rounds, +1 looks ahead
+        else                                            break;
+    }
+
+    /* Check Need to Refind Percentiles */
+    if(i1 < i0)
+    {
+        /* Find Spread of Central Values (0) */
+        double spp0 = (size / 2.0) - (signal_count / 4.0); // section 5.9, procedure 5a
+        i0 = (int32_t)(spp0 + 0.5) - 1;
+
+        /* Find Spread of Central Values (1) */
+        double spp1 = (size / 2.0) + (signal_count / 4.0); // section 5.9, procedure 5b
+        i1 = (int32_t)(spp1 + 0.5);
+    }
+
+    /* Check Validity of Percentiles */
+    if(i0 >= 0 && i1 < size)
+    {
+        /* Calculate Robust Dispersion Estimate */
+        *sigma_r = (residual.get(i1) - residual.get(i0)) / RDE_SCALE_FACTOR; // section 5.9, procedure 6
+        return true;
+    }
+    else
+    {
+        mlog(CRITICAL, "Out of bounds condition caught: %d, %d, %d", i0, i1, size);
+        return false;
+    }
 }
 
 /*----------------------------------------------------------------------------
@@ -36,6 +36,9 @@
  * INCLUDES
  ******************************************************************************/
 
+#include <atomic>
+
+#include "List.h"
 #include "MsgQ.h"
 #include "LuaObject.h"
 #include "RecordObject.h"
@@ -45,6 +48,7 @@
 
 #include "GTArray.h"
 #include "Atl03Reader.h"
+#include "Atl06Kernels.h"
 #include "lua_parms.h"
 
 /******************************************************************************
@@ -66,6 +70,11 @@ class Atl06Dispatch: public DispatchObject
         static const double SIGMA_XMIT;
 
         static const int BATCH_SIZE = 256;
+        static const int STACK_POINTS = 512; // extents with fewer photons are processed without the arena
+        static const int STAGED_ARRAYS = 7; // double arrays in staged_t
+        static const int STAGED_FLAGS = 2; // uint8_t arrays in staged_t
+        static const int POINT_ALIGNMENT = 8; // doubles per cache line
+        static const int BATCH_CACHE_SIZE = 8; // dispatchers a thread remembers its output batch for
 
         static const uint16_t PFLAG_SPREAD_TOO_SHORT        = 0x0001;   // LUA_PARM_ALONG_TRACK_SPREAD
         static const uint16_t PFLAG_TOO_FEW_PHOTONS         = 0x0002;   // LUA_PARM_MIN_PHOTON_COUNT
@@ -91,7 +100,7 @@ class Atl06Dispatch: public DispatchObject
          * Types
          *--------------------------------------------------------------------*/
 
-        /* Statistics --> TODO: NOT THREAD SAFE */
+        /* Statistics (kept per thread, merged on read) */
         typedef struct {
             uint32_t            h5atl03_rec_cnt;
             uint32_t            post_success_cnt;
@@ -140,8 +149,11 @@ class Atl06Dispatch: public DispatchObject
          * Methods
          *--------------------------------------------------------------------*/
 
-        static int  luaCreate   (lua_State* L);
-        static void init        (void);
+        static int  luaCreate       (lua_State* L);
+        static void init            (void);
+
+        void        processExtent   (Atl03Reader::extent_t* extent);
+        void        flushResults    (void);
 
     private:
 
@@ -158,6 +170,15 @@ class Atl06Dispatch: public DispatchObject
             double      delta_time;
         } lsf_t;
 
+        /* Running Sums of Least Squares Fit */
+        typedef struct {
+            double      n;
+            double      x;
+            double      xx;
+            double      y;
+            double      xy;
+        } lsf_sums_t;
+
         typedef struct {
             uint32_t    p;  // index into photon array
             double      r;  // residual
@@ -170,20 +191,101 @@ class Atl06Dispatch: public DispatchObject
             point_t*    photons;
         } result_t;
 
+        /* Staged Photons of All Fits in a Batch (packed in order of fits) */
+        typedef struct {
+            point_t*    points;     // index into extent photons
+            double*     x;          // distance
+            double*     y;          // height
+            double*     r;          // residual of current fit
+            double*     h;          // height of photon's fit (broadcast)
+            double*     slope;      // slope of photon's fit (broadcast)
+            double*     spread;     // half window height of photon's fit (broadcast)
+            double*     residuals;  // scratch for robust dispersion estimate
+            uint8_t*    ranked;     // scratch for robust dispersion estimate
+            uint8_t*    in_window;  // set when photon is kept for next iteration
+        } staged_t;
+
+        /* Iterative Fit of One Track of an Extent */
+        typedef struct {
+            Atl03Reader::extent_t*  extent;
+            result_t*               result;
+            int                     track;
+            int                     first;      // first photon in staged arrays
+            int                     iteration;
+            bool                    done;
+            bool                    invalid;
+            double                  background_density;
+            lsf_sums_t              sums;
+        } fit_t;
+
+        /* Order Statistics of Residuals (partial sort on demand) */
+        class OrderStatistics
+        {
+            public:
+
+                OrderStatistics     (double* _values, uint8_t* _ranked, int _size);
+                ~OrderStatistics    (void);
+
+                double  get         (int k); // k-th smallest value, zero based
+
+            private:
+
+                double*     values;
+                uint8_t*    ranked;     // set when value is in sorted position
+                int         size;
+        };
+
+        /* Per Thread Output Batch */
+        typedef struct {
+            Mutex           mutex;      // only contended when flushed or read by another thread
+            RecordObject*   record;     // allocated on first elevation, handed off to queue when posted
+            int             count;      // elevations in record
+            stats_t         stats;
+        } batch_t;
+
+        /* Thread's Cache of Output Batches (by dispatcher instance) */
+        typedef struct {
+            uint64_t        instance;
+            batch_t*        batch;
+        } batch_entry_t;
+
+        /* Per Thread Scratch Memory (reset for each set of extents) */
+        class Arena
+        {
+            public:
+
+                Arena   (void);
+                ~Arena  (void);
+
+                void*   alloc   (int bytes);
+                void    reset   (void);
+
+            private:
+
+                static const int INITIAL_SIZE = 0x10000; // bytes
+                static const int ALIGNMENT = 64; // bytes
+
+                unsigned char*          memory;     // as allocated
+                unsigned char*          block;      // aligned start of memory
+                int                     size;
+                int                     used;
+                int                     demand;     // bytes requested since last reset
+                List<unsigned char*>    overflow;   // allocations that did not fit in block
+        };
+
         /*--------------------------------------------------------------------
          * Data
          *--------------------------------------------------------------------*/
 
-        RecordObject*           recObj;
-        atl06_compact_t*        recCompactData;
-        atl06_t*                recData;
+        static std::atomic<uint64_t> instanceCount;
+
         Publisher*              outQ;
 
-        Mutex                   elevationMutex;
-        int                     elevationIndex;
+        uint64_t                instanceId;     // never reused, so stale cache entries never match
+        Mutex                   batchMutex;
+        List<batch_t*>          batches;        // output batches of all threads
 
         const atl06_parms_t*    parms;
-        stats_t                 stats;
 
         /*--------------------------------------------------------------------
          * Methods
@@ -197,13 +299,20 @@ class Atl06Dispatch: public DispatchObject
         bool            processTermination              (void) override;
 
         void            calculateBeam                   (sc_orient_t sc_orient, track_t track, result_t* result);
-        void            postResult                      (elevation_t* elevation);
+        batch_t*        getBatch                        (void);
+        void            addElevation                    (batch_t* batch, elevation_t* elevation);
+        void            postBatch                       (batch_t* batch);
 
-        void            iterativeFitStage               (Atl03Reader::extent_t* extent, result_t* result);
+        void            fitExtents                      (Atl03Reader::extent_t** extents, int num_extents);
+        void            iterativeFitStage               (fit_t* fits, int num_fits, staged_t* staged, int num_photons);
+        static void     finalizeFit                     (fit_t* fit, staged_t* staged);
 
         static int      luaStats                        (lua_State* L);
 
         static lsf_t    lsf                             (Atl03Reader::extent_t* extent, point_t* array, int size, bool final);
+        static void     lsfSums                         (Atl03Reader::extent_t* extent, point_t* array, int size, lsf_sums_t* sums);
+        static lsf_t    lsfSolve                        (const lsf_sums_t* sums);
+        static bool     robustDispersion                (double* residuals, uint8_t* ranked, int size, double window_lower_bound, double window_upper_bound, double background_count, double* sigma_r);
         static void     quicksort                       (point_t* array, int start, int end);
         static int      quicksortpartition              (point_t* array, int start, int end);
 
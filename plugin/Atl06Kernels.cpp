@@ -0,0 +1,451 @@
+/*
+ * Copyright (c) 2021, University of Washington
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the University of Washington nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY OF WASHINGTON AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF WASHINGTON OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include <math.h>
+
+#include "core.h"
+#include "Atl06Kernels.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/*
+ * Note: this file must be compiled without floating point contraction
+ * (-ffp-contract=off) so that multiplies and adds are never fused into
+ * a single rounding in one kernel but not in another.
+ */
+
+/******************************************************************************
+ * LOCAL FUNCTIONS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * reduce - combines partial sums in fixed order
+ *----------------------------------------------------------------------------*/
+static inline double reduce (const double* p)
+{
+    return ((p[0] + p[1]) + (p[2] + p[3])) + ((p[4] + p[5]) + (p[6] + p[7]));
+}
+
+/*----------------------------------------------------------------------------
+ * sumsFinish - adds elements past the last full set of lanes and reduces
+ *----------------------------------------------------------------------------*/
+static inline void sumsFinish (const double* x, const double* y, int start, int size,
+                               double* px, double* pxx, double* py, double* pxy,
+                               double* sum_x, double* sum_xx, double* sum_y, double* sum_xy)
+{
+    for(int i = start; i < size; i++)
+    {
+        int k = i - start; // start is a multiple of lanes
+        px[k] += x[i];
+        pxx[k] += x[i] * x[i];
+        py[k] += y[i];
+        pxy[k] += x[i] * y[i];
+    }
+
+    *sum_x = reduce(px);
+    *sum_xx = reduce(pxx);
+    *sum_y = reduce(py);
+    *sum_xy = reduce(pxy);
+}
+
+/*----------------------------------------------------------------------------
+ * residualsFinish - calculates residuals past the last full vector
+ *----------------------------------------------------------------------------*/
+static inline void residualsFinish (const double* x, const double* y, const double* h, const double* slope, int start, int size, double* r)
+{
+    for(int i = start; i < size; i++)
+    {
+        r[i] = y[i] - (h[i] + (x[i] * slope[i]));
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * windowFinish - selects photons past the last full vector
+ *----------------------------------------------------------------------------*/
+static inline void windowFinish (const double* r, const double* spread, int start, int size, uint8_t* in_window)
+{
+    for(int i = start; i < size; i++)
+    {
+        in_window[i] = fabs(r[i]) < spread[i];
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * windowMask - sets flags of photons from bits of comparison mask
+ *----------------------------------------------------------------------------*/
+static inline void windowMask (unsigned mask, int num_lanes, uint8_t* in_window)
+{
+    for(int k = 0; k < num_lanes; k++)
+    {
+        in_window[k] = (mask >> k) & 1;
+    }
+}
+
+/******************************************************************************
+ * SCALAR KERNELS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * sumsScalar
+ *----------------------------------------------------------------------------*/
+static void sumsScalar (const double* x, const double* y, int size, double* sum_x, double* sum_xx, double* sum_y, double* sum_xy)
+{
+    double px[Atl06Kernels::LANES] = {0.0};
+    double pxx[Atl06Kernels::LANES] = {0.0};
+    double py[Atl06Kernels::LANES] = {0.0};
+    double pxy[Atl06Kernels::LANES] = {0.0};
+
+    int n = size - (size % Atl06Kernels::LANES);
+    for(int i = 0; i < n; i += Atl06Kernels::LANES)
+    {
+        for(int k = 0; k < Atl06Kernels::LANES; k++)
+        {
+            double xi = x[i + k];
+            double yi = y[i + k];
+            px[k] += xi;
+            pxx[k] += xi * xi;
+            py[k] += yi;
+            pxy[k] += xi * yi;
+        }
+    }
+
+    sumsFinish(x, y, n, size, px, pxx, py, pxy, sum_x, sum_xx, sum_y, sum_xy);
+}
+
+/*----------------------------------------------------------------------------
+ * residualsScalar
+ *----------------------------------------------------------------------------*/
+static void residualsScalar (const double* x, const double* y, const double* h, const double* slope, int size, double* r)
+{
+    residualsFinish(x, y, h, slope, 0, size, r);
+}
+
+/*----------------------------------------------------------------------------
+ * windowScalar
+ *----------------------------------------------------------------------------*/
+static void windowScalar (const double* r, const double* spread, int size, uint8_t* in_window)
+{
+    windowFinish(r, spread, 0, size, in_window);
+}
+
+#ifdef X86_KERNELS
+
+/******************************************************************************
+ * SSE2 KERNELS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * sumsSSE2
+ *----------------------------------------------------------------------------*/
+static void sumsSSE2 (const double* x, const double* y, int size, double* sum_x, double* sum_xx, double* sum_y, double* sum_xy)
+{
+    __m128d ax[4], axx[4], ay[4], axy[4];
+    for(int j = 0; j < 4; j++)
+    {
+        ax[j] = axx[j] = ay[j] = axy[j] = _mm_setzero_pd();
+    }
+
+    int n = size - (size % Atl06Kernels::LANES);
+    for(int i = 0; i < n; i += Atl06Kernels::LANES)
+    {
+        for(int j = 0; j < 4; j++)
+        {
+            __m128d xv = _mm_loadu_pd(&x[i + (2 * j)]);
+            __m128d yv = _mm_loadu_pd(&y[i + (2 * j)]);
+            ax[j] = _mm_add_pd(ax[j], xv);
+            axx[j] = _mm_add_pd(axx[j], _mm_mul_pd(xv, xv));
+            ay[j] = _mm_add_pd(ay[j], yv);
+            axy[j] = _mm_add_pd(axy[j], _mm_mul_pd(xv, yv));
+        }
+    }
+
+    double px[Atl06Kernels::LANES], pxx[Atl06Kernels::LANES], py[Atl06Kernels::LANES], pxy[Atl06Kernels::LANES];
+    for(int j = 0; j < 4; j++)
+    {
+        _mm_storeu_pd(&px[2 * j], ax[j]);
+        _mm_storeu_pd(&pxx[2 * j], axx[j]);
+        _mm_storeu_pd(&py[2 * j], ay[j]);
+        _mm_storeu_pd(&pxy[2 * j], axy[j]);
+    }
+
+    sumsFinish(x, y, n, size, px, pxx, py, pxy, sum_x, sum_xx, sum_y, sum_xy);
+}
+
+/*----------------------------------------------------------------------------
+ * residualsSSE2
+ *----------------------------------------------------------------------------*/
+static void residualsSSE2 (const double* x, const double* y, const double* h, const double* slope, int size, double* r)
+{
+    int n = size - (size % 2);
+    for(int i = 0; i < n; i += 2)
+    {
+        __m128d mv = _mm_mul_pd(_mm_loadu_pd(&x[i]), _mm_loadu_pd(&slope[i]));
+        _mm_storeu_pd(&r[i], _mm_sub_pd(_mm_loadu_pd(&y[i]), _mm_add_pd(_mm_loadu_pd(&h[i]), mv)));
+    }
+
+    residualsFinish(x, y, h, slope, n, size, r);
+}
+
+/*----------------------------------------------------------------------------
+ * windowSSE2
+ *----------------------------------------------------------------------------*/
+static void windowSSE2 (const double* r, const double* spread, int size, uint8_t* in_window)
+{
+    __m128d sign = _mm_set1_pd(-0.0);
+
+    int n = size - (size % 2);
+    for(int i = 0; i < n; i += 2)
+    {
+        __m128d in = _mm_cmplt_pd(_mm_andnot_pd(sign, _mm_loadu_pd(&r[i])), _mm_loadu_pd(&spread[i]));
+        windowMask(_mm_movemask_pd(in), 2, &in_window[i]);
+    }
+
+    windowFinish(r, spread, n, size, in_window);
+}
+
+/******************************************************************************
+ * AVX2 KERNELS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * sumsAVX2
+ *----------------------------------------------------------------------------*/
+__attribute__((target("avx2")))
+static void sumsAVX2 (const double* x, const double* y, int size, double* sum_x, double* sum_xx, double* sum_y, double* sum_xy)
+{
+    __m256d ax[2], axx[2], ay[2], axy[2];
+    for(int j = 0; j < 2; j++)
+    {
+        ax[j] = axx[j] = ay[j] = axy[j] = _mm256_setzero_pd();
+    }
+
+    int n = size - (size % Atl06Kernels::LANES);
+    for(int i = 0; i < n; i += Atl06Kernels::LANES)
+    {
+        for(int j = 0; j < 2; j++)
+        {
+            __m256d xv = _mm256_loadu_pd(&x[i + (4 * j)]);
+            __m256d yv = _mm256_loadu_pd(&y[i + (4 * j)]);
+            ax[j] = _mm256_add_pd(ax[j], xv);
+            axx[j] = _mm256_add_pd(axx[j], _mm256_mul_pd(xv, xv));
+            ay[j] = _mm256_add_pd(ay[j], yv);
+            axy[j] = _mm256_add_pd(axy[j], _mm256_mul_pd(xv, yv));
+        }
+    }
+
+    double px[Atl06Kernels::LANES], pxx[Atl06Kernels::LANES], py[Atl06Kernels::LANES], pxy[Atl06Kernels::LANES];
+    for(int j = 0; j < 2; j++)
+    {
+        _mm256_storeu_pd(&px[4 * j], ax[j]);
+        _mm256_storeu_pd(&pxx[4 * j], axx[j]);
+        _mm256_storeu_pd(&py[4 * j], ay[j]);
+        _mm256_storeu_pd(&pxy[4 * j], axy[j]);
+    }
+
+    sumsFinish(x, y, n, size, px, pxx, py, pxy, sum_x, sum_xx, sum_y, sum_xy);
+}
+
+/*----------------------------------------------------------------------------
+ * residualsAVX2
+ *----------------------------------------------------------------------------*/
+__attribute__((target("avx2")))
+static void residualsAVX2 (const double* x, const double* y, const double* h, const double* slope, int size, double* r)
+{
+    int n = size - (size % 4);
+    for(int i = 0; i < n; i += 4)
+    {
+        __m256d mv = _mm256_mul_pd(_mm256_loadu_pd(&x[i]), _mm256_loadu_pd(&slope[i]));
+        _mm256_storeu_pd(&r[i], _mm256_sub_pd(_mm256_loadu_pd(&y[i]), _mm256_add_pd(_mm256_loadu_pd(&h[i]), mv)));
+    }
+
+    residualsFinish(x, y, h, slope, n, size, r);
+}
+
+/*----------------------------------------------------------------------------
+ * windowAVX2
+ *----------------------------------------------------------------------------*/
+__attribute__((target("avx2")))
+static void windowAVX2 (const double* r, const double* spread, int size, uint8_t* in_window)
+{
+    __m256d sign = _mm256_set1_pd(-0.0);
+
+    int n = size - (size % 4);
+    for(int i = 0; i < n; i += 4)
+    {
+        __m256d in = _mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_loadu_pd(&r[i])), _mm256_loadu_pd(&spread[i]), _CMP_LT_OQ);
+        windowMask(_mm256_movemask_pd(in), 4, &in_window[i]);
+    }
+
+    windowFinish(r, spread, n, size, in_window);
+}
+
+/******************************************************************************
+ * AVX-512 KERNELS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * sumsAVX512
+ *----------------------------------------------------------------------------*/
+__attribute__((target("avx512f")))
+static void sumsAVX512 (const double* x, const double* y, int size, double* sum_x, double* sum_xx, double* sum_y, double* sum_xy)
+{
+    __m512d ax = _mm512_setzero_pd();
+    __m512d axx = _mm512_setzero_pd();
+    __m512d ay = _mm512_setzero_pd();
+    __m512d axy = _mm512_setzero_pd();
+
+    int n = size - (size % Atl06Kernels::LANES);
+    for(int i = 0; i < n; i += Atl06Kernels::LANES)
+    {
+        __m512d xv = _mm512_loadu_pd(&x[i]);
+        __m512d yv = _mm512_loadu_pd(&y[i]);
+        ax = _mm512_add_pd(ax, xv);
+        axx = _mm512_add_pd(axx, _mm512_mul_pd(xv, xv));
+        ay = _mm512_add_pd(ay, yv);
+        axy = _mm512_add_pd(axy, _mm512_mul_pd(xv, yv));
+    }
+
+    double px[Atl06Kernels::LANES], pxx[Atl06Kernels::LANES], py[Atl06Kernels::LANES], pxy[Atl06Kernels::LANES];
+    _mm512_storeu_pd(px, ax);
+    _mm512_storeu_pd(pxx, axx);
+    _mm512_storeu_pd(py, ay);
+    _mm512_storeu_pd(pxy, axy);
+
+    sumsFinish(x, y, n, size, px, pxx, py, pxy, sum_x, sum_xx, sum_y, sum_xy);
+}
+
+/*----------------------------------------------------------------------------
+ * residualsAVX512
+ *----------------------------------------------------------------------------*/
+__attribute__((target("avx512f")))
+static void residualsAVX512 (const double* x, const double* y, const double* h, const double* slope, int size, double* r)
+{
+    int n = size - (size % 8);
+    for(int i = 0; i < n; i += 8)
+    {
+        __m512d mv = _mm512_mul_pd(_mm512_loadu_pd(&x[i]), _mm512_loadu_pd(&slope[i]));
+        _mm512_storeu_pd(&r[i], _mm512_sub_pd(_mm512_loadu_pd(&y[i]), _mm512_add_pd(_mm512_loadu_pd(&h[i]), mv)));
+    }
+
+    residualsFinish(x, y, h, slope, n, size, r);
+}
+
+/*----------------------------------------------------------------------------
+ * windowAVX512
+ *----------------------------------------------------------------------------*/
+__attribute__((target("avx512f")))
+static void windowAVX512 (const double* r, const double* spread, int size, uint8_t* in_window)
+{
+    int n = size - (size % 8);
+    for(int i = 0; i < n; i += 8)
+    {
+        __mmask8 in = _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_loadu_pd(&r[i])), _mm512_loadu_pd(&spread[i]), _CMP_LT_OQ);
+        windowMask(in, 8, &in_window[i]);
+    }
+
+    windowFinish(r, spread, n, size, in_window);
+}
+
+#endif /* X86_KERNELS */
+
+/******************************************************************************
+ * STATIC DATA
+ ******************************************************************************/
+
+static const Atl06Kernels::kernels_t kernelTable[Atl06Kernels::NUM_ISAS] = {
+    {Atl06Kernels::SCALAR,  "scalar",   sumsScalar,     residualsScalar,    windowScalar},
+#ifdef X86_KERNELS
+    {Atl06Kernels::SSE2,    "sse2",     sumsSSE2,       residualsSSE2,      windowSSE2},
+    {Atl06Kernels::AVX2,    "avx2",     sumsAVX2,       residualsAVX2,      windowAVX2},
+    {Atl06Kernels::AVX512,  "avx512",   sumsAVX512,     residualsAVX512,    windowAVX512}
+#else
+    {Atl06Kernels::SSE2,    "sse2",     NULL,           NULL,               NULL},
+    {Atl06Kernels::AVX2,    "avx2",     NULL,           NULL,               NULL},
+    {Atl06Kernels::AVX512,  "avx512",   NULL,           NULL,               NULL}
+#endif
+};
+
+const Atl06Kernels::kernels_t* Atl06Kernels::active = &kernelTable[SCALAR];
+
+/******************************************************************************
+ * PUBLIC METHODS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * init - selects the widest kernels supported by the processor
+ *----------------------------------------------------------------------------*/
+void Atl06Kernels::init (void)
+{
+#ifdef X86_KERNELS
+    __builtin_cpu_init();
+#endif
+
+    for(int isa = NUM_ISAS - 1; isa >= SCALAR; isa--)
+    {
+        const kernels_t* kernels = get((isa_t)isa);
+        if(kernels)
+        {
+            active = kernels;
+            break;
+        }
+    }
+
+    mlog(INFO, "ATL06 kernels selected: %s", active->name);
+}
+
+/*----------------------------------------------------------------------------
+ * get
+ *----------------------------------------------------------------------------*/
+const Atl06Kernels::kernels_t* Atl06Kernels::get (isa_t isa)
+{
+    bool supported = false;
+
+    switch(isa)
+    {
+        case SCALAR:    supported = true; break;
+#ifdef X86_KERNELS
+        case SSE2:      supported = true; break; // baseline of x86_64
+        case AVX2:      supported = __builtin_cpu_supports("avx2"); break;
+        case AVX512:    supported = __builtin_cpu_supports("avx512f"); break;
+#endif
+        default:        supported = false; break;
+    }
+
+    if(supported)   return &kernelTable[isa];
+    else            return NULL;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2021, University of Washington
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the University of Washington nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY OF WASHINGTON AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF WASHINGTON OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __atl06_kernels__
+#define __atl06_kernels__
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include "OsApi.h"
+
+/******************************************************************************
+ * ATL06 KERNELS CLASS
+ ******************************************************************************/
+
+/*
+ * Vectorized loops of the ATL06 iterative fit, operating on contiguous
+ * arrays of photon distances (x), heights (y), and residuals (r); the photons
+ * of many fits can be processed in one call since the fit parameters are
+ * provided per photon.  Sums are
+ * accumulated in eight interleaved partial sums that are combined in a fixed
+ * order, so every instruction set produces the same bits as the scalar kernels.
+ */
+class Atl06Kernels
+{
+    public:
+
+        /*--------------------------------------------------------------------
+         * Constants
+         *--------------------------------------------------------------------*/
+
+        static const int LANES = 8; // number of partial sums
+
+        /*--------------------------------------------------------------------
+         * Types
+         *--------------------------------------------------------------------*/
+
+        typedef enum {
+            SCALAR = 0,
+            SSE2 = 1,
+            AVX2 = 2,
+            AVX512 = 3,
+            NUM_ISAS = 4
+        } isa_t;
+
+        /* Sum of x, x^2, y, and x*y */
+        typedef void (*sums_f) (const double* x, const double* y, int size, double* sum_x, double* sum_xx, double* sum_y, double* sum_xy);
+
+        /* r = y - (h + x*slope), with the fit of each photon given per photon */
+        typedef void (*residuals_f) (const double* x, const double* y, const double* h, const double* slope, int size, double* r);
+
+        /* in_window = |r| < spread, with the window of each photon given per photon */
+        typedef void (*window_f) (const double* r, const double* spread, int size, uint8_t* in_window);
+
+        typedef struct {
+            isa_t           isa;
+            const char*     name;
+            sums_f          sums;
+            residuals_f     residuals;
+            window_f        window;
+        } kernels_t;
+
+        /*--------------------------------------------------------------------
+         * Data
+         *--------------------------------------------------------------------*/
+
+        static const kernels_t* active; // selected at init, scalar until then
+
+        /*--------------------------------------------------------------------
+         * Methods
+         *--------------------------------------------------------------------*/
+
+        static void             init        (void);
+        static const kernels_t* get         (isa_t isa); // NULL if not supported by processor
+};
+
+#endif  /* __atl06_kernels__ */
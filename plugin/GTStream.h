@@ -0,0 +1,609 @@
+/*
+ * Copyright (c) 2021, University of Washington
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the University of Washington nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY OF WASHINGTON AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF WASHINGTON OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __gtstream__
+#define __gtstream__
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include "H5Array.h"
+
+#include "StringLib.h"
+#include "Asset.h"
+#include "OsApi.h"
+
+#include "GTArray.h"
+#include "GranuleCache.h"
+#include "ReaderPool.h"
+
+/******************************************************************************
+ * GTStream TEMPLATE
+ *
+ *  reads a dataset of each pair track in windows of rows instead of all at
+ *  once; windows end on multiples of the window size (so that they line up
+ *  with the chunks of the dataset when the window size is a multiple of the
+ *  chunk size) and are read in the background by the urgent workers of the
+ *  reader pool - the first when the stream is constructed and each
+ *  following one while the one before it is used (a window no worker has
+ *  started reading when it is needed is read by the stream itself);
+ *  rows are accessed in increasing order except for rows not yet released,
+ *  which are carried over into the next window; when the granule cache is
+ *  enabled, windows are built from the fixed blocks of rows it caches
+ *  (reading and caching the blocks not found)
+ ******************************************************************************/
+
+template <class T>
+class GTStream
+{
+    public:
+
+        /*--------------------------------------------------------------------
+         * Types
+         *--------------------------------------------------------------------*/
+
+        /* Stream of a Single Pair Track */
+        class Track
+        {
+            public:
+
+                        Track       (void);
+                        ~Track      (void);
+
+                void    open        (const Asset* _asset, const char* _resource, const char* _dataset, H5Api::context_t* _context, long _col, long _startrow, long _numrows, long _window_rows);
+                void    join        (void);
+                void    release     (long row);
+                long    find        (T value);
+
+                inline T& operator[] (long row)
+                {
+                    if((unsigned long)(row - base) < (unsigned long)length) return data[row - base];
+                    else return advance(row);
+                }
+
+                long    size;   // rows in stream (elements when read in a single window, ALL_ROWS until joined when not known)
+                long    windows_read;
+                long    windows_waited; // windows still being read when needed
+
+            private:
+
+                T&      advance     (long row);
+                long    windowRows  (void);
+                void    prefetch    (void);
+                void    complete    (bool needed);
+                void    wait        (void);
+                void    install     (void);
+
+                GranuleCache::entry_t* acquireBlock (long block_row, long block_rows);
+                GranuleCache::entry_t* readEntry (const char* key, long first_row, long num_rows);
+
+                static void* prefetchTask (void* parm);
+
+                const Asset*        asset;
+                const char*         resource;
+                char*               dataset;
+                H5Api::context_t*   context;
+                long                col;
+                long                startrow;
+                long                window_rows;
+
+                T*                  data;       // rows [base, base + length) of stream
+                long                base;
+                long                length;
+                H5Array<T>*         array;      // window as read (when nothing carried over and not cached)
+                GranuleCache::entry_t* entry;   // block or dataset holding window (when nothing carried over)
+                T*                  buffer;     // window built from blocks or with rows carried over from previous window
+                long                mark;       // rows before mark are no longer needed
+
+                bool                pending;    // next window submitted to reader pool
+                Cond                readCond;
+                bool                ready;      // next window read (protected by readCond)
+                H5Array<T>*         next;
+                GranuleCache::entry_t* next_entry;
+                T*                  next_buffer;
+                T*                  next_data;  // of next, next_entry, or next_buffer
+                long                next_size;
+                long                next_base;
+
+                /* Unit Tests (fill streams with rows not read from a file) */
+                friend class UT_Atl03Reader;
+        };
+
+        /*--------------------------------------------------------------------
+         * Methods
+         *--------------------------------------------------------------------*/
+
+                    GTStream    (const Asset* asset, const char* resource, int track, const char* gt_dataset, H5Api::context_t* context, long col=0, const long* prt_startrow=GTArray<T>::DefaultStartRow, const long* prt_numrows=GTArray<T>::DefaultNumRows, long window_rows=H5Api::ALL_ROWS);
+        virtual     ~GTStream   (void);
+
+        void        join        (void);
+        void        release     (const int32_t* prt_row);
+
+        /*--------------------------------------------------------------------
+         * Data
+         *--------------------------------------------------------------------*/
+
+        Track gt[PAIR_TRACKS_PER_GROUND_TRACK];
+};
+
+/******************************************************************************
+ * GTStream METHODS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * Constructor
+ *
+ *  starts reading the first window of each pair track; a prt_numrows of
+ *  ALL_ROWS reads the rest of the pair track in a single window (its size
+ *  is known once joined), a prt_numrows of zero reads nothing, and a
+ *  window_rows of ALL_ROWS reads each pair track in a single window (the
+ *  only way to read more than one column, i.e. col of ALL_COLS)
+ *----------------------------------------------------------------------------*/
+template <class T>
+GTStream<T>::GTStream(const Asset* asset, const char* resource, int track, const char* gt_dataset, H5Api::context_t* context, long col, const long* prt_startrow, const long* prt_numrows, long window_rows)
+{
+    gt[PRT_LEFT].open(asset, resource, SafeString("/gt%dl/%s", track, gt_dataset).getString(), context, col, prt_startrow[PRT_LEFT], prt_numrows[PRT_LEFT], window_rows);
+    gt[PRT_RIGHT].open(asset, resource, SafeString("/gt%dr/%s", track, gt_dataset).getString(), context, col, prt_startrow[PRT_RIGHT], prt_numrows[PRT_RIGHT], window_rows);
+}
+
+/*----------------------------------------------------------------------------
+ * Destructor
+ *----------------------------------------------------------------------------*/
+template <class T>
+GTStream<T>::~GTStream(void)
+{
+}
+
+/*----------------------------------------------------------------------------
+ * join
+ *
+ *  waits for the first window of each pair track
+ *----------------------------------------------------------------------------*/
+template <class T>
+void GTStream<T>::join(void)
+{
+    gt[PRT_LEFT].join();
+    gt[PRT_RIGHT].join();
+}
+
+/*----------------------------------------------------------------------------
+ * release
+ *----------------------------------------------------------------------------*/
+template <class T>
+void GTStream<T>::release(const int32_t* prt_row)
+{
+    gt[PRT_LEFT].release(prt_row[PRT_LEFT]);
+    gt[PRT_RIGHT].release(prt_row[PRT_RIGHT]);
+}
+
+/*----------------------------------------------------------------------------
+ * Track::Constructor
+ *----------------------------------------------------------------------------*/
+template <class T>
+GTStream<T>::Track::Track(void)
+{
+    size = 0;
+    asset = NULL;
+    resource = NULL;
+    dataset = NULL;
+    context = NULL;
+    col = 0;
+    startrow = 0;
+    window_rows = H5Api::ALL_ROWS;
+    data = NULL;
+    base = 0;
+    length = 0;
+    array = NULL;
+    entry = NULL;
+    buffer = NULL;
+    mark = 0;
+    pending = false;
+    ready = false;
+    next = NULL;
+    next_entry = NULL;
+    next_buffer = NULL;
+    next_data = NULL;
+    next_size = 0;
+    next_base = 0;
+    windows_read = 0;
+    windows_waited = 0;
+}
+
+/*----------------------------------------------------------------------------
+ * Track::Destructor
+ *----------------------------------------------------------------------------*/
+template <class T>
+GTStream<T>::Track::~Track(void)
+{
+    if(pending) complete(false);
+    if(next) delete next;
+    if(next_entry) GranuleCache::release(next_entry);
+    if(next_buffer) delete [] next_buffer;
+    if(array) delete array;
+    if(entry) GranuleCache::release(entry);
+    if(buffer) delete [] buffer;
+    if(dataset) delete [] dataset;
+}
+
+/*----------------------------------------------------------------------------
+ * Track::open
+ *----------------------------------------------------------------------------*/
+template <class T>
+void GTStream<T>::Track::open(const Asset* _asset, const char* _resource, const char* _dataset, H5Api::context_t* _context, long _col, long _startrow, long _numrows, long _window_rows)
+{
+    asset = _asset;
+    resource = _resource;
+    dataset = StringLib::duplicate(_dataset);
+    context = _context;
+    col = _col;
+    startrow = _startrow;
+    size = _numrows;
+    window_rows = (_numrows == H5Api::ALL_ROWS) ? H5Api::ALL_ROWS : _window_rows;
+
+    /* Start Reading First Window */
+    if(size != 0) prefetch();
+}
+
+/*----------------------------------------------------------------------------
+ * Track::join
+ *----------------------------------------------------------------------------*/
+template <class T>
+void GTStream<T>::Track::join(void)
+{
+    if(!data && pending)
+    {
+        wait();
+        install();
+        prefetch();
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Track::release
+ *----------------------------------------------------------------------------*/
+template <class T>
+void GTStream<T>::Track::release(long row)
+{
+    if(row > mark) mark = row;
+}
+
+/*----------------------------------------------------------------------------
+ * Track::find
+ *
+ *  binary search for the first row no less than the value given; the rows
+ *  must be in increasing order and read in a single window
+ *----------------------------------------------------------------------------*/
+template <class T>
+long GTStream<T>::Track::find(T value)
+{
+    long lower = 0;
+    long upper = size;
+    while(lower < upper)
+    {
+        long middle = lower + ((upper - lower) / 2);
+        if((*this)[middle] < value) lower = middle + 1;
+        else upper = middle;
+    }
+    return lower;
+}
+
+/*----------------------------------------------------------------------------
+ * Track::advance
+ *----------------------------------------------------------------------------*/
+template <class T>
+T& GTStream<T>::Track::advance(long row)
+{
+    /* Wait for First Window */
+    join();
+
+    if(row < base || row >= size)
+    {
+        throw RunTimeException(CRITICAL, "row %ld not available in stream of %s [%ld, %ld)", row, dataset, base, base + length);
+    }
+
+    /* Move Through Windows to Row */
+    while(row >= base + length)
+    {
+        wait();
+        install();
+        prefetch();
+    }
+
+    return data[row - base];
+}
+
+/*----------------------------------------------------------------------------
+ * Track::windowRows
+ *
+ *  rows of the window starting at next_base; the window ends on a multiple
+ *  of the window size or at the end of the stream
+ *----------------------------------------------------------------------------*/
+template <class T>
+long GTStream<T>::Track::windowRows(void)
+{
+    if(size == H5Api::ALL_ROWS) return H5Api::ALL_ROWS;
+
+    long rows = size - next_base;
+    if(window_rows > 0 && window_rows < rows)
+    {
+        rows = window_rows - ((startrow + next_base) % window_rows);
+    }
+
+    return rows;
+}
+
+/*----------------------------------------------------------------------------
+ * Track::prefetch
+ *----------------------------------------------------------------------------*/
+template <class T>
+void GTStream<T>::Track::prefetch(void)
+{
+    next_base = base + length;
+    if(size == H5Api::ALL_ROWS || next_base < size)
+    {
+        ready = false;
+        pending = true;
+        ReaderPool::submit(prefetchTask, this, this, true);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Track::complete
+ *
+ *  finishes the read of the next window: a read no worker has started is
+ *  withdrawn from the reader pool and made here (or dropped when the window
+ *  is not needed), otherwise the read is waited on
+ *----------------------------------------------------------------------------*/
+template <class T>
+void GTStream<T>::Track::complete(bool needed)
+{
+    List<void*> withdrawn;
+    if(ReaderPool::withdraw(this, &withdrawn) > 0)
+    {
+        if(needed)
+        {
+            windows_waited++;
+            prefetchTask(this);
+        }
+    }
+    else
+    {
+        readCond.lock();
+        {
+            if(!ready) windows_waited++;
+            while(!ready)
+            {
+                readCond.wait(0, SYS_TIMEOUT);
+            }
+        }
+        readCond.unlock();
+    }
+
+    pending = false;
+}
+
+/*----------------------------------------------------------------------------
+ * Track::wait
+ *----------------------------------------------------------------------------*/
+template <class T>
+void GTStream<T>::Track::wait(void)
+{
+    if(pending)
+    {
+        windows_read++;
+        complete(true);
+    }
+
+    if(!next && !next_entry && !next_buffer)
+    {
+        throw RunTimeException(CRITICAL, "failed to read rows starting at %ld of %s", startrow + next_base, dataset);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Track::install
+ *
+ *  makes the window just read current, carrying over the rows of the
+ *  current window that have not been released
+ *----------------------------------------------------------------------------*/
+template <class T>
+void GTStream<T>::Track::install(void)
+{
+    long carry_from = MAX(mark, base);
+    long carry = (base + length) - carry_from;
+    if(carry <= 0)
+    {
+        if(array) delete array;
+        if(entry) GranuleCache::release(entry);
+        if(buffer) delete [] buffer;
+        array = next;
+        entry = next_entry;
+        buffer = next_buffer;
+        data = next_data;
+        base = next_base;
+        length = next_size;
+    }
+    else
+    {
+        T* merged = new T [carry + next_size];
+        LocalLib::copy(merged, &data[carry_from - base], carry * sizeof(T));
+        LocalLib::copy(&merged[carry], next_data, next_size * sizeof(T));
+        if(array) delete array;
+        if(entry) GranuleCache::release(entry);
+        if(buffer) delete [] buffer;
+        array = NULL;
+        entry = NULL;
+        buffer = merged;
+        data = merged;
+        base = carry_from;
+        length = carry + next_size;
+        if(next) delete next;
+        if(next_entry) GranuleCache::release(next_entry);
+        if(next_buffer) delete [] next_buffer;
+    }
+    next = NULL;
+    next_entry = NULL;
+    next_buffer = NULL;
+    next_data = NULL;
+
+    /* Set Size of Stream Read in Single Window (as GTArray) */
+    if(window_rows == H5Api::ALL_ROWS) size = length;
+}
+
+/*----------------------------------------------------------------------------
+ * Track::acquireBlock
+ *
+ *  returns the cached block of rows starting at block_row (to be released
+ *  once no longer used), reading and caching it when not found
+ *----------------------------------------------------------------------------*/
+template <class T>
+GranuleCache::entry_t* GTStream<T>::Track::acquireBlock(long block_row, long block_rows)
+{
+    SafeString key("%s/%s%s:%ld:%ld:%ld", asset->getName(), resource, dataset, col, block_row, block_rows);
+    GranuleCache::entry_t* block = GranuleCache::acquire(key.getString());
+    if(!block) block = readEntry(key.getString(), block_row, block_rows);
+    return block;
+}
+
+/*----------------------------------------------------------------------------
+ * Track::readEntry
+ *
+ *  reads rows of the dataset and hands them to the granule cache (which
+ *  takes over the memory read instead of copying it)
+ *----------------------------------------------------------------------------*/
+template <class T>
+GranuleCache::entry_t* GTStream<T>::Track::readEntry(const char* key, long first_row, long num_rows)
+{
+    H5Array<T>* rows = new H5Array<T>(asset, resource, dataset, context, col, first_row, num_rows);
+    long elements = rows->size;
+    unsigned char* rows_data = (unsigned char*)rows->data;
+    rows->data = NULL; // taken over by cache
+    delete rows;
+    return GranuleCache::insert(key, rows_data, elements, elements * sizeof(T));
+}
+
+/*----------------------------------------------------------------------------
+ * Track::prefetchTask
+ *
+ *  reads the next window directly when the granule cache is disabled;
+ *  otherwise the window is built from the blocks of rows covering it, and
+ *  points into its block when it falls in a single block (the rest of a
+ *  dataset, whose size is not known, is cached as a whole); the block at
+ *  the end of the stream stops at the end of the stream since the rows of
+ *  the dataset past it are not known
+ *----------------------------------------------------------------------------*/
+template <class T>
+void* GTStream<T>::Track::prefetchTask(void* parm)
+{
+    Track* track = (Track*)parm;
+
+    try
+    {
+        long first_row = track->startrow + track->next_base;
+        long num_rows = track->windowRows();
+
+        if(!GranuleCache::enabled())
+        {
+            /* Read Window */
+            track->next = new H5Array<T>(track->asset, track->resource, track->dataset, track->context, track->col, first_row, num_rows);
+            track->next_data = track->next->data;
+            track->next_size = track->next->size;
+        }
+        else if(num_rows == H5Api::ALL_ROWS)
+        {
+            /* Look Up Rest of Dataset */
+            SafeString key("%s/%s%s:%ld:%ld:all", track->asset->getName(), track->resource, track->dataset, track->col, first_row);
+            track->next_entry = GranuleCache::acquire(key.getString());
+            if(!track->next_entry) track->next_entry = track->readEntry(key.getString(), first_row, H5Api::ALL_ROWS);
+            track->next_data = (T*)track->next_entry->data;
+            track->next_size = track->next_entry->elements;
+        }
+        else
+        {
+            /* Build Window from Blocks */
+            long last_row = first_row + num_rows;
+            long stream_end = track->startrow + track->size;
+            long first_block = first_row / GranuleCache::BLOCK_ROWS;
+            long last_block = (last_row - 1) / GranuleCache::BLOCK_ROWS;
+            for(long b = first_block; b <= last_block; b++)
+            {
+                long block_row = b * GranuleCache::BLOCK_ROWS;
+                long block_rows = MIN(GranuleCache::BLOCK_ROWS, stream_end - block_row);
+                GranuleCache::entry_t* block = track->acquireBlock(block_row, block_rows);
+
+                long row_elements = block->elements / block_rows; // columns read
+                long from_row = MAX(first_row, block_row);
+                long to_row = MIN(last_row, block_row + block_rows);
+                T* block_data = (T*)block->data + ((from_row - block_row) * row_elements);
+
+                if(first_block == last_block)
+                {
+                    /* Point into Block */
+                    track->next_entry = block;
+                    track->next_data = block_data;
+                    track->next_size = (to_row - from_row) * row_elements;
+                }
+                else
+                {
+                    /* Copy Rows of Block into Window */
+                    if(!track->next_buffer) track->next_buffer = new T [num_rows * row_elements];
+                    LocalLib::copy(&track->next_buffer[(from_row - first_row) * row_elements], block_data, (to_row - from_row) * row_elements * sizeof(T));
+                    GranuleCache::release(block);
+                    track->next_data = track->next_buffer;
+                    track->next_size = (to_row - first_row) * row_elements;
+                }
+            }
+        }
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Failed to read ahead in %s: %s", track->dataset, e.what());
+        if(track->next) delete track->next;
+        if(track->next_entry) GranuleCache::release(track->next_entry);
+        if(track->next_buffer) delete [] track->next_buffer;
+        track->next = NULL;
+        track->next_entry = NULL;
+        track->next_buffer = NULL;
+    }
+
+    /* Signal Window Read */
+    track->readCond.lock();
+    {
+        track->ready = true;
+        track->readCond.signal();
+    }
+    track->readCond.unlock();
+
+    return NULL;
+}
+
+#endif  /* __gtstream__ */
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2021, University of Washington
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the University of Washington nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY OF WASHINGTON AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF WASHINGTON OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include "core.h"
+#include "icesat2.h"
+
+/******************************************************************************
+ * DEFINES
+ ******************************************************************************/
+
+#define LUA_STAT_CACHE_HITS             "hits"
+#define LUA_STAT_CACHE_MISSES           "misses"
+#define LUA_STAT_CACHE_EVICTIONS        "evictions"
+#define LUA_STAT_CACHE_ENTRIES          "entries"
+#define LUA_STAT_CACHE_SIZE             "size"
+
+/******************************************************************************
+ * STATIC DATA
+ ******************************************************************************/
+
+Mutex GranuleCache::cacheMut;
+Dictionary<GranuleCache::entry_t*> GranuleCache::entries;
+GranuleCache::entry_t* GranuleCache::newest = NULL;
+GranuleCache::entry_t* GranuleCache::oldest = NULL;
+long GranuleCache::cacheSize = 0;
+long GranuleCache::maxSize = DEFAULT_MAX_SIZE;
+uint64_t GranuleCache::hits = 0;
+uint64_t GranuleCache::misses = 0;
+uint64_t GranuleCache::evictions = 0;
+
+/******************************************************************************
+ * GRANULE CACHE CLASS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * acquire
+ *
+ *  returns the entry of the key (to be released once no longer used), or
+ *  NULL when not cached
+ *----------------------------------------------------------------------------*/
+GranuleCache::entry_t* GranuleCache::acquire (const char* key)
+{
+    entry_t* entry = NULL;
+
+    cacheMut.lock();
+    {
+        if(entries.find(key, &entry))
+        {
+            entry->refs++;
+            touch(entry);
+            hits++;
+        }
+        else
+        {
+            misses++;
+        }
+    }
+    cacheMut.unlock();
+
+    return entry;
+}
+
+/*----------------------------------------------------------------------------
+ * insert
+ *
+ *  caches the data read for the key, taking over its memory (allocated with
+ *  new []), and returns its entry (to be released once no longer used); when
+ *  the data does not fit in the cache the entry returned is not cached and
+ *  is freed once released, and when another reader has cached the key in the
+ *  meantime, its entry is returned instead
+ *----------------------------------------------------------------------------*/
+GranuleCache::entry_t* GranuleCache::insert (const char* key, unsigned char* data, long elements, long size)
+{
+    entry_t* entry = new entry_t;
+    entry->key = StringLib::duplicate(key);
+    entry->data = data;
+    entry->elements = elements;
+    entry->size = size;
+    entry->refs = 1;
+    entry->evicted = true;
+    entry->counted = false;
+    entry->newer = NULL;
+    entry->older = NULL;
+
+    cacheMut.lock();
+    {
+        entry_t* cached = NULL;
+        if(entries.find(key, &cached))
+        {
+            /* Use Entry Cached by Another Reader */
+            freeEntry(entry);
+            entry = cached;
+            entry->refs++;
+            touch(entry);
+        }
+        else if(size <= maxSize)
+        {
+            /* Make Room and Add Entry as Most Recently Used (unless entries in use fill the cache) */
+            evict(size);
+            if(cacheSize + size <= maxSize)
+            {
+                entry->evicted = false;
+                entry->counted = true;
+                entries.add(key, entry);
+                touch(entry);
+                cacheSize += size;
+            }
+        }
+    }
+    cacheMut.unlock();
+
+    return entry;
+}
+
+/*----------------------------------------------------------------------------
+ * release
+ *----------------------------------------------------------------------------*/
+void GranuleCache::release (entry_t* entry)
+{
+    cacheMut.lock();
+    {
+        entry->refs--;
+        if(entry->refs == 0 && entry->evicted)
+        {
+            freeEntry(entry);
+        }
+    }
+    cacheMut.unlock();
+}
+
+/*----------------------------------------------------------------------------
+ * enabled
+ *----------------------------------------------------------------------------*/
+bool GranuleCache::enabled (void)
+{
+    bool status;
+
+    cacheMut.lock();
+    {
+        status = maxSize > 0;
+    }
+    cacheMut.unlock();
+
+    return status;
+}
+
+/*----------------------------------------------------------------------------
+ * luaSize - cache([<max size in MB>])
+ *
+ *  sets the maximum size of the cache (when provided, zero disables it) and
+ *  returns it; lowering it evicts the entries over it
+ *----------------------------------------------------------------------------*/
+int GranuleCache::luaSize (lua_State* L)
+{
+    try
+    {
+        bool provided = false;
+        long max_mb = LuaObject::getLuaInteger(L, 1, true, 0, &provided);
+        if(provided)
+        {
+            if(max_mb < 0)
+            {
+                throw RunTimeException(CRITICAL, "invalid granule cache size: %ld", max_mb);
+            }
+
+            cacheMut.lock();
+            {
+                maxSize = max_mb * 0x100000;
+                evict(0);
+            }
+            cacheMut.unlock();
+        }
+
+        lua_pushinteger(L, maxSize / 0x100000);
+        return 1;
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Error configuring granule cache: %s", e.what());
+        return LuaObject::returnLuaStatus(L, false);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * luaStats - cachestats([<with_clear>]) --> {<key>=<value>, ...} containing statistics
+ *----------------------------------------------------------------------------*/
+int GranuleCache::luaStats (lua_State* L)
+{
+    bool status = false;
+    int num_obj_to_return = 1;
+
+    try
+    {
+        /* Get Clear Parameter */
+        bool with_clear = LuaObject::getLuaBoolean(L, 1, true, false);
+
+        /* Create Statistics Table */
+        cacheMut.lock();
+        {
+            lua_newtable(L);
+            LuaEngine::setAttrInt(L, LUA_STAT_CACHE_HITS,       hits);
+            LuaEngine::setAttrInt(L, LUA_STAT_CACHE_MISSES,     misses);
+            LuaEngine::setAttrInt(L, LUA_STAT_CACHE_EVICTIONS,  evictions);
+            LuaEngine::setAttrInt(L, LUA_STAT_CACHE_ENTRIES,    entries.length());
+            LuaEngine::setAttrInt(L, LUA_STAT_CACHE_SIZE,       cacheSize);
+
+            /* Clear if Requested */
+            if(with_clear)
+            {
+                hits = 0;
+                misses = 0;
+                evictions = 0;
+            }
+        }
+        cacheMut.unlock();
+
+        /* Set Success */
+        status = true;
+        num_obj_to_return = 2;
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Error returning granule cache stats: %s", e.what());
+    }
+
+    /* Return Status */
+    return LuaObject::returnLuaStatus(L, status, num_obj_to_return);
+}
+
+/*----------------------------------------------------------------------------
+ * evict
+ *
+ *  evicts least recently used entries until the size given fits in the
+ *  cache; entries still in use are freed once released, and count against
+ *  the size of the cache until then (called with lock)
+ *----------------------------------------------------------------------------*/
+void GranuleCache::evict (long size)
+{
+    while(oldest && (cacheSize + size > maxSize))
+    {
+        entry_t* entry = oldest;
+        unlink(entry);
+        entries.remove(entry->key);
+        entry->evicted = true;
+        evictions++;
+
+        if(entry->refs == 0) freeEntry(entry);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * unlink
+ *
+ *  removes an entry from the recently used list (called with lock)
+ *----------------------------------------------------------------------------*/
+void GranuleCache::unlink (entry_t* entry)
+{
+    if(entry->newer) entry->newer->older = entry->older;
+    else if(newest == entry) newest = entry->older;
+
+    if(entry->older) entry->older->newer = entry->newer;
+    else if(oldest == entry) oldest = entry->newer;
+
+    entry->newer = NULL;
+    entry->older = NULL;
+}
+
+/*----------------------------------------------------------------------------
+ * touch
+ *
+ *  makes an entry the most recently used (called with lock)
+ *----------------------------------------------------------------------------*/
+void GranuleCache::touch (entry_t* entry)
+{
+    unlink(entry);
+
+    entry->older = newest;
+    if(newest) newest->newer = entry;
+    newest = entry;
+    if(!oldest) oldest = entry;
+}
+
+/*----------------------------------------------------------------------------
+ * freeEntry
+ *
+ *  frees an entry and its data (called with lock)
+ *----------------------------------------------------------------------------*/
+void GranuleCache::freeEntry (entry_t* entry)
+{
+    if(entry->counted) cacheSize -= entry->size;
+    delete [] entry->key;
+    delete [] entry->data;
+    delete entry;
+}
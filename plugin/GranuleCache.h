@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2021, University of Washington
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the University of Washington nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY OF WASHINGTON AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF WASHINGTON OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __granule_cache__
+#define __granule_cache__
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include "OsApi.h"
+#include "Dictionary.h"
+#include "lua.h"
+
+/******************************************************************************
+ * GRANULE CACHE CLASS
+ *
+ *  rows of granule datasets read by any reader in the process, kept so that
+ *  repeated requests against the same granules read memory instead of
+ *  storage; rows are cached in fixed blocks (so that requests reading
+ *  different row ranges share them) keyed by asset, resource, dataset,
+ *  column and rows, entries in use are shared (reference counted), and the
+ *  least recently used entries are evicted to stay within the configured
+ *  size (evicted entries still in use count against it until released);
+ *  the cache is disabled (zero size) unless configured
+ ******************************************************************************/
+
+class GranuleCache
+{
+    public:
+
+        /*--------------------------------------------------------------------
+         * Types
+         *--------------------------------------------------------------------*/
+
+        typedef struct entry {
+            char*           key;
+            unsigned char*  data;
+            long            elements;
+            long            size;       // bytes of data
+            int             refs;       // readers using entry
+            bool            evicted;    // not cached, freed once no longer used
+            bool            counted;    // size counted in cache until freed
+            struct entry*   newer;      // toward most recently used
+            struct entry*   older;      // toward least recently used
+        } entry_t;
+
+        /*--------------------------------------------------------------------
+         * Constants
+         *--------------------------------------------------------------------*/
+
+        static const long DEFAULT_MAX_SIZE = 0; // bytes (disabled)
+        static const long BLOCK_ROWS = 10000; // rows of a cached block (the chunk size of the ATL03 photon datasets)
+
+        /*--------------------------------------------------------------------
+         * Methods
+         *--------------------------------------------------------------------*/
+
+        static entry_t*     acquire         (const char* key);
+        static entry_t*     insert          (const char* key, unsigned char* data, long elements, long size);
+        static void         release         (entry_t* entry);
+        static bool         enabled         (void);
+        static int          luaSize         (lua_State* L);
+        static int          luaStats        (lua_State* L);
+
+    private:
+
+        /*--------------------------------------------------------------------
+         * Data
+         *--------------------------------------------------------------------*/
+
+        static Mutex                cacheMut;
+        static Dictionary<entry_t*> entries;
+        static entry_t*             newest;
+        static entry_t*             oldest;
+        static long                 cacheSize;  // bytes of entries cached or evicted while in use
+        static long                 maxSize;
+        static uint64_t             hits;
+        static uint64_t             misses;
+        static uint64_t             evictions;
+
+        /*--------------------------------------------------------------------
+         * Methods
+         *--------------------------------------------------------------------*/
+
+        static void         evict           (long size);
+        static void         unlink          (entry_t* entry);
+        static void         touch           (entry_t* entry);
+        static void         freeEntry       (entry_t* entry);
+};
+
+#endif  /* __granule_cache__ */
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2021, University of Washington
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the University of Washington nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY OF WASHINGTON AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF WASHINGTON OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include "core.h"
+#include "icesat2.h"
+
+/******************************************************************************
+ * POLYGON INDEX CLASS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * Constructor
+ *----------------------------------------------------------------------------*/
+PolygonIndex::PolygonIndex (const List<MathLib::coord_t>& polygon)
+{
+    List<MathLib::coord_t>::Iterator poly_iterator(polygon);
+    int num_points = poly_iterator.length;
+    MathLib::point_t* points = new MathLib::point_t [num_points];
+
+    /* Build Index of Polygon in Each Projection */
+    for(int p = 0; p < NUM_PROJECTIONS; p++)
+    {
+        for(int i = 0; i < num_points; i++)
+        {
+            points[i] = MathLib::coord2point(poly_iterator[i], (MathLib::proj_t)p);
+        }
+        build(&projected[p], points, num_points);
+    }
+
+    delete [] points;
+}
+
+/*----------------------------------------------------------------------------
+ * Destructor
+ *----------------------------------------------------------------------------*/
+PolygonIndex::~PolygonIndex (void)
+{
+    for(int p = 0; p < NUM_PROJECTIONS; p++)
+    {
+        delete [] projected[p].slab_start;
+        delete [] projected[p].slab_edges;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * inside
+ *----------------------------------------------------------------------------*/
+bool PolygonIndex::inside (MathLib::point_t point, MathLib::proj_t projection) const
+{
+    const projected_t* proj = &projected[projection];
+
+    /* Reject Points Outside Bounding Box */
+    if(point.x < proj->min.x || point.x > proj->max.x || point.y < proj->min.y || point.y > proj->max.y)
+    {
+        return false;
+    }
+
+    /* Count Crossings of Edges in Point's Slab */
+    bool c = false;
+    int k = slab(proj, point.y);
+    for(int e = proj->slab_start[k]; e < proj->slab_start[k + 1]; e++)
+    {
+        const edge_t* edge = &proj->slab_edges[e];
+        if( ((edge->y1 > point.y) != (edge->y2 > point.y)) &&
+            (point.x < (edge->x2 - edge->x1) * (point.y - edge->y1) / (edge->y2 - edge->y1) + edge->x1) )
+        {
+            c = !c;
+        }
+    }
+
+    return c;
+}
+
+/*----------------------------------------------------------------------------
+ * boundingBox
+ *----------------------------------------------------------------------------*/
+void PolygonIndex::boundingBox (MathLib::proj_t projection, MathLib::point_t* min, MathLib::point_t* max) const
+{
+    *min = projected[projection].min;
+    *max = projected[projection].max;
+}
+
+/*----------------------------------------------------------------------------
+ * build
+ *
+ *  an edge crosses the horizontal line through a point when the point's y is
+ *  within [lower y, upper y) of the edge, so each edge is added to every slab
+ *  from the slab of its lower y to the slab of its upper y; horizontal edges
+ *  never cross and are left out
+ *----------------------------------------------------------------------------*/
+void PolygonIndex::build (projected_t* proj, MathLib::point_t* points, int num_points)
+{
+    /* Find Bounding Box */
+    proj->min = (num_points > 0) ? points[0] : MathLib::point_t{0.0, 0.0};
+    proj->max = proj->min;
+    for(int i = 1; i < num_points; i++)
+    {
+        proj->min.x = MIN(proj->min.x, points[i].x);
+        proj->min.y = MIN(proj->min.y, points[i].y);
+        proj->max.x = MAX(proj->max.x, points[i].x);
+        proj->max.y = MAX(proj->max.y, points[i].y);
+    }
+
+    /* Count Edges in Each Slab (halving slabs until edges fit in memory bound) */
+    int* slab_count = NULL;
+    int num_entries = 0;
+    proj->num_slabs = MIN(MAX(num_points / 2, 1), MAX_SLABS) * 2;
+    do
+    {
+        proj->num_slabs /= 2;
+        proj->slab_height = (proj->max.y - proj->min.y) / proj->num_slabs;
+        if(proj->slab_height <= 0.0)
+        {
+            proj->num_slabs = 1;
+            proj->slab_height = 1.0;
+        }
+
+        delete [] slab_count;
+        slab_count = new int [proj->num_slabs];
+        LocalLib::set(slab_count, 0, sizeof(int) * proj->num_slabs);
+        num_entries = 0;
+        for(int i = 0, j = num_points - 1; i < num_points; j = i++)
+        {
+            if(points[i].y == points[j].y) continue;
+            int first_slab = slab(proj, MIN(points[i].y, points[j].y));
+            int last_slab = slab(proj, MAX(points[i].y, points[j].y));
+            for(int k = first_slab; k <= last_slab; k++) slab_count[k]++;
+            num_entries += last_slab - first_slab + 1;
+        }
+    } while(proj->num_slabs > 1 && num_entries > MAX_SLAB_EDGES_PER_POINT * num_points);
+
+    /* Find Start of Each Slab */
+    proj->slab_start = new int [proj->num_slabs + 1];
+    proj->slab_start[0] = 0;
+    for(int k = 0; k < proj->num_slabs; k++)
+    {
+        proj->slab_start[k + 1] = proj->slab_start[k] + slab_count[k];
+        slab_count[k] = proj->slab_start[k]; // next entry of slab
+    }
+
+    /* Populate Edges of Each Slab */
+    proj->slab_edges = new edge_t [MAX(num_entries, 1)];
+    for(int i = 0, j = num_points - 1; i < num_points; j = i++)
+    {
+        if(points[i].y == points[j].y) continue;
+        edge_t edge = {points[i].x, points[i].y, points[j].x, points[j].y};
+        int first_slab = slab(proj, MIN(points[i].y, points[j].y));
+        int last_slab = slab(proj, MAX(points[i].y, points[j].y));
+        for(int k = first_slab; k <= last_slab; k++)
+        {
+            proj->slab_edges[slab_count[k]++] = edge;
+        }
+    }
+
+    delete [] slab_count;
+}
+
+/*----------------------------------------------------------------------------
+ * slab
+ *
+ *  monotonic in y, so the slabs of an edge's end points bound the slabs
+ *  the edge spans
+ *----------------------------------------------------------------------------*/
+int PolygonIndex::slab (const projected_t* proj, double y)
+{
+    double k = (y - proj->min.y) / proj->slab_height;
+    if(k <= 0.0) return 0;
+    else if(k >= proj->num_slabs) return proj->num_slabs - 1;
+    else return (int)k;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2021, University of Washington
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the University of Washington nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY OF WASHINGTON AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF WASHINGTON OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __polygon_index__
+#define __polygon_index__
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include "List.h"
+#include "MathLib.h"
+
+/******************************************************************************
+ * POLYGON INDEX CLASS
+ ******************************************************************************/
+
+/*
+ * Read-only acceleration structure of a request's polygon: the polygon is
+ * projected once in every projection, and for each projection the edges are
+ * binned into horizontal slabs so that an inclusion test only visits the
+ * edges crossing the slab of the point.  Points outside the bounding box of
+ * the polygon are rejected without visiting any edge.  The crossing test of
+ * each edge is the same as MathLib::inpoly.
+ */
+class PolygonIndex
+{
+    public:
+
+        /*--------------------------------------------------------------------
+         * Constants
+         *--------------------------------------------------------------------*/
+
+        static const int NUM_PROJECTIONS = 3; // MathLib::proj_t
+        static const int MAX_SLABS = 4096;
+        static const int MAX_SLAB_EDGES_PER_POINT = 16; // bounds memory of polygons with many long edges
+
+        /*--------------------------------------------------------------------
+         * Methods
+         *--------------------------------------------------------------------*/
+
+                PolygonIndex    (const List<MathLib::coord_t>& polygon);
+                ~PolygonIndex   (void);
+
+        bool    inside          (MathLib::point_t point, MathLib::proj_t projection) const;
+        void    boundingBox     (MathLib::proj_t projection, MathLib::point_t* min, MathLib::point_t* max) const;
+
+    private:
+
+        /*--------------------------------------------------------------------
+         * Types
+         *--------------------------------------------------------------------*/
+
+        /* Polygon Edge (from vertex 1 to previous vertex 2) */
+        typedef struct {
+            double              x1;
+            double              y1;
+            double              x2;
+            double              y2;
+        } edge_t;
+
+        /* Polygon in One Projection */
+        typedef struct {
+            MathLib::point_t    min;            // bounding box
+            MathLib::point_t    max;
+            double              slab_height;
+            int                 num_slabs;
+            int*                slab_start;     // index of first edge of each slab (num_slabs + 1 entries)
+            edge_t*             slab_edges;     // edges spanning more than one slab are repeated
+        } projected_t;
+
+        /*--------------------------------------------------------------------
+         * Data
+         *--------------------------------------------------------------------*/
+
+        projected_t             projected[NUM_PROJECTIONS];
+
+        /*--------------------------------------------------------------------
+         * Methods
+         *--------------------------------------------------------------------*/
+
+        static void             build           (projected_t* proj, MathLib::point_t* points, int num_points);
+        static int              slab            (const projected_t* proj, double y);
+};
+
+#endif  /* __polygon_index__ */
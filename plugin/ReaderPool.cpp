@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2021, University of Washington
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the University of Washington nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY OF WASHINGTON AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF WASHINGTON OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include "core.h"
+#include "icesat2.h"
+
+/******************************************************************************
+ * STATIC DATA
+ ******************************************************************************/
+
+bool ReaderPool::active = true;
+Cond ReaderPool::poolCond(NUM_SIGS);
+List<ReaderPool::task_t> ReaderPool::tasks;
+List<ReaderPool::task_t> ReaderPool::urgentTasks;
+Thread* ReaderPool::workerPid[MAX_NUM_THREADS];
+int ReaderPool::numWorkers = 0;
+int ReaderPool::concurrency = 1;
+Thread* ReaderPool::urgentPid[MAX_URGENT_THREADS];
+int ReaderPool::numUrgentWorkers = 0;
+int ReaderPool::maxUrgentWorkers = 1;
+
+/******************************************************************************
+ * FILE DATA
+ ******************************************************************************/
+
+/* Stops the Workers at Exit (defined after the data they use, so destroyed before it) */
+static struct ReaderPoolShutdown {
+    ~ReaderPoolShutdown (void) { ReaderPool::deinit(); }
+} readerPoolShutdown;
+
+/******************************************************************************
+ * READER POOL CLASS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * init
+ *
+ *  sizes the pool, and its urgent workers, to the number of processors;
+ *  workers are started as tasks are submitted
+ *----------------------------------------------------------------------------*/
+void ReaderPool::init (void)
+{
+    concurrency = MAX(MIN(LocalLib::nproc(), MAX_NUM_THREADS), 1);
+    maxUrgentWorkers = MAX(MIN(LocalLib::nproc(), MAX_URGENT_THREADS), 1);
+}
+
+/*----------------------------------------------------------------------------
+ * deinit
+ *
+ *  stops the workers once their current tasks complete, and waits for them;
+ *  tasks still waiting are not run (their owners withdraw them)
+ *----------------------------------------------------------------------------*/
+void ReaderPool::deinit (void)
+{
+    poolCond.lock();
+    {
+        active = false;
+        poolCond.signal(ACTIVE_SIG, Cond::NOTIFY_ALL);
+        poolCond.signal(IDLE_SIG, Cond::NOTIFY_ALL);
+        poolCond.signal(URGENT_SIG, Cond::NOTIFY_ALL);
+    }
+    poolCond.unlock();
+
+    /* Wait for Workers (none are started once inactive) */
+    for(int w = 0; w < numWorkers; w++)
+    {
+        delete workerPid[w];
+    }
+    numWorkers = 0;
+
+    for(int w = 0; w < numUrgentWorkers; w++)
+    {
+        delete urgentPid[w];
+    }
+    numUrgentWorkers = 0;
+}
+
+/*----------------------------------------------------------------------------
+ * submit
+ *----------------------------------------------------------------------------*/
+void ReaderPool::submit (task_func_t func, void* parm, const void* owner, bool urgent)
+{
+    task_t task = { func, parm, owner };
+
+    poolCond.lock();
+    {
+        if(urgent)
+        {
+            /* Queue Urgent Task */
+            urgentTasks.add(task);
+
+            /* Start Another Urgent Worker (up to the number allowed) */
+            if(active && numUrgentWorkers < maxUrgentWorkers)
+            {
+                urgentPid[numUrgentWorkers] = new Thread(urgentThread, NULL);
+                numUrgentWorkers++;
+            }
+
+            /* Wake an Urgent Worker to Run It */
+            poolCond.signal(URGENT_SIG, Cond::NOTIFY_ONE);
+        }
+        else
+        {
+            /* Queue Task */
+            tasks.add(task);
+
+            /* Start Another Worker (up to the concurrency allowed) */
+            if(active && numWorkers < concurrency)
+            {
+                workerPid[numWorkers] = new Thread(workerThread, (void*)(long)numWorkers);
+                numWorkers++;
+            }
+
+            /* Wake a Worker Allowed to Run It */
+            poolCond.signal(ACTIVE_SIG, Cond::NOTIFY_ONE);
+        }
+    }
+    poolCond.unlock();
+}
+
+/*----------------------------------------------------------------------------
+ * withdraw
+ *
+ *  removes the tasks of an owner that have not started running, adding
+ *  their parameters to the list provided (for the owner to free); returns
+ *  the number of tasks withdrawn
+ *----------------------------------------------------------------------------*/
+int ReaderPool::withdraw (const void* owner, List<void*>* parms)
+{
+    int withdrawn = 0;
+
+    poolCond.lock();
+    {
+        List<task_t>* queues[2] = { &urgentTasks, &tasks };
+        for(int q = 0; q < 2; q++)
+        {
+            List<task_t>& queue = *queues[q];
+            int t = 0;
+            while(t < queue.length())
+            {
+                if(queue[t].owner == owner)
+                {
+                    parms->add(queue[t].parm);
+                    queue.remove(t);
+                    withdrawn++;
+                }
+                else
+                {
+                    t++;
+                }
+            }
+        }
+    }
+    poolCond.unlock();
+
+    return withdrawn;
+}
+
+/*----------------------------------------------------------------------------
+ * getConcurrency
+ *
+ *  number of tasks run at a time; used by tasks sizing how finely to split
+ *  their work
+ *----------------------------------------------------------------------------*/
+int ReaderPool::getConcurrency (void)
+{
+    return concurrency;
+}
+
+/*----------------------------------------------------------------------------
+ * luaConcurrency - readers([<num threads>])
+ *
+ *  sets the number of tasks run at a time by the pool (when provided) and
+ *  returns it; lowering it idles the workers above it once their current
+ *  tasks complete
+ *----------------------------------------------------------------------------*/
+int ReaderPool::luaConcurrency (lua_State* L)
+{
+    try
+    {
+        bool provided = false;
+        long num_threads = LuaObject::getLuaInteger(L, 1, true, 0, &provided);
+        if(provided)
+        {
+            if(num_threads < 1 || num_threads > MAX_NUM_THREADS)
+            {
+                throw RunTimeException(CRITICAL, "invalid number of reader threads: %ld (must be between 1 and %d)", num_threads, MAX_NUM_THREADS);
+            }
+
+            poolCond.lock();
+            {
+                concurrency = num_threads;
+
+                /* Start Workers for Tasks Waiting */
+                while(active && numWorkers < concurrency && numWorkers < urgentTasks.length() + tasks.length())
+                {
+                    workerPid[numWorkers] = new Thread(workerThread, (void*)(long)numWorkers);
+                    numWorkers++;
+                }
+
+                /* Wake All Workers (each waits again on the signal of its side of the limit) */
+                poolCond.signal(ACTIVE_SIG, Cond::NOTIFY_ALL);
+                poolCond.signal(IDLE_SIG, Cond::NOTIFY_ALL);
+            }
+            poolCond.unlock();
+        }
+
+        lua_pushinteger(L, concurrency);
+        return 1;
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Error configuring reader pool: %s", e.what());
+        return LuaObject::returnLuaStatus(L, false);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * workerThread
+ *
+ *  runs the next task waiting whenever the worker is within the concurrency
+ *  allowed; idle workers wait on the signal of their side of the limit, so
+ *  a task submitted only wakes a worker that can run it; workers exit once
+ *  the pool is no longer active
+ *----------------------------------------------------------------------------*/
+void* ReaderPool::workerThread (void* parm)
+{
+    long worker = (long)parm;
+
+    while(active)
+    {
+        task_t task;
+        bool have_task = false;
+
+        /* Get Next Task */
+        poolCond.lock();
+        {
+            if(worker < concurrency && urgentTasks.length() > 0)
+            {
+                task = urgentTasks[0];
+                urgentTasks.remove(0);
+                have_task = true;
+            }
+            else if(worker < concurrency && tasks.length() > 0)
+            {
+                task = tasks[0];
+                tasks.remove(0);
+                have_task = true;
+            }
+            else if(active)
+            {
+                poolCond.wait((worker < concurrency) ? ACTIVE_SIG : IDLE_SIG, SYS_TIMEOUT);
+            }
+        }
+        poolCond.unlock();
+
+        /* Run Task */
+        if(have_task)
+        {
+            task.func(task.parm);
+        }
+    }
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+ * urgentThread
+ *
+ *  runs urgent tasks only, regardless of the concurrency allowed; urgent
+ *  tasks are short (e.g. reading a window of a dataset) and are waited on
+ *  by the tasks running on the other workers, so they must not wait for
+ *  those tasks to free a worker
+ *----------------------------------------------------------------------------*/
+void* ReaderPool::urgentThread (void* parm)
+{
+    while(active)
+    {
+        task_t task;
+        bool have_task = false;
+
+        /* Get Next Urgent Task */
+        poolCond.lock();
+        {
+            if(urgentTasks.length() > 0)
+            {
+                task = urgentTasks[0];
+                urgentTasks.remove(0);
+                have_task = true;
+            }
+            else if(active)
+            {
+                poolCond.wait(URGENT_SIG, SYS_TIMEOUT);
+            }
+        }
+        poolCond.unlock();
+
+        /* Run Task */
+        if(have_task)
+        {
+            task.func(task.parm);
+        }
+    }
+
+    return NULL;
+}
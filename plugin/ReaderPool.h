@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2021, University of Washington
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the University of Washington nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY OF WASHINGTON AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF WASHINGTON OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __reader_pool__
+#define __reader_pool__
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include "OsApi.h"
+#include "List.h"
+#include "lua.h"
+
+/******************************************************************************
+ * READER POOL CLASS
+ *
+ *  worker threads shared by all of the readers in the process; readers
+ *  submit tasks (e.g. a track of a resource) which are run in the order
+ *  submitted by at most the configured number of workers at a time; urgent
+ *  tasks (e.g. a read another task will wait on) run before the others,
+ *  and are also run by workers of their own, so that they still start when
+ *  every worker is busy with a task that waits on them
+ ******************************************************************************/
+
+class ReaderPool
+{
+    public:
+
+        /*--------------------------------------------------------------------
+         * Types
+         *--------------------------------------------------------------------*/
+
+        typedef void* (*task_func_t) (void* parm);
+
+        typedef struct {
+            task_func_t     func;
+            void*           parm;
+            const void*     owner;      // object that submitted the task
+        } task_t;
+
+        /*--------------------------------------------------------------------
+         * Constants
+         *--------------------------------------------------------------------*/
+
+        static const int MAX_NUM_THREADS = 64;
+        static const int MAX_URGENT_THREADS = 16;
+
+        static const int ACTIVE_SIG = 0;    // wakes an idle worker within the concurrency allowed
+        static const int IDLE_SIG = 1;      // wakes the workers above it (when it is raised)
+        static const int URGENT_SIG = 2;    // wakes an idle urgent worker
+        static const int NUM_SIGS = 3;
+
+        /*--------------------------------------------------------------------
+         * Methods
+         *--------------------------------------------------------------------*/
+
+        static void         init            (void);
+        static void         deinit          (void);
+        static void         submit          (task_func_t func, void* parm, const void* owner, bool urgent=false);
+        static int          withdraw        (const void* owner, List<void*>* parms);
+        static int          getConcurrency  (void);
+        static int          luaConcurrency  (lua_State* L);
+
+    private:
+
+        /*--------------------------------------------------------------------
+         * Data
+         *--------------------------------------------------------------------*/
+
+        static bool         active;     // cleared to stop the workers
+        static Cond         poolCond;
+        static List<task_t> tasks;      // waiting to be run, in order submitted
+        static List<task_t> urgentTasks; // waiting to be run ahead of tasks
+        static Thread*      workerPid[MAX_NUM_THREADS];
+        static int          numWorkers; // started
+        static int          concurrency; // workers allowed to run tasks
+        static Thread*      urgentPid[MAX_URGENT_THREADS];
+        static int          numUrgentWorkers; // started
+        static int          maxUrgentWorkers; // workers running only urgent tasks
+
+        /*--------------------------------------------------------------------
+         * Methods
+         *--------------------------------------------------------------------*/
+
+        static void*        workerThread    (void* parm);
+        static void*        urgentThread    (void* parm);
+};
+
+#endif  /* __reader_pool__ */
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2021, University of Washington
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the University of Washington nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY OF WASHINGTON AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF WASHINGTON OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __spsc_queue__
+#define __spsc_queue__
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include <atomic>
+
+#include "OsApi.h"
+
+/******************************************************************************
+ * SPSC QUEUE TEMPLATE
+ *
+ *  bounded queue between a single producer thread and a single consumer
+ *  thread; pushing and popping never take a lock - the condition is only
+ *  used to sleep a side that finds the queue full (producer) or empty
+ *  (consumer), and is only signaled while that side is asleep
+ ******************************************************************************/
+
+template <class T>
+class SpscQueue
+{
+    public:
+
+        /*--------------------------------------------------------------------
+         * Methods
+         *--------------------------------------------------------------------*/
+
+                    SpscQueue   (int depth);
+                    ~SpscQueue  (void);
+
+        bool        push        (const T& item);
+        bool        pop         (T& item);
+        void        waitPush    (int timeout);
+        void        waitPop     (int timeout);
+        long        length      (void);
+
+    private:
+
+        /*--------------------------------------------------------------------
+         * Constants
+         *--------------------------------------------------------------------*/
+
+        static const int PRODUCER = 0;
+        static const int CONSUMER = 1;
+
+        /*--------------------------------------------------------------------
+         * Data
+         *--------------------------------------------------------------------*/
+
+        T*                  ring;
+        long                size;           // power of two
+        std::atomic<long>   head;           // next item popped (written only by consumer)
+        std::atomic<long>   tail;           // next item pushed (written only by producer)
+        std::atomic<bool>   asleep[2];      // producer waiting for room, consumer waiting for an item
+        Cond                cond;
+
+        /*--------------------------------------------------------------------
+         * Methods
+         *--------------------------------------------------------------------*/
+
+        void        wake        (int side);
+};
+
+/******************************************************************************
+ * SPSC QUEUE METHODS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * Constructor
+ *
+ *  the depth is rounded up to a power of two
+ *----------------------------------------------------------------------------*/
+template <class T>
+SpscQueue<T>::SpscQueue(int depth)
+{
+    size = 1;
+    while(size < depth) size <<= 1;
+    ring = new T [size];
+    head = 0;
+    tail = 0;
+    asleep[PRODUCER] = false;
+    asleep[CONSUMER] = false;
+}
+
+/*----------------------------------------------------------------------------
+ * Destructor
+ *----------------------------------------------------------------------------*/
+template <class T>
+SpscQueue<T>::~SpscQueue(void)
+{
+    delete [] ring;
+}
+
+/*----------------------------------------------------------------------------
+ * push
+ *
+ *  called only by the producer; returns false when the queue is full
+ *----------------------------------------------------------------------------*/
+template <class T>
+bool SpscQueue<T>::push(const T& item)
+{
+    long t = tail.load(std::memory_order_relaxed);
+    if(t - head.load() >= size) return false;
+
+    ring[t & (size - 1)] = item;
+    tail.store(t + 1);
+
+    wake(CONSUMER);
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+ * pop
+ *
+ *  called only by the consumer; returns false when the queue is empty
+ *----------------------------------------------------------------------------*/
+template <class T>
+bool SpscQueue<T>::pop(T& item)
+{
+    long h = head.load(std::memory_order_relaxed);
+    if(h == tail.load()) return false;
+
+    item = ring[h & (size - 1)];
+    head.store(h + 1);
+
+    wake(PRODUCER);
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+ * waitPush
+ *
+ *  called only by the producer; sleeps until the queue has room or the
+ *  timeout (in milliseconds) expires
+ *----------------------------------------------------------------------------*/
+template <class T>
+void SpscQueue<T>::waitPush(int timeout)
+{
+    cond.lock();
+    {
+        asleep[PRODUCER] = true;
+        if(tail.load() - head.load() >= size) cond.wait(0, timeout);
+        asleep[PRODUCER] = false;
+    }
+    cond.unlock();
+}
+
+/*----------------------------------------------------------------------------
+ * waitPop
+ *
+ *  called only by the consumer; sleeps until the queue has an item or the
+ *  timeout (in milliseconds) expires
+ *----------------------------------------------------------------------------*/
+template <class T>
+void SpscQueue<T>::waitPop(int timeout)
+{
+    cond.lock();
+    {
+        asleep[CONSUMER] = true;
+        if(tail.load() == head.load()) cond.wait(0, timeout);
+        asleep[CONSUMER] = false;
+    }
+    cond.unlock();
+}
+
+/*----------------------------------------------------------------------------
+ * length
+ *----------------------------------------------------------------------------*/
+template <class T>
+long SpscQueue<T>::length(void)
+{
+    return tail.load() - head.load();
+}
+
+/*----------------------------------------------------------------------------
+ * wake
+ *
+ *  the sleeping side sets its flag before checking the queue, and the other
+ *  side checks the flag after changing the queue, so either the sleeping
+ *  side sees the change or it is signaled once asleep (it holds the lock
+ *  from its check until it waits)
+ *----------------------------------------------------------------------------*/
+template <class T>
+void SpscQueue<T>::wake(int side)
+{
+    if(asleep[side].load())
+    {
+        cond.lock();
+        cond.signal();
+        cond.unlock();
+    }
+}
+
+#endif  /* __spsc_queue__ */
@@ -0,0 +1,1002 @@
+/*
+ * Copyright (c) 2021, University of Washington
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the University of Washington nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY OF WASHINGTON AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF WASHINGTON OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include "core.h"
+#include "UT_Atl03Reader.h"
+#include "PolygonIndex.h"
+
+#include <cmath>
+
+/******************************************************************************
+ * STATIC DATA
+ ******************************************************************************/
+
+const char* UT_Atl03Reader::OBJECT_TYPE = "UT_Atl03Reader";
+
+const char* UT_Atl03Reader::LuaMetaName = "UT_Atl03Reader";
+const struct luaL_Reg UT_Atl03Reader::LuaMetaTable[] = {
+    {"polytest",    luaPolygonTest},
+    {"queuetest",   luaQueueTest},
+    {"cachetest",   luaCacheTest},
+    {"extenttest",  luaExtentTest},
+    {NULL,          NULL}
+};
+
+/******************************************************************************
+ * PUBLIC METHODS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * luaCreate - :UT_Atl03Reader()
+ *----------------------------------------------------------------------------*/
+int UT_Atl03Reader::luaCreate (lua_State* L)
+{
+    try
+    {
+        /* Create ATL03 Reader Unit Test */
+        return createLuaObject(L, new UT_Atl03Reader(L));
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Error creating %s: %s", LuaMetaName, e.what());
+        return returnLuaStatus(L, false);
+    }
+}
+
+/******************************************************************************
+ * PRIVATE METOHDS
+ *******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * Constructor
+ *----------------------------------------------------------------------------*/
+UT_Atl03Reader::UT_Atl03Reader (lua_State* L):
+    LuaObject(L, OBJECT_TYPE, LuaMetaName, LuaMetaTable)
+{
+}
+
+/*----------------------------------------------------------------------------
+ * Destructor  -
+ *----------------------------------------------------------------------------*/
+UT_Atl03Reader::~UT_Atl03Reader(void)
+{
+}
+
+/*----------------------------------------------------------------------------
+ * luaPolygonTest
+ *
+ *  checks that the polygon index gives the same inclusion result as
+ *  MathLib::inpoly for random points in every projection; the polygons
+ *  include rectangles, concave stars with vertices snapped to a grid, and
+ *  combs, so that there are many horizontal edges and many points that are
+ *  on the bounding box or level with a vertex
+ *----------------------------------------------------------------------------*/
+int UT_Atl03Reader::luaPolygonTest (lua_State* L)
+{
+    bool status = false;
+
+    try
+    {
+        bool tests_passed = true;
+        uint32_t seed = 0x9017;
+        const MathLib::coord_t centers[] = { {0.0, 0.0}, {40.0, -105.0}, {75.0, -45.0}, {-75.0, 120.0}, {-86.0, 10.0}, {86.0, 170.0} };
+        const int num_centers = sizeof(centers) / sizeof(MathLib::coord_t);
+
+        for(int test = 0; tests_passed && test < 300; test++)
+        {
+            MathLib::coord_t center = centers[test % num_centers];
+            double size = 0.01 + uniform(&seed);
+            List<MathLib::coord_t> polygon;
+
+            if(test % 3 == 0)
+            {
+                /* Rectangle */
+                double width = size * (0.1 + uniform(&seed));
+                polygon.add({center.lat - size, center.lon - width});
+                polygon.add({center.lat + size, center.lon - width});
+                polygon.add({center.lat + size, center.lon + width});
+                polygon.add({center.lat - size, center.lon + width});
+            }
+            else if(test % 3 == 1)
+            {
+                /* Concave Star (vertices snapped to grid, so consecutive vertices are often level) */
+                int num_vertices = 3 + (test % 250);
+                double grid = size / 20.0;
+                for(int v = 0; v < num_vertices; v++)
+                {
+                    double angle = (2.0 * M_PI * v) / num_vertices;
+                    double radius = size * (0.2 + (0.8 * uniform(&seed)));
+                    double lat = center.lat + (radius * sin(angle));
+                    double lon = center.lon + (radius * cos(angle));
+                    polygon.add({floor(lat / grid) * grid, floor(lon / grid) * grid});
+                }
+            }
+            else
+            {
+                /* Comb (teeth along longitude, joined at the bottom) */
+                int num_teeth = 1 + (test % 40);
+                double tooth = size / num_teeth;
+                double base = center.lat - size;
+                double top = center.lat + size;
+                double gap = base + (size * uniform(&seed));
+                polygon.add({base, center.lon});
+                for(int k = 0; k < num_teeth; k++)
+                {
+                    double lon = center.lon + (k * tooth);
+                    polygon.add({top, lon});
+                    polygon.add({top, lon + (tooth / 2.0)});
+                    polygon.add({gap, lon + (tooth / 2.0)});
+                    polygon.add({gap, lon + tooth});
+                }
+                polygon.add({base, center.lon + size});
+            }
+
+            if(!comparePolygon(polygon, test, &seed))
+            {
+                tests_passed = false;
+            }
+        }
+
+        /* Set Status */
+        status = tests_passed;
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Error executing test %s: %s", __FUNCTION__, e.what());
+    }
+
+    /* Return Status */
+    return returnLuaStatus(L, status);
+}
+
+/*----------------------------------------------------------------------------
+ * luaQueueTest
+ *
+ *  checks that the queue rounds its depth up to a power of two, refuses
+ *  items when full, and returns items in order across the end of its ring;
+ *  then streams items from a producer thread through a small queue so that
+ *  both sides repeatedly find it full or empty and sleep
+ *----------------------------------------------------------------------------*/
+int UT_Atl03Reader::luaQueueTest (lua_State* L)
+{
+    bool status = false;
+
+    try
+    {
+        bool tests_passed = true;
+        long item = -1;
+        long expected = 0;
+
+        /* Test 1: Empty and Full (depth of five holds eight) */
+        SpscQueue<long> queue(5);
+        if(queue.pop(item))
+        {
+            mlog(CRITICAL, "Failed queue test01: popped %ld from empty queue", item);
+            tests_passed = false;
+        }
+        for(long i = 0; i < 8; i++)
+        {
+            if(!queue.push(i))
+            {
+                mlog(CRITICAL, "Failed queue test01: unable to push item %ld", i);
+                tests_passed = false;
+            }
+        }
+        if(queue.push(8) || queue.length() != 8)
+        {
+            mlog(CRITICAL, "Failed queue test01: pushed to full queue (length %ld)", queue.length());
+            tests_passed = false;
+        }
+
+        /* Test 2: Order Across End of Ring */
+        for(long i = 8; i < 100; i++)
+        {
+            if(!queue.pop(item) || item != expected || !queue.push(i))
+            {
+                mlog(CRITICAL, "Failed queue test02: popped %ld, expected %ld", item, expected);
+                tests_passed = false;
+                break;
+            }
+            expected++;
+        }
+        while(queue.pop(item))
+        {
+            if(item != expected)
+            {
+                mlog(CRITICAL, "Failed queue test02: popped %ld, expected %ld", item, expected);
+                tests_passed = false;
+            }
+            expected++;
+        }
+        if(expected != 100 || queue.length() != 0)
+        {
+            mlog(CRITICAL, "Failed queue test02: popped %ld items, %ld left", expected, queue.length());
+            tests_passed = false;
+        }
+
+        /* Test 3: Producer Thread */
+        SpscQueue<long> stream(4);
+        producer_t producer = { &stream, 100000, true };
+        Thread* pid = new Thread(producerThread, &producer);
+        int timeouts = 0;
+        expected = 0;
+        while(expected < producer.num_items && timeouts < 10)
+        {
+            if(stream.pop(item))
+            {
+                if(item != expected)
+                {
+                    mlog(CRITICAL, "Failed queue test03: popped %ld, expected %ld", item, expected);
+                    tests_passed = false;
+                    break;
+                }
+                expected++;
+                timeouts = 0;
+            }
+            else
+            {
+                stream.waitPop(SYS_TIMEOUT);
+                if(stream.length() == 0) timeouts++;
+            }
+        }
+        producer.active = false;
+        delete pid;
+        if(expected != producer.num_items || stream.pop(item))
+        {
+            mlog(CRITICAL, "Failed queue test03: popped %ld of %ld items", expected, producer.num_items);
+            tests_passed = false;
+        }
+
+        /* Set Status */
+        status = tests_passed;
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Error executing test %s: %s", __FUNCTION__, e.what());
+    }
+
+    /* Return Status */
+    return returnLuaStatus(L, status);
+}
+
+/*----------------------------------------------------------------------------
+ * luaCacheTest - :cachetest(<max size of cache in MB>)
+ *
+ *  checks sharing, eviction and sizing of the granule cache; expects the
+ *  cache to be empty and configured to the size given
+ *----------------------------------------------------------------------------*/
+int UT_Atl03Reader::luaCacheTest (lua_State* L)
+{
+    bool status = false;
+
+    try
+    {
+        bool tests_passed = true;
+
+        /* Get Size of Cache */
+        long max_size = getLuaInteger(L, 2) * 0x100000;
+        if(max_size <= 0)
+        {
+            throw RunTimeException(CRITICAL, "granule cache must be enabled");
+        }
+        long half = max_size / 2;
+        long most = (max_size / 4) * 3;
+
+        /* Test 1: Cached Entry Shared */
+        GranuleCache::entry_t* a = GranuleCache::insert("ut_atl03/a", cacheData(half, 'a'), half, half);
+        GranuleCache::entry_t* shared = GranuleCache::acquire("ut_atl03/a");
+        if(a->evicted || shared != a)
+        {
+            mlog(CRITICAL, "Failed cache test01: entry not shared");
+            tests_passed = false;
+        }
+        if(shared) GranuleCache::release(shared);
+
+        /* Test 2: Eviction of Entry in Use (least recently used, kept until released) */
+        GranuleCache::entry_t* b = GranuleCache::insert("ut_atl03/b", cacheData(half, 'b'), half, half);
+        GranuleCache::release(b);
+        GranuleCache::entry_t* c = GranuleCache::insert("ut_atl03/c", cacheData(half, 'c'), half, half);
+        if(c->evicted || !cached("ut_atl03/c"))
+        {
+            mlog(CRITICAL, "Failed cache test02: entry not cached");
+            tests_passed = false;
+        }
+        if(!a->evicted || cached("ut_atl03/a") || cached("ut_atl03/b"))
+        {
+            mlog(CRITICAL, "Failed cache test02: entries not evicted");
+            tests_passed = false;
+        }
+        if(!checkData(a, 'a'))
+        {
+            mlog(CRITICAL, "Failed cache test02: data of evicted entry in use changed");
+            tests_passed = false;
+        }
+        GranuleCache::release(c);
+
+        /* Test 3: Evicted Entry in Use Counted (entry over remaining size not cached) */
+        GranuleCache::entry_t* d = GranuleCache::insert("ut_atl03/d", cacheData(most, 'd'), most, most);
+        if(!d->evicted || cached("ut_atl03/d") || cached("ut_atl03/c"))
+        {
+            mlog(CRITICAL, "Failed cache test03: entry cached over size of entries in use");
+            tests_passed = false;
+        }
+        if(!checkData(d, 'd'))
+        {
+            mlog(CRITICAL, "Failed cache test03: data of entry not cached changed");
+            tests_passed = false;
+        }
+        GranuleCache::release(d);
+
+        /* Test 4: Released Entry No Longer Counted */
+        GranuleCache::release(a);
+        GranuleCache::entry_t* e = GranuleCache::insert("ut_atl03/e", cacheData(most, 'e'), most, most);
+        if(e->evicted || !cached("ut_atl03/e"))
+        {
+            mlog(CRITICAL, "Failed cache test04: entry not cached after release");
+            tests_passed = false;
+        }
+        GranuleCache::release(e);
+
+        /* Test 5: Entry Cached by Another Reader */
+        GranuleCache::entry_t* reread = GranuleCache::insert("ut_atl03/e", cacheData(most, 'x'), most, most);
+        if(reread != e || !checkData(reread, 'e'))
+        {
+            mlog(CRITICAL, "Failed cache test05: cached entry not returned");
+            tests_passed = false;
+        }
+        GranuleCache::release(reread);
+
+        /* Test 6: Entry Larger than Cache */
+        GranuleCache::entry_t* f = GranuleCache::insert("ut_atl03/f", cacheData(max_size + 1, 'f'), max_size + 1, max_size + 1);
+        if(!f->evicted || cached("ut_atl03/f") || !cached("ut_atl03/e"))
+        {
+            mlog(CRITICAL, "Failed cache test06: entry larger than cache cached");
+            tests_passed = false;
+        }
+        GranuleCache::release(f);
+
+        /* Set Status */
+        status = tests_passed;
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Error executing test %s: %s", __FUNCTION__, e.what());
+    }
+
+    /* Return Status */
+    return returnLuaStatus(L, status);
+}
+
+/*----------------------------------------------------------------------------
+ * luaExtentTest - :extenttest(<parms>)
+ *
+ *  checks that the extents built from a window of the photons accepted by
+ *  the filters (each photon classified once) are those of the reference
+ *  walk, which walks and classifies the photons of each extent in turn (as
+ *  the reader did before the window); the pair tracks are synthetic, with
+ *  gaps between segments, runs of segments without photons, and ATL08
+ *  classifications that repeat and skip photons
+ *----------------------------------------------------------------------------*/
+int UT_Atl03Reader::luaExtentTest (lua_State* L)
+{
+    const int num_tests = 3;
+    bool status = false;
+    atl06_parms_t* parms = NULL;
+    pair_track_t pt;
+    uint8_t* classes = NULL;
+    LocalLib::set(&pt, 0, sizeof(pt));
+
+    try
+    {
+        bool tests_passed = true;
+        uint32_t seed = 0x0E17;
+
+        /* Get Parameters */
+        parms = getLuaAtl06Parms(L, 2);
+
+        for(int test = 0; tests_passed && test < num_tests; test++)
+        {
+            /* Fill Streams of Pair Track */
+            buildPairTrack(&pt, test, &seed);
+            GTStream<int32_t>::Track segment_ph_cnt;
+            GTStream<double>::Track segment_dist_x;
+            GTStream<int32_t>::Track segment_id;
+            GTStream<float>::Track dist_ph_along;
+            GTStream<float>::Track h_ph;
+            GTStream<int8_t>::Track signal_conf_ph;
+            GTStream<double>::Track lat_ph;
+            GTStream<double>::Track lon_ph;
+            GTStream<double>::Track delta_time;
+            GTStream<int32_t>::Track ph_segment_id;
+            GTStream<int32_t>::Track classed_pc_indx;
+            GTStream<int8_t>::Track classed_pc_flag;
+            fillTrack<int32_t>(segment_ph_cnt, pt.segment_ph_cnt, pt.num_segments);
+            fillTrack<double>(segment_dist_x, pt.segment_dist_x, pt.num_segments);
+            fillTrack<int32_t>(segment_id, pt.segment_id, pt.num_segments);
+            fillTrack<float>(dist_ph_along, pt.dist_ph_along, pt.num_photons);
+            fillTrack<float>(h_ph, pt.h_ph, pt.num_photons);
+            fillTrack<int8_t>(signal_conf_ph, pt.signal_conf_ph, pt.num_photons);
+            fillTrack<double>(lat_ph, pt.lat_ph, pt.num_photons);
+            fillTrack<double>(lon_ph, pt.lon_ph, pt.num_photons);
+            fillTrack<double>(delta_time, pt.delta_time, pt.num_photons);
+            fillTrack<int32_t>(ph_segment_id, pt.ph_segment_id, pt.num_classed);
+            fillTrack<int32_t>(classed_pc_indx, pt.classed_pc_indx, pt.num_classed);
+            fillTrack<int8_t>(classed_pc_flag, pt.classed_pc_flag, pt.num_classed);
+
+            /* Classify Photons */
+            if(parms->use_atl08_classification)
+            {
+                classes = new uint8_t [pt.num_photons];
+                Atl03Reader::classifyPhotons(classes, segment_ph_cnt, segment_id, ph_segment_id, 0, classed_pc_indx, classed_pc_flag);
+            }
+
+            /* Start Extent Builder at First Extent */
+            Atl03Reader::cursor_t cursor;
+            cursor.ph_in = 0;
+            cursor.seg_in = 0;
+            cursor.seg_ph = 0;
+            cursor.start_segment = 0;
+            cursor.start_distance = pt.segment_dist_x[0];
+            cursor.extent_segment = 0;
+            cursor.start_seg_portion = 0.0;
+            cursor.track_complete = false;
+            cursor.end_ph = -1;
+            cursor.end_seg = 0;
+            cursor.end_seg_ph = 0;
+
+            Atl03Reader::ExtentBuilder builder;
+            builder.segment_ph_cnt = &segment_ph_cnt;
+            builder.segment_dist_x = &segment_dist_x;
+            builder.dist_ph_along = &dist_ph_along;
+            builder.h_ph = &h_ph;
+            builder.signal_conf_ph = &signal_conf_ph;
+            builder.lat_ph = &lat_ph;
+            builder.lon_ph = &lon_ph;
+            builder.delta_time = &delta_time;
+            builder.classes = classes;
+            builder.start(cursor);
+
+            /* Start Reference Walk at First Extent */
+            reference_t ref = {
+                .ph_in = 0,
+                .seg_in = 0,
+                .seg_ph = 0,
+                .start_segment = 0,
+                .start_distance = pt.segment_dist_x[0],
+                .extent_segment = 0,
+                .start_seg_portion = 0.0,
+                .track_complete = false,
+                .atl08_in = 0
+            };
+
+            /* Compare Extents */
+            long num_extents = 0;
+            while(tests_passed && (!cursor.track_complete || !ref.track_complete))
+            {
+                if(cursor.track_complete != ref.track_complete)
+                {
+                    mlog(CRITICAL, "Failed extent test%02d: pair track completed after %ld extents, reference %s", test, num_extents, ref.track_complete ? "completed" : "did not");
+                    tests_passed = false;
+                    break;
+                }
+
+                List<Atl03Reader::photon_t> expected;
+                bool expected_valid = referenceExtent(&ref, &pt, parms, expected);
+                bool segments_missing = false;
+                bool valid = builder.build(cursor, parms, &segments_missing);
+
+                if(valid != expected_valid || segments_missing || builder.photons != expected.length() ||
+                   cursor.extent_segment != ref.extent_segment || cursor.start_seg_portion != ref.start_seg_portion)
+                {
+                    mlog(CRITICAL, "Failed extent test%02d: extent %ld has %d photons at segment %d (valid %d), reference %d photons at segment %d (valid %d)",
+                         test, num_extents, builder.photons, cursor.extent_segment, valid, expected.length(), ref.extent_segment, expected_valid);
+                    tests_passed = false;
+                    break;
+                }
+
+                int p = 0;
+                for(int32_t i = 0; tests_passed && i < builder.entries; i++)
+                {
+                    if(builder.window[i].in_extent && !samePhoton(builder.window[i].photon, expected[p++]))
+                    {
+                        mlog(CRITICAL, "Failed extent test%02d: photon %d of extent %ld (index %d) differs from reference", test, p - 1, num_extents, builder.window[i].index);
+                        tests_passed = false;
+                    }
+                }
+
+                num_extents++;
+            }
+
+            if(num_extents == 0)
+            {
+                mlog(CRITICAL, "Failed extent test%02d: no extents", test);
+                tests_passed = false;
+            }
+
+            /* Free Pair Track */
+            delete [] classes;
+            classes = NULL;
+            freePairTrack(&pt);
+        }
+
+        /* Set Status */
+        status = tests_passed;
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Error executing test %s: %s", __FUNCTION__, e.what());
+    }
+
+    /* Clean Up */
+    delete [] classes;
+    freePairTrack(&pt);
+    if(parms) freeAtl06Parms(parms);
+
+    /* Return Status */
+    return returnLuaStatus(L, status);
+}
+
+/*----------------------------------------------------------------------------
+ * comparePolygon
+ *
+ *  compares the polygon index with MathLib::inpoly in every projection for
+ *  points inside and around the bounding box, on the bounding box, on the
+ *  vertices, and level with the vertices
+ *----------------------------------------------------------------------------*/
+bool UT_Atl03Reader::comparePolygon (List<MathLib::coord_t>& polygon, int test, uint32_t* seed)
+{
+    const int num_test_points = 2000;
+    bool passed = true;
+
+    PolygonIndex index(polygon);
+    List<MathLib::coord_t>::Iterator poly_iterator(polygon);
+    int num_points = poly_iterator.length;
+    MathLib::point_t* points = new MathLib::point_t [num_points];
+
+    for(int p = 0; passed && p < PolygonIndex::NUM_PROJECTIONS; p++)
+    {
+        MathLib::proj_t projection = (MathLib::proj_t)p;
+
+        /* Project Polygon */
+        for(int i = 0; i < num_points; i++)
+        {
+            points[i] = MathLib::coord2point(poly_iterator[i], projection);
+        }
+
+        /* Get Bounding Box */
+        MathLib::point_t min;
+        MathLib::point_t max;
+        index.boundingBox(projection, &min, &max);
+        double width = max.x - min.x;
+        double height = max.y - min.y;
+
+        /* Compare Inclusion of Points */
+        for(int i = 0; passed && i < num_test_points; i++)
+        {
+            double u1 = uniform(seed);
+            double u2 = uniform(seed);
+            int vertex = (int)(u2 * num_points) % num_points;
+            MathLib::point_t point;
+            switch(i % 5)
+            {
+                case 0: // around bounding box
+                    point.x = min.x - (0.1 * width) + (1.2 * width * u1);
+                    point.y = min.y - (0.1 * height) + (1.2 * height * u2);
+                    break;
+                case 1: // on left or right of bounding box (including corners)
+                    point.x = (u1 < 0.5) ? min.x : max.x;
+                    point.y = (i % 50 == 1) ? ((u2 < 0.5) ? min.y : max.y) : min.y + (height * u2);
+                    break;
+                case 2: // on bottom or top of bounding box
+                    point.x = min.x + (width * u2);
+                    point.y = (u1 < 0.5) ? min.y : max.y;
+                    break;
+                case 3: // on vertex
+                    point = points[vertex];
+                    break;
+                default: // level with vertex
+                    point.x = min.x - (0.1 * width) + (1.2 * width * u1);
+                    point.y = points[vertex].y;
+                    break;
+            }
+
+            bool expected = MathLib::inpoly(points, num_points, point);
+            if(index.inside(point, projection) != expected)
+            {
+                mlog(CRITICAL, "Failed polygon test %d (%d vertices) in projection %d at %.17lf, %.17lf: expected %s", test, num_points, p, point.x, point.y, expected ? "inside" : "outside");
+                passed = false;
+            }
+        }
+    }
+
+    delete [] points;
+
+    return passed;
+}
+
+/*----------------------------------------------------------------------------
+ * uniform
+ *
+ *  pseudo random number in [0, 1) reproducible from seed
+ *----------------------------------------------------------------------------*/
+double UT_Atl03Reader::uniform (uint32_t* seed)
+{
+    *seed = (*seed * 1103515245) + 12345;
+    return (double)(*seed >> 8) / (double)(1 << 24);
+}
+
+/*----------------------------------------------------------------------------
+ * producerThread
+ *
+ *  pushes the items of the queue test in order, sleeping while the queue
+ *  is full
+ *----------------------------------------------------------------------------*/
+void* UT_Atl03Reader::producerThread (void* parm)
+{
+    producer_t* producer = (producer_t*)parm;
+
+    long item = 0;
+    while(producer->active && item < producer->num_items)
+    {
+        if(producer->queue->push(item))
+        {
+            item++;
+        }
+        else
+        {
+            producer->queue->waitPush(SYS_TIMEOUT);
+        }
+    }
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+ * cacheData
+ *
+ *  data of a cache test entry (allocated with new [] as the cache expects)
+ *----------------------------------------------------------------------------*/
+unsigned char* UT_Atl03Reader::cacheData (long size, unsigned char value)
+{
+    unsigned char* data = new unsigned char [size];
+    LocalLib::set(data, value, size);
+    return data;
+}
+
+/*----------------------------------------------------------------------------
+ * checkData
+ *----------------------------------------------------------------------------*/
+bool UT_Atl03Reader::checkData (GranuleCache::entry_t* entry, unsigned char value)
+{
+    for(long i = 0; i < entry->size; i++)
+    {
+        if(entry->data[i] != value) return false;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+ * cached
+ *----------------------------------------------------------------------------*/
+bool UT_Atl03Reader::cached (const char* key)
+{
+    GranuleCache::entry_t* entry = GranuleCache::acquire(key);
+    if(entry)
+    {
+        GranuleCache::release(entry);
+        return true;
+    }
+
+    return false;
+}
+
+/*----------------------------------------------------------------------------
+ * buildPairTrack
+ *
+ *  segments about 20m apart with gaps of missing segments and runs of
+ *  segments without photons; ATL08 classifies most segments, repeating
+ *  and skipping photons and classifying photons past the end of segments
+ *----------------------------------------------------------------------------*/
+void UT_Atl03Reader::buildPairTrack (pair_track_t* pt, int test, uint32_t* seed)
+{
+    /* Build Segments */
+    int max_count = 10 + (test * 30);
+    pt->num_segments = 2000 + (test * 1000);
+    pt->segment_ph_cnt = new int32_t [pt->num_segments];
+    pt->segment_dist_x = new double [pt->num_segments];
+    pt->segment_id = new int32_t [pt->num_segments];
+    pt->num_photons = 0;
+    double distance = 1000000.0;
+    for(long s = 0; s < pt->num_segments; s++)
+    {
+        int32_t count = (uniform(seed) < 0.1) ? 0 : (int32_t)(uniform(seed) * max_count);
+        if(((s / 300) % 5) == 4) count = 0;
+        pt->segment_ph_cnt[s] = count;
+        pt->segment_dist_x[s] = distance;
+        pt->segment_id[s] = 5000 + s;
+        pt->num_photons += count;
+
+        distance += Atl03Reader::ATL03_SEGMENT_LENGTH + ((uniform(seed) - 0.5) * 0.1);
+        if(uniform(seed) < 0.01) distance += Atl03Reader::ATL03_SEGMENT_LENGTH * (1 + (int)(uniform(seed) * 5));
+    }
+
+    /* Build Photons */
+    pt->dist_ph_along = new float [pt->num_photons];
+    pt->h_ph = new float [pt->num_photons];
+    pt->signal_conf_ph = new int8_t [pt->num_photons];
+    pt->lat_ph = new double [pt->num_photons];
+    pt->lon_ph = new double [pt->num_photons];
+    pt->delta_time = new double [pt->num_photons];
+    long photon = 0;
+    for(long s = 0; s < pt->num_segments; s++)
+    {
+        double along = 0.0;
+        for(int32_t k = 0; k < pt->segment_ph_cnt[s]; k++)
+        {
+            along += uniform(seed) * (Atl03Reader::ATL03_SEGMENT_LENGTH / (pt->segment_ph_cnt[s] + 1));
+            pt->dist_ph_along[photon] = (float)along;
+            pt->h_ph[photon] = (float)(100.0 + (uniform(seed) * 5.0));
+            pt->signal_conf_ph[photon] = (int8_t)((int)(uniform(seed) * 7) + CNF_POSSIBLE_TEP);
+            pt->lat_ph[photon] = -40.0 + (s * 0.002);
+            pt->lon_ph[photon] = 10.0 + (s * 0.0005);
+            pt->delta_time[photon] = (s * 0.003) + (k * 0.00001);
+            photon++;
+        }
+    }
+
+    /* Build ATL08 Classifications */
+    List<int32_t> ph_segment_id;
+    List<int32_t> classed_pc_indx;
+    List<int8_t> classed_pc_flag;
+    for(long s = 0; s < pt->num_segments; s++)
+    {
+        if(uniform(seed) < 0.2) continue;
+        int32_t pc = 0;
+        while(true)
+        {
+            pc += (uniform(seed) < 0.1) ? 0 : 1 + (int32_t)(uniform(seed) * 3);
+            if(pc > pt->segment_ph_cnt[s] + 2) break;
+            ph_segment_id.add(pt->segment_id[s]);
+            classed_pc_indx.add(pc);
+            classed_pc_flag.add((int8_t)(uniform(seed) * NUM_ATL08_CLASSES));
+        }
+    }
+    pt->num_classed = ph_segment_id.length();
+    pt->ph_segment_id = new int32_t [pt->num_classed];
+    pt->classed_pc_indx = new int32_t [pt->num_classed];
+    pt->classed_pc_flag = new int8_t [pt->num_classed];
+    for(long i = 0; i < pt->num_classed; i++)
+    {
+        pt->ph_segment_id[i] = ph_segment_id[i];
+        pt->classed_pc_indx[i] = classed_pc_indx[i];
+        pt->classed_pc_flag[i] = classed_pc_flag[i];
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * freePairTrack
+ *----------------------------------------------------------------------------*/
+void UT_Atl03Reader::freePairTrack (pair_track_t* pt)
+{
+    delete [] pt->segment_ph_cnt;
+    delete [] pt->segment_dist_x;
+    delete [] pt->segment_id;
+    delete [] pt->dist_ph_along;
+    delete [] pt->h_ph;
+    delete [] pt->signal_conf_ph;
+    delete [] pt->lat_ph;
+    delete [] pt->lon_ph;
+    delete [] pt->delta_time;
+    delete [] pt->ph_segment_id;
+    delete [] pt->classed_pc_indx;
+    delete [] pt->classed_pc_flag;
+    LocalLib::set(pt, 0, sizeof(pair_track_t));
+}
+
+/*----------------------------------------------------------------------------
+ * referenceExtent
+ *
+ *  the photons of the extent at the reference walk, moving the walk to the
+ *  next extent; the photons of the extent are walked from its first photon
+ *  and classified as they are walked, looking up their ATL08 classification
+ *  from the first ATL08 photon of the extent; returns whether the extent is
+ *  valid
+ *----------------------------------------------------------------------------*/
+bool UT_Atl03Reader::referenceExtent (reference_t* ref, pair_track_t* pt, const atl06_parms_t* parms, List<Atl03Reader::photon_t>& photons)
+{
+    /* Setup Variables for Extent */
+    int32_t current_photon = ref->ph_in;
+    int32_t current_segment = ref->seg_in;
+    int32_t current_count = ref->seg_ph; // number of photons in current segment already accounted for
+    int32_t current_atl08_photon = ref->atl08_in;
+    bool extent_complete = false;
+    bool step_complete = false;
+
+    /* Set Extent Segment */
+    ref->extent_segment = ref->seg_in;
+    ref->start_seg_portion = pt->dist_ph_along[current_photon] / Atl03Reader::ATL03_SEGMENT_LENGTH;
+
+    /* Traverse Photons Until Desired Along Track Distance Reached */
+    while(!extent_complete || !step_complete)
+    {
+        /* Go to Photon's Segment */
+        current_count++;
+        while((current_segment < pt->num_segments) &&
+              (current_count > pt->segment_ph_cnt[current_segment]))
+        {
+            current_count = 1; // reset photons in segment
+            current_segment++; // go to next segment
+        }
+
+        /* Check Current Segment */
+        if(current_segment >= pt->num_segments)
+        {
+            ref->track_complete = true;
+            break;
+        }
+
+        /* Update Along Track Distance */
+        double delta_distance = pt->segment_dist_x[current_segment] - ref->start_distance;
+        double along_track_distance = delta_distance + pt->dist_ph_along[current_photon];
+
+        /* Set Next Extent's First Photon */
+        if(!step_complete && along_track_distance >= parms->extent_step)
+        {
+            ref->ph_in = current_photon;
+            ref->seg_in = current_segment;
+            ref->seg_ph = current_count - 1;
+            ref->atl08_in = current_atl08_photon;
+            step_complete = true;
+        }
+
+        /* Check if Photon within Extent's Length */
+        if(along_track_distance < parms->extent_length)
+        {
+            /* Find ATL08 Classification */
+            atl08_classification_t classification = ATL08_UNCLASSIFIED;
+            bool acceptable_classification = true;
+            if(parms->use_atl08_classification)
+            {
+                /* Go To Segment */
+                while( (current_atl08_photon < pt->num_classed) &&
+                       (pt->ph_segment_id[current_atl08_photon] < pt->segment_id[current_segment]) )
+                {
+                    current_atl08_photon++;
+                }
+
+                /* Go To Photon */
+                while( (current_atl08_photon < pt->num_classed) &&
+                       (pt->ph_segment_id[current_atl08_photon] == pt->segment_id[current_segment]) &&
+                       (pt->classed_pc_indx[current_atl08_photon] < current_count) )
+                {
+                    current_atl08_photon++;
+                }
+
+                /* Check Match */
+                if( (current_atl08_photon < pt->num_classed) &&
+                    (pt->ph_segment_id[current_atl08_photon] == pt->segment_id[current_segment]) &&
+                    (pt->classed_pc_indx[current_atl08_photon] == current_count) )
+                {
+                    classification = (atl08_classification_t)pt->classed_pc_flag[current_atl08_photon];
+                    acceptable_classification = parms->atl08_class[classification];
+                    current_atl08_photon++;
+                }
+                else
+                {
+                    acceptable_classification = parms->atl08_class[ATL08_UNCLASSIFIED];
+                }
+            }
+
+            /* Check Photon Signal Confidence Level and Classification */
+            int8_t cnf = pt->signal_conf_ph[current_photon];
+            if(acceptable_classification && (cnf >= parms->signal_confidence))
+            {
+                Atl03Reader::photon_t ph = {
+                    .delta_time = pt->delta_time[current_photon],
+                    .latitude = pt->lat_ph[current_photon],
+                    .longitude = pt->lon_ph[current_photon],
+                    .distance = along_track_distance - (parms->extent_length / 2.0),
+                    .height = pt->h_ph[current_photon],
+                    .atl08_class = (uint16_t)classification,
+                    .atl03_cnf = (int16_t)cnf
+                };
+                photons.add(ph);
+            }
+        }
+        else
+        {
+            extent_complete = true;
+        }
+
+        /* Go to Next Photon */
+        current_photon++;
+
+        /* Check Current Photon */
+        if(current_photon >= pt->num_photons)
+        {
+            ref->track_complete = true;
+            break;
+        }
+    }
+
+    /* Add Step to Start Distance */
+    ref->start_distance += parms->extent_step;
+
+    /* Apply Segment Distance Correction and Update Start Segment */
+    while( ((ref->start_segment + 1) < pt->num_segments) &&
+            (ref->start_distance >= pt->segment_dist_x[ref->start_segment + 1]) )
+    {
+        ref->start_distance += pt->segment_dist_x[ref->start_segment + 1] - pt->segment_dist_x[ref->start_segment];
+        ref->start_distance -= Atl03Reader::ATL03_SEGMENT_LENGTH;
+        ref->start_segment++;
+    }
+
+    /* Check Photon Count and Along Track Spread */
+    if(photons.length() < parms->minimum_photon_count) return false;
+    if(photons.length() > 1 && (photons[photons.length() - 1].distance - photons[0].distance) < parms->along_track_spread) return false;
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+ * samePhoton
+ *----------------------------------------------------------------------------*/
+bool UT_Atl03Reader::samePhoton (const Atl03Reader::photon_t& photon1, const Atl03Reader::photon_t& photon2)
+{
+    return (photon1.delta_time == photon2.delta_time) &&
+           (photon1.latitude == photon2.latitude) &&
+           (photon1.longitude == photon2.longitude) &&
+           (photon1.distance == photon2.distance) &&
+           (photon1.height == photon2.height) &&
+           (photon1.atl08_class == photon2.atl08_class) &&
+           (photon1.atl03_cnf == photon2.atl03_cnf);
+}
+
+/*----------------------------------------------------------------------------
+ * fillTrack
+ *
+ *  fills the stream of a pair track with the rows given, as if read in a
+ *  single window
+ *----------------------------------------------------------------------------*/
+template <class T>
+void UT_Atl03Reader::fillTrack (typename GTStream<T>::Track& track, const T* rows, long num_rows)
+{
+    track.buffer = new T [num_rows + 1]; // never empty
+    LocalLib::copy(track.buffer, rows, num_rows * sizeof(T));
+    track.data = track.buffer;
+    track.base = 0;
+    track.length = num_rows;
+    track.size = num_rows;
+}
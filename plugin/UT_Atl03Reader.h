@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2021, University of Washington
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ *    this list of conditions and the following disclaimer in the documentation 
+ *    and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the University of Washington nor the names of its 
+ *    contributors may be used to endorse or promote products derived from this 
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE UNIVERSITY OF WASHINGTON AND CONTRIBUTORS
+ * “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE UNIVERSITY OF WASHINGTON OR 
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, 
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR 
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF 
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __ut_atl03reader__
+#define __ut_atl03reader__
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include "OsApi.h"
+#include "LuaObject.h"
+#include "List.h"
+#include "MathLib.h"
+#include "GranuleCache.h"
+#include "GTStream.h"
+#include "SpscQueue.h"
+#include "Atl03Reader.h"
+
+/******************************************************************************
+ * ATL03 READER UNIT TEST CLASS
+ ******************************************************************************/
+
+class UT_Atl03Reader: public LuaObject
+{
+    public:
+
+        /*--------------------------------------------------------------------
+         * Constants
+         *--------------------------------------------------------------------*/
+
+        static const char* OBJECT_TYPE;
+
+        static const char* LuaMetaName;
+        static const struct luaL_Reg LuaMetaTable[];
+
+        /*--------------------------------------------------------------------
+         * Methods
+         *--------------------------------------------------------------------*/
+
+        static int  luaCreate   (lua_State* L);
+
+    private:
+
+        /*--------------------------------------------------------------------
+         * Types
+         *--------------------------------------------------------------------*/
+
+        typedef struct {
+            SpscQueue<long>*    queue;
+            long                num_items;
+            bool                active;
+        } producer_t;
+
+        /* Synthetic Pair Track (in place of the datasets of a granule) */
+        typedef struct {
+            long                num_segments;
+            int32_t*            segment_ph_cnt;
+            double*             segment_dist_x;
+            int32_t*            segment_id;
+            long                num_photons;
+            float*              dist_ph_along;
+            float*              h_ph;
+            int8_t*             signal_conf_ph;
+            double*             lat_ph;
+            double*             lon_ph;
+            double*             delta_time;
+            long                num_classed;    // photons classified by ATL08
+            int32_t*            ph_segment_id;
+            int32_t*            classed_pc_indx;
+            int8_t*             classed_pc_flag;
+        } pair_track_t;
+
+        /* Reference Walk of a Pair Track (one extent at a time) */
+        typedef struct {
+            int32_t             ph_in;
+            int32_t             seg_in;
+            int32_t             seg_ph;
+            int32_t             start_segment;
+            double              start_distance;
+            int32_t             extent_segment;
+            double              start_seg_portion;
+            bool                track_complete;
+            int32_t             atl08_in;
+        } reference_t;
+
+        /*--------------------------------------------------------------------
+         * Methods
+         *--------------------------------------------------------------------*/
+
+                        UT_Atl03Reader          (lua_State* L);
+                        ~UT_Atl03Reader         (void);
+
+        static int      luaPolygonTest          (lua_State* L);
+        static int      luaQueueTest            (lua_State* L);
+        static int      luaCacheTest            (lua_State* L);
+        static int      luaExtentTest           (lua_State* L);
+
+        static bool     comparePolygon          (List<MathLib::coord_t>& polygon, int test, uint32_t* seed);
+        static double   uniform                 (uint32_t* seed);
+        static void*    producerThread          (void* parm);
+        static unsigned char* cacheData         (long size, unsigned char value);
+        static bool     checkData               (GranuleCache::entry_t* entry, unsigned char value);
+        static bool     cached                  (const char* key);
+        static void     buildPairTrack          (pair_track_t* pt, int test, uint32_t* seed);
+        static void     freePairTrack           (pair_track_t* pt);
+        static bool     referenceExtent         (reference_t* ref, pair_track_t* pt, const atl06_parms_t* parms, List<Atl03Reader::photon_t>& photons);
+        static bool     samePhoton              (const Atl03Reader::photon_t& photon1, const Atl03Reader::photon_t& photon2);
+
+        template <class T>
+        static void     fillTrack               (typename GTStream<T>::Track& track, const T* rows, long num_rows);
+};
+
+#endif  /* __ut_atl03reader__ */
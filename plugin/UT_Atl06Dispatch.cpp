@@ -36,8 +36,10 @@
 #include "core.h"
 #include "UT_Atl06Dispatch.h"
 #include "Atl06Dispatch.h"
+#include "lua_parms.h"
 
 #include <cmath>
+#include <cfloat>
 
 /******************************************************************************
  * STATIC DATA
@@ -49,6 +51,9 @@ const char* UT_Atl06Dispatch::LuaMetaName = "UT_Atl06Dispatch";
 const struct luaL_Reg UT_Atl06Dispatch::LuaMetaTable[] = {
     {"lsftest",     luaLsfTest},
     {"sorttest",    luaSortTest},
+    {"rdetest",     luaDispersionTest},
+    {"kerneltest",  luaKernelTest},
+    {"fittest",     luaFitTest},
     {NULL,          NULL}
 };
 
@@ -219,3 +224,617 @@ int UT_Atl06Dispatch::luaSortTest (lua_State* L)
     /* Return Status */
     return returnLuaStatus(L, status);
 }
+
+/*----------------------------------------------------------------------------
+ * luaDispersionTest
+ *
+ *  checks that the robust dispersion estimate is bit-identical to the
+ *  estimate calculated from fully sorted residuals
+ *----------------------------------------------------------------------------*/
+int UT_Atl06Dispatch::luaDispersionTest (lua_State* L)
+{
+    bool status = false;
+
+    const int max_residuals = 600;
+    double* residuals = new double [max_residuals];
+    double* scratch = new double [max_residuals];
+    uint8_t* ranked = new uint8_t [max_residuals];
+
+    try
+    {
+        bool tests_passed = true;
+        uint32_t seed = 0x5EED;
+
+        for(int test = 0; tests_passed && test < 1000; test++)
+        {
+            /* Generate Residuals (signal around zero with uniform background) */
+            int size = 1 + (test % max_residuals);
+            int signal_percent = test % 101;
+            bool quantize = (test % 3) == 0; // exercises equal residuals
+            for(int i = 0; i < size; i++)
+            {
+                seed = (seed * 1103515245) + 12345;
+                double u = (double)(seed >> 8) / (double)(1 << 24);
+                double r;
+                if((int)(u * 100000) % 100 < signal_percent)    r = (u - 0.5) * 0.5;
+                else                                            r = (u - 0.5) * 40.0;
+                if(quantize) r = floor(r * 4.0) / 4.0;
+                residuals[i] = r;
+            }
+
+            /* Select Window (initial iteration uses extent of residuals) */
+            double window_lower_bound;
+            double window_upper_bound;
+            if(test % 2 == 0)
+            {
+                window_lower_bound = residuals[0];
+                window_upper_bound = residuals[0];
+                for(int i = 1; i < size; i++)
+                {
+                    if(residuals[i] < window_lower_bound) window_lower_bound = residuals[i];
+                    if(residuals[i] > window_upper_bound) window_upper_bound = residuals[i];
+                }
+            }
+            else
+            {
+                window_lower_bound = -(1.0 + (test % 20));
+                window_upper_bound = 1.0 + (test % 20);
+            }
+            if(window_upper_bound == window_lower_bound) continue;
+            double background_count = (window_upper_bound - window_lower_bound) * (test % 7) * size / 100.0;
+
+            /* Compare Estimates */
+            double sigma_r_sorted = 0.0;
+            double sigma_r = 0.0;
+            LocalLib::copy(scratch, residuals, sizeof(double) * size);
+            bool valid_sorted = sortedDispersion(scratch, size, window_lower_bound, window_upper_bound, background_count, &sigma_r_sorted);
+            LocalLib::copy(scratch, residuals, sizeof(double) * size);
+            bool valid = Atl06Dispatch::robustDispersion(scratch, ranked, size, window_lower_bound, window_upper_bound, background_count, &sigma_r);
+            if(valid != valid_sorted || memcmp(&sigma_r, &sigma_r_sorted, sizeof(double)) != 0)
+            {
+                mlog(CRITICAL, "Failed dispersion test %d (%d photons): %d, %.17lf != %d, %.17lf", test, size, valid, sigma_r, valid_sorted, sigma_r_sorted);
+                tests_passed = false;
+            }
+        }
+
+        /* Set Status */
+        status = tests_passed;
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Error executing test %s: %s", __FUNCTION__, e.what());
+    }
+
+    /* Clean Up */
+    delete [] residuals;
+    delete [] scratch;
+    delete [] ranked;
+
+    /* Return Status */
+    return returnLuaStatus(L, status);
+}
+
+/*----------------------------------------------------------------------------
+ * luaKernelTest
+ *
+ *  checks that every vectorized kernel supported by the processor produces
+ *  the same bits as the scalar kernels
+ *----------------------------------------------------------------------------*/
+int UT_Atl06Dispatch::luaKernelTest (lua_State* L)
+{
+    bool status = false;
+
+    const int max_photons = 100;
+    double* x = new double [max_photons + 1];
+    double* y = new double [max_photons + 1];
+    double* h = new double [max_photons + 1];
+    double* slope = new double [max_photons + 1];
+    double* spread = new double [max_photons + 1];
+    double* r1 = new double [max_photons + 1];
+    double* r2 = new double [max_photons + 1];
+    uint8_t* in1 = new uint8_t [max_photons + 1];
+    uint8_t* in2 = new uint8_t [max_photons + 1];
+
+    try
+    {
+        bool tests_passed = true;
+        uint32_t seed = 0xCAFE;
+        const Atl06Kernels::kernels_t* scalar = Atl06Kernels::get(Atl06Kernels::SCALAR);
+
+        for(int isa = Atl06Kernels::SCALAR + 1; isa < Atl06Kernels::NUM_ISAS; isa++)
+        {
+            const Atl06Kernels::kernels_t* kernels = Atl06Kernels::get((Atl06Kernels::isa_t)isa);
+            if(!kernels) continue;
+
+            for(int size = 0; tests_passed && size <= max_photons; size++)
+            {
+                /* Generate Photons of Fits of Ten Photons (offset by one for unaligned access) */
+                int offset = size % 2;
+                for(int i = 0; i < size + offset; i++)
+                {
+                    int fit = i / 10;
+                    seed = (seed * 1103515245) + 12345;
+                    x[i] = (double)(seed >> 8) / (double)(1 << 19); // 0 to 32 meters
+                    seed = (seed * 1103515245) + 12345;
+                    y[i] = 1500.0 + fit + ((double)(seed >> 8) / (double)(1 << 20)) + (0.05 * x[i]);
+                    h[i] = 1500.5 + fit;
+                    slope[i] = 0.05;
+                    spread[i] = 0.25 * (1 + (fit % 3));
+                }
+
+                /* Sums */
+                double s1[4], s2[4];
+                scalar->sums(&x[offset], &y[offset], size, &s1[0], &s1[1], &s1[2], &s1[3]);
+                kernels->sums(&x[offset], &y[offset], size, &s2[0], &s2[1], &s2[2], &s2[3]);
+                if(memcmp(s1, s2, sizeof(s1)) != 0)
+                {
+                    mlog(CRITICAL, "Failed %s sums test with %d photons", kernels->name, size);
+                    tests_passed = false;
+                }
+
+                /* Residuals */
+                scalar->residuals(&x[offset], &y[offset], &h[offset], &slope[offset], size, &r1[offset]);
+                kernels->residuals(&x[offset], &y[offset], &h[offset], &slope[offset], size, &r2[offset]);
+                if(memcmp(&r1[offset], &r2[offset], sizeof(double) * size) != 0)
+                {
+                    mlog(CRITICAL, "Failed %s residuals test with %d photons", kernels->name, size);
+                    tests_passed = false;
+                }
+
+                /* Window */
+                scalar->window(&r1[offset], &spread[offset], size, &in1[offset]);
+                kernels->window(&r1[offset], &spread[offset], size, &in2[offset]);
+                if(memcmp(&in1[offset], &in2[offset], sizeof(uint8_t) * size) != 0)
+                {
+                    mlog(CRITICAL, "Failed %s window test with %d photons", kernels->name, size);
+                    tests_passed = false;
+                }
+            }
+
+            mlog(INFO, "Tested %s kernels", kernels->name);
+        }
+
+        /* Set Status */
+        status = tests_passed;
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Error executing test %s: %s", __FUNCTION__, e.what());
+    }
+
+    /* Clean Up */
+    delete [] x;
+    delete [] y;
+    delete [] h;
+    delete [] slope;
+    delete [] spread;
+    delete [] r1;
+    delete [] r2;
+    delete [] in1;
+    delete [] in2;
+
+    /* Return Status */
+    return returnLuaStatus(L, status);
+}
+
+/*----------------------------------------------------------------------------
+ * luaFitTest - :fittest([<parms>])
+ *
+ *  checks every elevation fit by the dispatcher against a reference fit that
+ *  sorts the photons by residual on every iteration; only the robust
+ *  dispersion estimate is bit-identical to the sorted fit (the least squares
+ *  sums add the photons in along-track order instead of residual order), so
+ *  counts and flags must match exactly and all other fields must match to
+ *  within a relative tolerance
+ *----------------------------------------------------------------------------*/
+int UT_Atl06Dispatch::luaFitTest (lua_State* L)
+{
+    bool status = false;
+
+    const int num_extents = 512;
+    const int group_size = 32; // extents fit together; too few to fill an output batch
+    const int max_photons = 400;
+    Atl03Reader::extent_t** extents = new Atl03Reader::extent_t* [num_extents];
+    LocalLib::set(extents, 0, sizeof(Atl03Reader::extent_t*) * num_extents);
+    Atl06Dispatch* dispatch = NULL;
+
+    try
+    {
+        bool tests_passed = true;
+        double tolerance = 0.000000001;
+        uint32_t seed = 0xF17;
+
+        /* Create Dispatcher (owns parameters) */
+        atl06_parms_t* parms = getLuaAtl06Parms(L, 2);
+        parms->stages[STAGE_LSF] = true;
+        parms->compact = false;
+        dispatch = new Atl06Dispatch(L, "ut_atl06_fittest", parms);
+
+        /* Generate Extents (surface with slope and noise, plus uniform background) */
+        for(int e = 0; e < num_extents; e++)
+        {
+            uint32_t photon_count[PAIR_TRACKS_PER_GROUND_TRACK];
+            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+            {
+                seed = (seed * 1103515245) + 12345;
+                photon_count[t] = ((e % 13) == t) ? 0 : (seed >> 8) % max_photons;
+            }
+
+            int extent_bytes = sizeof(Atl03Reader::extent_t) + (sizeof(Atl03Reader::photon_t) * (photon_count[PRT_LEFT] + photon_count[PRT_RIGHT]));
+            extents[e] = (Atl03Reader::extent_t*)new unsigned char [extent_bytes];
+            Atl03Reader::extent_t* extent = extents[e];
+            LocalLib::set(extent, 0, extent_bytes);
+            extent->reference_pair_track = 1 + (e % NUM_TRACKS);
+            extent->spacecraft_orientation = e % 2;
+
+            int first_photon = 0;
+            for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+            {
+                extent->valid[t] = (e % 17) != t;
+                extent->segment_id[t] = (e * PAIR_TRACKS_PER_GROUND_TRACK) + t;
+                extent->extent_length[t] = 40.0;
+                extent->spacecraft_velocity[t] = 7000.0;
+                seed = (seed * 1103515245) + 12345;
+                extent->background_rate[t] = ((double)(seed >> 8) / (double)(1 << 24)) * 10000000.0 * (e % 4);
+                extent->photon_count[t] = photon_count[t];
+                extent->photon_offset[t] = first_photon;
+
+                seed = (seed * 1103515245) + 12345;
+                double surface = 100.0 + ((double)(seed >> 8) / (double)(1 << 14));
+                seed = (seed * 1103515245) + 12345;
+                double slope = ((double)(seed >> 8) / (double)(1 << 24)) - 0.5;
+                double noise = 0.1 * (e % 5);
+                double longitude = (e % 3) ? -179.99 : 179.99; // shifted longitudes around the dateline
+                for(uint32_t p = 0; p < photon_count[t]; p++)
+                {
+                    Atl03Reader::photon_t* ph = &extent->photons[first_photon + p];
+                    seed = (seed * 1103515245) + 12345;
+                    double u1 = (double)(seed >> 8) / (double)(1 << 24);
+                    seed = (seed * 1103515245) + 12345;
+                    double u2 = (double)(seed >> 8) / (double)(1 << 24);
+                    ph->distance = (40.0 * (p + u1)) / photon_count[t];
+                    if(u2 < 0.3)    ph->height = surface + ((u2 - 0.15) * 200.0);
+                    else            ph->height = surface + (slope * ph->distance) + ((u1 - 0.5) * noise);
+                    ph->latitude = 60.0 + (e * 0.001) + (ph->distance * 0.00001);
+                    ph->longitude = longitude + ((e % 2) ? 1.0 : -1.0) * (ph->distance * 0.00001);
+                    ph->delta_time = e + (ph->distance / extent->spacecraft_velocity[t]);
+                }
+                first_photon += photon_count[t];
+            }
+        }
+
+        /* Fit Groups of Extents and Compare Elevations */
+        for(int first = 0; tests_passed && first < num_extents; first += group_size)
+        {
+            int num_group_extents = MIN(group_size, num_extents - first);
+            dispatch->fitExtents(&extents[first], num_group_extents);
+
+            /* Get Elevations from Calling Thread's Output Batch */
+            Atl06Dispatch::batch_t* batch = dispatch->getBatch();
+            batch->mutex.lock();
+            {
+                Atl06Dispatch::atl06_t* data = NULL;
+                if(batch->record) data = (Atl06Dispatch::atl06_t*)batch->record->getRecordData();
+
+                int num_elevations = 0;
+                for(int e = first; e < first + num_group_extents; e++)
+                {
+                    for(int t = 0; t < PAIR_TRACKS_PER_GROUND_TRACK; t++)
+                    {
+                        Atl06Dispatch::elevation_t expected;
+                        if(!sortedFit(extents[e], t, parms, &expected)) continue;
+
+                        if(num_elevations >= batch->count)
+                        {
+                            mlog(CRITICAL, "Failed fit test: missing elevation of extent %d, track %d", e, t);
+                            tests_passed = false;
+                        }
+                        else if(!matchElevation(&data->elevation[num_elevations], &expected, tolerance))
+                        {
+                            mlog(CRITICAL, "Failed fit test of extent %d, track %d", e, t);
+                            tests_passed = false;
+                        }
+                        num_elevations++;
+                    }
+                }
+
+                if(num_elevations != batch->count)
+                {
+                    mlog(CRITICAL, "Failed fit test: %d elevations fit, %d expected", batch->count, num_elevations);
+                    tests_passed = false;
+                }
+
+                /* Clear Batch */
+                delete batch->record;
+                batch->record = NULL;
+                batch->count = 0;
+            }
+            batch->mutex.unlock();
+        }
+
+        /* Set Status */
+        status = tests_passed;
+    }
+    catch(const RunTimeException& e)
+    {
+        mlog(e.level(), "Error executing test %s: %s", __FUNCTION__, e.what());
+    }
+
+    /* Clean Up */
+    delete dispatch;
+    for(int e = 0; e < num_extents; e++)
+    {
+        delete [] (unsigned char*)extents[e];
+    }
+    delete [] extents;
+
+    /* Return Status */
+    return returnLuaStatus(L, status);
+}
+
+/*----------------------------------------------------------------------------
+ * sortedDispersion
+ *
+ *  reference robust dispersion estimate that sorts all of the residuals
+ *----------------------------------------------------------------------------*/
+bool UT_Atl06Dispatch::sortedDispersion (double* residuals, int size, double window_lower_bound, double window_upper_bound, double background_count, double* sigma_r)
+{
+    /* Sort Residuals */
+    Atl06Dispatch::point_t* points = new Atl06Dispatch::point_t [size];
+    for(int p = 0; p < size; p++)
+    {
+        points[p].p = p;
+        points[p].r = residuals[p];
+    }
+    Atl06Dispatch::quicksort(points, 0, size - 1);
+
+    /* Calculate Robust Dispersion Estimate */
+    bool valid = true;
+    double background_rate = background_count / (window_upper_bound - window_lower_bound);
+    double signal_count = size - background_count;
+    if(signal_count <= 1)
+    {
+        *sigma_r = (window_upper_bound - window_lower_bound) / size;
+    }
+    else
+    {
+        int32_t i0 = 0;
+        while(i0 < size)
+        {
+            double spp = (0.25 * signal_count) + ((points[i0].r - window_lower_bound) * background_rate);
+            if( (((double)i0) + 1.0 - 0.5 + 1.0) < spp )    i0++;
+            else                                            break;
+        }
+
+        int32_t i1 = size - 1;
+        while(i1 >= 0)
+        {
+            double spp = (0.75 * signal_count) + ((points[i1].r - window_lower_bound) * background_rate);
+            if( (((double)i1) + 1.0 - 0.5 - 1.0) > spp )    i1--;
+            else                                            break;
+        }
+
+        if(i1 < i0)
+        {
+            double spp0 = (size / 2.0) - (signal_count / 4.0);
+            i0 = (int32_t)(spp0 + 0.5) - 1;
+            double spp1 = (size / 2.0) + (signal_count / 4.0);
+            i1 = (int32_t)(spp1 + 0.5);
+        }
+
+        if(i0 >= 0 && i1 < size)    *sigma_r = (points[i1].r - points[i0].r) / Atl06Dispatch::RDE_SCALE_FACTOR;
+        else                        valid = false;
+    }
+
+    /* Clean Up */
+    delete [] points;
+
+    return valid;
+}
+
+/*----------------------------------------------------------------------------
+ * sortedFit
+ *
+ *  reference iterative fit of one track of an extent that sorts the photons
+ *  by residual on every iteration and sums them in that order; returns false
+ *  if the track provides no elevation
+ *----------------------------------------------------------------------------*/
+bool UT_Atl06Dispatch::sortedFit (Atl03Reader::extent_t* extent, int track, const atl06_parms_t* parms, Atl06Dispatch::elevation_t* elevation)
+{
+    int t = track;
+
+    /* Elevation Attributes */
+    LocalLib::set(elevation, 0, sizeof(Atl06Dispatch::elevation_t));
+    elevation->segment_id = extent->segment_id[t];
+    elevation->rgt = extent->reference_ground_track_start;
+    elevation->cycle = extent->cycle_start;
+    elevation->photon_count = extent->photon_count[t];
+
+    /* Check Valid Extent */
+    if(!extent->valid[t] || elevation->photon_count <= 0)
+    {
+        return false;
+    }
+
+    /* Copy In Initial Set of Photons */
+    int first_photon = (t == PRT_LEFT) ? 0 : extent->photon_count[PRT_LEFT];
+    Atl06Dispatch::point_t* photons = new Atl06Dispatch::point_t [elevation->photon_count];
+    double* residuals = new double [elevation->photon_count];
+    for(int p = 0; p < elevation->photon_count; p++)
+    {
+        photons[p].p = first_photon + p;
+        photons[p].r = 0.0;
+    }
+
+    /* Initial Conditions */
+    bool done = false;
+    bool invalid = false;
+    int iteration = 0;
+    double pulses_in_extent = (extent->extent_length[t] * Atl06Dispatch::PULSE_REPITITION_FREQUENCY) / extent->spacecraft_velocity[t];
+    double background_density = pulses_in_extent * extent->background_rate[t] / (Atl06Dispatch::SPEED_OF_LIGHT / 2.0);
+
+    /* Iterate Processing of Photons */
+    while(!done)
+    {
+        int num_photons = elevation->photon_count;
+
+        /* Calculate Least Squares Fit */
+        Atl06Dispatch::lsf_t fit = Atl06Dispatch::lsf(extent, photons, num_photons, false);
+        elevation->h_mean = fit.height;
+        elevation->along_track_slope = fit.slope;
+        elevation->h_sigma = fit.y_sigma;
+
+        /* Calculate Residuals and Sort Points by Residuals */
+        for(int p = 0; p < num_photons; p++)
+        {
+            Atl03Reader::photon_t* ph = &extent->photons[photons[p].p];
+            photons[p].r = ph->height - (fit.height + (ph->distance * fit.slope));
+        }
+        Atl06Dispatch::quicksort(photons, 0, num_photons - 1);
+
+        /* Calculate Robust Dispersion Estimate */
+        double background_count;
+        double window_lower_bound;
+        double window_upper_bound;
+        if(iteration == 0)
+        {
+            window_lower_bound = photons[0].r;
+            window_upper_bound = photons[num_photons - 1].r;
+            background_count = background_density * (window_upper_bound - window_lower_bound);
+        }
+        else
+        {
+            background_count = background_density * elevation->window_height;
+            window_lower_bound = -(elevation->window_height / 2.0);
+            window_upper_bound = elevation->window_height / 2.0;
+        }
+        double sigma_r = 0.0;
+        for(int p = 0; p < num_photons; p++) residuals[p] = photons[p].r;
+        if(!sortedDispersion(residuals, num_photons, window_lower_bound, window_upper_bound, background_count, &sigma_r))
+        {
+            elevation->pflags |= Atl06Dispatch::PFLAG_OUT_OF_BOUNDS;
+            invalid = true;
+        }
+
+        /* Calculate Window Height */
+        double se1 = pow((Atl06Dispatch::SPEED_OF_LIGHT / 2.0) * Atl06Dispatch::SIGMA_XMIT, 2);
+        double se2 = pow(Atl06Dispatch::SIGMA_BEAM, 2) * pow(elevation->along_track_slope, 2);
+        double sigma_expected = sqrt(se1 + se2);
+        if(sigma_r > parms->maximum_robust_dispersion) sigma_r = parms->maximum_robust_dispersion;
+        double new_window_height = MAX(MAX(parms->minimum_window, 6.0 * sigma_expected), 6.0 * sigma_r);
+        elevation->window_height = MAX(new_window_height, 0.75 * elevation->window_height);
+        double window_spread = elevation->window_height / 2.0;
+
+        /* Check Conditions of Next Iteration */
+        int32_t next_num_photons = 0;
+        double x_min = DBL_MAX;
+        double x_max = DBL_MIN;
+        for(int p = 0; p < num_photons; p++)
+        {
+            if(fabs(photons[p].r) < window_spread)
+            {
+                double x = extent->photons[photons[p].p].distance;
+                next_num_photons++;
+                if(x < x_min) x_min = x;
+                if(x > x_max) x_max = x;
+            }
+        }
+
+        if(next_num_photons < parms->minimum_photon_count)
+        {
+            elevation->pflags |= Atl06Dispatch::PFLAG_TOO_FEW_PHOTONS;
+            invalid = true;
+            done = true;
+        }
+        else if((x_max - x_min) < parms->along_track_spread)
+        {
+            elevation->pflags |= Atl06Dispatch::PFLAG_SPREAD_TOO_SHORT;
+            invalid = true;
+            done = true;
+        }
+        else if(next_num_photons == num_photons)
+        {
+            done = true;
+        }
+        else if(++iteration >= parms->max_iterations)
+        {
+            elevation->pflags |= Atl06Dispatch::PFLAG_MAX_ITERATIONS_REACHED;
+            done = true;
+        }
+        else
+        {
+            /* Filter Out Photons (keeping residual order) */
+            int32_t ph_in = 0;
+            for(int p = 0; p < num_photons; p++)
+            {
+                if(fabs(photons[p].r) < window_spread)
+                {
+                    photons[ph_in++] = photons[p];
+                }
+            }
+            elevation->photon_count = ph_in;
+        }
+    }
+
+    /* Calculate RMS and Scale h_sigma */
+    double delta_sum = 0.0;
+    for(int p = 0; p < elevation->photon_count; p++)
+    {
+        delta_sum += photons[p].r * photons[p].r;
+    }
+    if(!invalid && elevation->photon_count > 0)
+    {
+        elevation->rms_misfit = sqrt(delta_sum / (double)elevation->photon_count);
+        elevation->h_sigma = elevation->rms_misfit * elevation->h_sigma;
+    }
+    else
+    {
+        elevation->rms_misfit = 0.0;
+        elevation->h_sigma = 0.0;
+    }
+
+    /* Calculate Latitude, Longitude, and GPS Time */
+    Atl06Dispatch::lsf_t fit = Atl06Dispatch::lsf(extent, photons, elevation->photon_count, true);
+    elevation->latitude = fit.latitude;
+    elevation->longitude = fit.longitude;
+    elevation->delta_time = fit.delta_time;
+
+    /* Clean Up */
+    delete [] photons;
+    delete [] residuals;
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+ * matchElevation
+ *
+ *  counts and flags must be identical; all other fields must be within the
+ *  tolerance relative to the expected value (or absolute below one)
+ *----------------------------------------------------------------------------*/
+bool UT_Atl06Dispatch::matchElevation (const Atl06Dispatch::elevation_t* elevation, const Atl06Dispatch::elevation_t* expected, double tolerance)
+{
+    if(elevation->segment_id != expected->segment_id ||
+       elevation->photon_count != expected->photon_count ||
+       elevation->pflags != expected->pflags ||
+       elevation->rgt != expected->rgt ||
+       elevation->cycle != expected->cycle)
+    {
+        mlog(CRITICAL, "Mismatched segment %u: %d photons, flags 0x%04X != %d photons, flags 0x%04X", elevation->segment_id, elevation->photon_count, elevation->pflags, expected->photon_count, expected->pflags);
+        return false;
+    }
+
+    const char* names[] = {"delta_time", "latitude", "longitude", "h_mean", "along_track_slope", "across_track_slope", "window_height", "rms_misfit", "h_sigma"};
+    double values[] = {elevation->delta_time, elevation->latitude, elevation->longitude, elevation->h_mean, elevation->along_track_slope, elevation->across_track_slope, elevation->window_height, elevation->rms_misfit, elevation->h_sigma};
+    double expected_values[] = {expected->delta_time, expected->latitude, expected->longitude, expected->h_mean, expected->along_track_slope, expected->across_track_slope, expected->window_height, expected->rms_misfit, expected->h_sigma};
+    for(unsigned i = 0; i < sizeof(values) / sizeof(double); i++)
+    {
+        if(fabs(values[i] - expected_values[i]) > tolerance * MAX(1.0, fabs(expected_values[i])))
+        {
+            mlog(CRITICAL, "Mismatched %s of segment %u: %.17lf != %.17lf", names[i], elevation->segment_id, values[i], expected_values[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
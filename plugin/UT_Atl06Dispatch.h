@@ -38,6 +38,8 @@
 
 #include "OsApi.h"
 #include "LuaObject.h"
+#include "Atl03Reader.h"
+#include "Atl06Dispatch.h"
 
 /******************************************************************************
  * MATH LIBRARY UNIT TEST CLASS
@@ -74,6 +76,13 @@ class UT_Atl06Dispatch: public LuaObject
 
         static int      luaLsfTest              (lua_State* L);
         static int      luaSortTest             (lua_State* L);
+        static int      luaDispersionTest       (lua_State* L);
+        static int      luaKernelTest           (lua_State* L);
+        static int      luaFitTest              (lua_State* L);
+
+        static bool     sortedDispersion        (double* residuals, int size, double window_lower_bound, double window_upper_bound, double background_count, double* sigma_r);
+        static bool     sortedFit               (Atl03Reader::extent_t* extent, int track, const atl06_parms_t* parms, Atl06Dispatch::elevation_t* elevation);
+        static bool     matchElevation          (const Atl06Dispatch::elevation_t* elevation, const Atl06Dispatch::elevation_t* expected, double tolerance);
 };
 
 #endif  /* __ut_atl06dispatch__ */
@@ -70,6 +70,10 @@ int icesat2_open (lua_State *L)
         {"atl03",           Atl03Reader::luaCreate},
         {"atl03indexer",    Atl03Indexer::luaCreate},
         {"atl06",           Atl06Dispatch::luaCreate},
+        {"cache",           GranuleCache::luaSize},
+        {"cachestats",      GranuleCache::luaStats},
+        {"readers",         ReaderPool::luaConcurrency},
+        {"ut_atl03",        UT_Atl03Reader::luaCreate},
         {"ut_atl06",        UT_Atl06Dispatch::luaCreate},
         {"version",         icesat2_version},
         {NULL,              NULL}
@@ -93,11 +97,19 @@ int icesat2_open (lua_State *L)
     LuaEngine::setAttrInt(L, "SRT_INLAND_WATER",                    SRT_INLAND_WATER);
     LuaEngine::setAttrInt(L, LUA_PARM_STAGE_LSF,                    STAGE_LSF);
     LuaEngine::setAttrInt(L, "ALL_STAGES",                          NUM_STAGES);
+    LuaEngine::setAttrInt(L, "CONSUMER_ATL06",                      CONSUMER_ATL06);
+    LuaEngine::setAttrInt(L, "CONSUMER_ATL03",                      CONSUMER_ATL03);
     LuaEngine::setAttrInt(L, "ALL_TRACKS",                          ALL_TRACKS);
     LuaEngine::setAttrInt(L, "RPT_1",                               RPT_1);
     LuaEngine::setAttrInt(L, "RPT_2",                               RPT_2);
     LuaEngine::setAttrInt(L, "RPT_3",                               RPT_3);
     LuaEngine::setAttrInt(L, "NUM_TRACKS",                          NUM_TRACKS);
+    LuaEngine::setAttrInt(L, "GT1L",                                GT1L);
+    LuaEngine::setAttrInt(L, "GT1R",                                GT1R);
+    LuaEngine::setAttrInt(L, "GT2L",                                GT2L);
+    LuaEngine::setAttrInt(L, "GT2R",                                GT2R);
+    LuaEngine::setAttrInt(L, "GT3L",                                GT3L);
+    LuaEngine::setAttrInt(L, "GT3R",                                GT3R);
     LuaEngine::setAttrInt(L, LUA_PARM_ATL08_CLASS_NOISE,            ATL08_NOISE);
     LuaEngine::setAttrInt(L, LUA_PARM_ATL08_CLASS_GROUND,           ATL08_GROUND);
     LuaEngine::setAttrInt(L, LUA_PARM_ATL08_CLASS_CANOPY,           ATL08_CANOPY);
@@ -115,6 +127,7 @@ extern "C" {
 void initicesat2 (void)
 {
     /* Initialize Modules */
+    ReaderPool::init();
     Atl03Reader::init();
     Atl03Indexer::init();
     Atl06Dispatch::init();
@@ -37,11 +37,17 @@
  ******************************************************************************/
 
 #include "lua_parms.h"
+#include "PolygonIndex.h"
 #include "Atl03Reader.h"
+#include "ReaderPool.h"
+#include "GranuleCache.h"
 #include "Atl03Indexer.h"
 #include "Atl06Dispatch.h"
 #include "CumulusIODriver.h"
 #include "GTArray.h"
+#include "GTStream.h"
+#include "SpscQueue.h"
+#include "UT_Atl03Reader.h"
 #include "UT_Atl06Dispatch.h"
 
 /******************************************************************************
@@ -52,6 +52,10 @@
 #define ATL06_DEFAULT_MAX_ROBUST_DISPERSION     5.0 // meters
 #define ATL06_DEFAULT_COMPACT                   false
 #define ATL06_DEFAULT_PASS_INVALID              false
+#define ATL06_DEFAULT_EXTENT_BATCH              1
+#define ATL06_DEFAULT_POLYGON_STRIDE            0 // segments
+#define ATL06_DEFAULT_READ_BUDGET               0 // megabytes
+#define ATL06_DEFAULT_CONSUMER                  CONSUMER_ATL06
 
 /******************************************************************************
  * FILE DATA
@@ -63,16 +67,23 @@ const atl06_parms_t DefaultParms = {
     .pass_invalid               = ATL06_DEFAULT_PASS_INVALID,
     .use_atl08_classification   = ATL06_DEFAULT_USE_ATL08_CLASSIFICATION,
     .atl08_class                = { false, false, false, false, false },
+    .beams                      = { true, true, true, true, true, true },
+    .spots                      = { true, true, true, true, true, true },
     .stages                     = { true },
     .compact                    = ATL06_DEFAULT_COMPACT,
     .points_in_polygon          = 0,
+    .polygon_index              = NULL,
+    .polygon_stride             = ATL06_DEFAULT_POLYGON_STRIDE,
     .max_iterations             = ATL06_DEFAULT_MAX_ITERATIONS,
     .along_track_spread         = ATL06_DEFAULT_ALONG_TRACK_SPREAD,
     .minimum_photon_count       = ATL06_DEFAULT_MIN_PHOTON_COUNT,
     .minimum_window             = ATL06_DEFAULT_MIN_WINDOW,
     .maximum_robust_dispersion  = ATL06_DEFAULT_MAX_ROBUST_DISPERSION,
     .extent_length              = ATL06_DEFAULT_EXTENT_LENGTH,
-    .extent_step                = ATL06_DEFAULT_EXTENT_STEP
+    .extent_step                = ATL06_DEFAULT_EXTENT_STEP,
+    .extent_batch               = ATL06_DEFAULT_EXTENT_BATCH,
+    .read_budget                = ATL06_DEFAULT_READ_BUDGET,
+    .consumer                   = ATL06_DEFAULT_CONSUMER
 };
 
 /******************************************************************************
@@ -164,6 +175,119 @@ static void get_lua_atl08_class (lua_State* L, int index, atl06_parms_t* parms,
     }
 }
 
+static gt_t str2gt (const char* gt_str)
+{
+    if     (StringLib::match(gt_str, "gt1l"))   return GT1L;
+    else if(StringLib::match(gt_str, "gt1r"))   return GT1R;
+    else if(StringLib::match(gt_str, "gt2l"))   return GT2L;
+    else if(StringLib::match(gt_str, "gt2r"))   return GT2R;
+    else if(StringLib::match(gt_str, "gt3l"))   return GT3L;
+    else if(StringLib::match(gt_str, "gt3r"))   return GT3R;
+    else                                        return NUM_GROUND_TRACKS;
+}
+
+static void get_lua_beams (lua_State* L, int index, atl06_parms_t* parms, bool* provided)
+{
+    /* Reset Provided */
+    *provided = false;
+
+    /* Must be table of ground tracks */
+    if(lua_istable(L, index))
+    {
+        /* Clear beams table (sets all to false) */
+        LocalLib::set(parms->beams, 0, sizeof(parms->beams));
+
+        /* Get number of ground tracks in table */
+        int num_beams = lua_rawlen(L, index);
+        if(num_beams > 0 && provided) *provided = true;
+
+        /* Iterate through each ground track in table */
+        for(int i = 0; i < num_beams; i++)
+        {
+            /* Get ground track */
+            lua_rawgeti(L, index, i+1);
+
+            /* Set ground track */
+            int gt = NUM_GROUND_TRACKS;
+            if(lua_isinteger(L, -1))        gt = LuaObject::getLuaInteger(L, -1);
+            else if(lua_isstring(L, -1))    gt = str2gt(LuaObject::getLuaString(L, -1));
+            if(gt >= GT1L && gt <= GT3R && (gt % 10) == 0)
+            {
+                parms->beams[(gt / 10) - 1] = true;
+                mlog(INFO, "Selecting ground track %d", gt);
+            }
+            else
+            {
+                mlog(ERROR, "Invalid ground track: %d", gt);
+            }
+
+            /* Clean up stack */
+            lua_pop(L, 1);
+        }
+    }
+}
+
+static void get_lua_spots (lua_State* L, int index, atl06_parms_t* parms, bool* provided)
+{
+    /* Reset Provided */
+    *provided = false;
+
+    /* Must be table of spots */
+    if(lua_istable(L, index))
+    {
+        /* Clear spots table (sets all to false) */
+        LocalLib::set(parms->spots, 0, sizeof(parms->spots));
+
+        /* Get number of spots in table */
+        int num_spots = lua_rawlen(L, index);
+        if(num_spots > 0 && provided) *provided = true;
+
+        /* Iterate through each spot in table */
+        for(int i = 0; i < num_spots; i++)
+        {
+            /* Get spot */
+            lua_rawgeti(L, index, i+1);
+
+            /* Set spot */
+            if(lua_isinteger(L, -1))
+            {
+                int spot = LuaObject::getLuaInteger(L, -1);
+                if(spot >= SPOT_1 && spot <= SPOT_6)
+                {
+                    parms->spots[spot - 1] = true;
+                    mlog(INFO, "Selecting spot %d", spot);
+                }
+                else
+                {
+                    mlog(ERROR, "Invalid spot: %d", spot);
+                }
+            }
+            else if(lua_isstring(L, -1))
+            {
+                /* Strong Spots are Odd, Weak Spots are Even */
+                const char* spot_str = LuaObject::getLuaString(L, -1);
+                if(StringLib::match(spot_str, LUA_PARM_SPOTS_STRONG))
+                {
+                    parms->spots[SPOT_1 - 1] = parms->spots[SPOT_3 - 1] = parms->spots[SPOT_5 - 1] = true;
+                    mlog(INFO, "Selecting %s spots", LUA_PARM_SPOTS_STRONG);
+                }
+                else if(StringLib::match(spot_str, LUA_PARM_SPOTS_WEAK))
+                {
+                    parms->spots[SPOT_2 - 1] = parms->spots[SPOT_4 - 1] = parms->spots[SPOT_6 - 1] = true;
+                    mlog(INFO, "Selecting %s spots", LUA_PARM_SPOTS_WEAK);
+                }
+                else
+                {
+                    mlog(ERROR, "Invalid spot: %s", spot_str);
+                }
+            }
+
+            /* Clean up stack */
+            lua_pop(L, 1);
+        }
+    }
+}
+
 static void get_lua_polygon (lua_State* L, int index, atl06_parms_t* parms, bool* provided)
 {
     /* Reset Provided */
@@ -262,7 +386,7 @@ static void get_lua_stages (lua_State* L, int index, atl06_parms_t* parms, bool*
 
 atl06_parms_t* getLuaAtl06Parms (lua_State* L, int index)
 {
-    atl06_parms_t* parms = new atl06_parms_t; // freed in ATL03Reader and ATL06Dispatch destructor
+    atl06_parms_t* parms = new atl06_parms_t; // freed by freeAtl06Parms in ATL03Reader and ATL06Dispatch destructor
     *parms = DefaultParms; // initialize with defaults
 
     if(lua_type(L, index) == LUA_TTABLE)
@@ -291,9 +415,23 @@ atl06_parms_t* getLuaAtl06Parms (lua_State* L, int index)
             if(provided) parms->use_atl08_classification = true;
             lua_pop(L, 1);
 
+            lua_getfield(L, index, LUA_PARM_BEAMS);
+            get_lua_beams(L, -1, parms, &provided);
+            lua_pop(L, 1);
+
+            lua_getfield(L, index, LUA_PARM_SPOTS);
+            get_lua_spots(L, -1, parms, &provided);
+            lua_pop(L, 1);
+
             lua_getfield(L, index, LUA_PARM_POLYGON);
             get_lua_polygon(L, -1, parms, &provided);
             if(provided) mlog(INFO, "Setting %s to %d points", LUA_PARM_POLYGON, (int)parms->points_in_polygon);
+            if(parms->points_in_polygon > 0) parms->polygon_index = new PolygonIndex(parms->polygon); // built once, shared by all reader threads
+            lua_pop(L, 1);
+
+            lua_getfield(L, index, LUA_PARM_POLYGON_STRIDE);
+            parms->polygon_stride = LuaObject::getLuaInteger(L, -1, true, parms->polygon_stride, &provided);
+            if(provided) mlog(INFO, "Setting %s to %d", LUA_PARM_POLYGON_STRIDE, parms->polygon_stride);
             lua_pop(L, 1);
 
             lua_getfield(L, index, LUA_PARM_STAGES);
@@ -339,13 +477,34 @@ atl06_parms_t* getLuaAtl06Parms (lua_State* L, int index)
             parms->extent_step = LuaObject::getLuaFloat(L, -1, true, parms->extent_step, &provided);
             if(provided) mlog(INFO, "Setting %s to %lf", LUA_PARM_EXTENT_STEP, parms->extent_step);
             lua_pop(L, 1);
+
+            lua_getfield(L, index, LUA_PARM_EXTENT_BATCH);
+            parms->extent_batch = LuaObject::getLuaInteger(L, -1, true, parms->extent_batch, &provided);
+            if(provided) mlog(INFO, "Setting %s to %d", LUA_PARM_EXTENT_BATCH, parms->extent_batch);
+            lua_pop(L, 1);
+
+            lua_getfield(L, index, LUA_PARM_READ_BUDGET);
+            parms->read_budget = LuaObject::getLuaInteger(L, -1, true, parms->read_budget, &provided);
+            if(provided) mlog(INFO, "Setting %s to %d MB", LUA_PARM_READ_BUDGET, parms->read_budget);
+            lua_pop(L, 1);
+
+            lua_getfield(L, index, LUA_PARM_CONSUMER);
+            parms->consumer = (consumer_t)LuaObject::getLuaInteger(L, -1, true, parms->consumer, &provided);
+            if(provided) mlog(INFO, "Setting %s to %d", LUA_PARM_CONSUMER, (int)parms->consumer);
+            lua_pop(L, 1);
         }
         catch(const RunTimeException& e)
         {
-            delete parms; // free allocated parms since it won't be owned by anything else
+            freeAtl06Parms(parms); // free allocated parms since it won't be owned by anything else
             throw; // rethrow exception
         }
     }
 
     return parms;
 }
+
+void freeAtl06Parms (const atl06_parms_t* parms)
+{
+    delete parms->polygon_index;
+    delete parms;
+}
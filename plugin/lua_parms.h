@@ -39,6 +39,7 @@
 #include <lua.h>
 #include "List.h"
 #include "MathLib.h"
+#include "PolygonIndex.h"
 
 /******************************************************************************
  * DEFINES
@@ -47,7 +48,10 @@
 #define LUA_PARM_SURFACE_TYPE                   "srt"
 #define LUA_PARM_SIGNAL_CONFIDENCE              "cnf"
 #define LUA_PARM_ATL08_CLASS                    "atl08_class"
+#define LUA_PARM_BEAMS                          "beams"
+#define LUA_PARM_SPOTS                          "spots"
 #define LUA_PARM_POLYGON                        "poly"
+#define LUA_PARM_POLYGON_STRIDE                 "poly_stride"
 #define LUA_PARM_STAGES                         "stages"
 #define LUA_PARM_COMPACT                        "compact"
 #define LUA_PARM_LATITUDE                       "lat"
@@ -60,12 +64,17 @@
 #define LUA_PARM_MIN_WINDOW                     "H_min_win"
 #define LUA_PARM_MAX_ROBUST_DISPERSION          "sigma_r_max"
 #define LUA_PARM_PASS_INVALID                   "pass_invalid"
+#define LUA_PARM_EXTENT_BATCH                   "batch"
+#define LUA_PARM_READ_BUDGET                    "read_budget"
+#define LUA_PARM_CONSUMER                       "consumer"
 #define LUA_PARM_STAGE_LSF                      "LSF"
 #define LUA_PARM_ATL08_CLASS_NOISE              "atl08_noise"
 #define LUA_PARM_ATL08_CLASS_GROUND             "atl08_ground"
 #define LUA_PARM_ATL08_CLASS_CANOPY             "atl08_canopy"
 #define LUA_PARM_ATL08_CLASS_TOP_OF_CANOPY      "atl08_top_of_canopy"
 #define LUA_PARM_ATL08_CLASS_UNCLASSIFIED       "atl08_unclassified"
+#define LUA_PARM_SPOTS_STRONG                   "strong"
+#define LUA_PARM_SPOTS_WEAK                     "weak"
 #define LUA_PARM_MAX_COORDS                     16384
 
 /******************************************************************************
@@ -88,7 +97,8 @@ typedef enum {
     GT2L = 30,
     GT2R = 40,
     GT3L = 50,
-    GT3R = 60
+    GT3R = 60,
+    NUM_GROUND_TRACKS = 6
 } gt_t;
 
 /* Spots */
@@ -146,6 +156,12 @@ typedef enum {
     NUM_STAGES = 1
 } atl06_stages_t;
 
+/* Consumers of Extents */
+typedef enum {
+    CONSUMER_ATL06 = 0,     // extents are fit into elevations
+    CONSUMER_ATL03 = 1      // extents are returned as read (atl03s endpoint)
+} consumer_t;
+
 /* Extraction Parameters */
 typedef struct {
     surface_type_t          surface_type;                   // surface reference type (used to select signal confidence column)
@@ -153,10 +169,14 @@ typedef struct {
     bool                    pass_invalid;                   // post extent even if each pair is invalid
     bool                    use_atl08_classification;       // filter photons based on selected atl08 classifications in atl08_class[]
     bool                    atl08_class[NUM_ATL08_CLASSES]; // list of surface classifications to use (leave empty to skip)
+    bool                    beams[NUM_GROUND_TRACKS];       // ground tracks to read, indexed by (gt / 10) - 1
+    bool                    spots[NUM_SPOTS];               // spots to read, indexed by spot - 1
     bool                    stages[NUM_STAGES];             // algorithm iterations
     bool                    compact;                        // return compact (only lat,lon,height,time) elevation information
     List<MathLib::coord_t>  polygon;                        // bounding region
     int                     points_in_polygon;              // number of points in bounding region
+    PolygonIndex*           polygon_index;                  // inclusion tests of bounding region (NULL when no polygon)
+    int                     polygon_stride;                 // segments between coarse samples when bisecting region boundaries (0 tests every segment)
     int                     max_iterations;                 // least squares fit iterations
     double                  along_track_spread;             // meters
     double                  minimum_photon_count;           // PE
@@ -164,6 +184,9 @@ typedef struct {
     double                  maximum_robust_dispersion;      // sigma_r
     double                  extent_length;                  // length of ATL06 extent (meters)
     double                  extent_step;                    // resolution of the ATL06 extent (meters)
+    int                     extent_batch;                   // number of extents posted per atl03rec.batch record (1 posts atl03rec records)
+    int                     read_budget;                    // megabytes of photon data held by reader when streaming (0 reads whole runs); covers the six photon streams only
+    consumer_t              consumer;                       // what the extents read are used for (selects the datasets read)
 } atl06_parms_t;
 
 /******************************************************************************
@@ -171,5 +194,6 @@ typedef struct {
  ******************************************************************************/
 
 atl06_parms_t* getLuaAtl06Parms (lua_State* L, int index);
+void freeAtl06Parms (const atl06_parms_t* parms);
 
 #endif  /* __lua_parms__ */
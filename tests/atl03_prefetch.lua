@@ -0,0 +1,42 @@
+local runner = require("test_executive")
+console = require("console")
+
+asset = core.asset("local", "file", "/data/ATLAS", "empty.index")
+
+-- Unit Test --
+
+print('\n------------------\nTest01: Atl03 Reader Windows Read Ahead with Pool Full\n------------------')
+
+-- with one reader thread the pool runs a single track at a time (the other
+-- tracks wait in the pool), so the windows of the photon streams (sized by
+-- the read budget) can only be read ahead by the urgent workers
+local num_readers = icesat2.readers()
+icesat2.readers(1)
+
+local recq = msg.subscribe("prefetchq")
+local reader = icesat2.atl03(asset, "ATL03_20200304065203_10470605_003_01.h5", "prefetchq", {cnf=4, read_budget=1, stages={}, consumer=icesat2.CONSUMER_ATL03}, icesat2.ALL_TRACKS)
+local num_extents = 0
+local extentrec = recq:recvrecord(30000)
+while extentrec do
+    num_extents = num_extents + 1
+    extentrec = recq:recvrecord(30000)
+end
+recq:destroy()
+
+local stats = reader:stats(false)
+icesat2.readers(num_readers)
+
+runner.check(num_extents > 0, "Failed to read extents")
+runner.check(stats.windows > 0, "Failed to read windows")
+runner.check(stats.waited < stats.windows, string.format("Failed to read windows ahead: waited on %d of %d", stats.waited, stats.windows))
+
+-- records are posted by the poster of the reader while extents are built
+print(string.format("posted %d records: %.2f waiting on average, %d queued when full, posting ran out %d times", stats.queued, stats.occupancy / math.max(stats.queued, 1), stats.stalled, stats.idled))
+runner.check(stats.queued == num_extents, string.format("Failed to queue records for posting: %d of %d", stats.queued, num_extents))
+
+-- Clean Up --
+
+-- Report Results --
+
+runner.report()
+
@@ -0,0 +1,134 @@
+local runner = require("test_executive")
+console = require("console")
+
+asset = core.asset("local", "file", "/data/ATLAS", "empty.index")
+
+-- Read Extents --
+--  returns the number of times each extent was read (keyed by track,
+--  segment ids and photon counts), the number of extents read, and the
+--  statistics of the reader
+
+local function readextents (num_readers, parms)
+    icesat2.readers(num_readers)
+
+    local recq = msg.subscribe("splitq")
+    local reader = icesat2.atl03(asset, "ATL03_20200304065203_10470605_003_01.h5", "splitq", parms or {cnf=4, stages={}, consumer=icesat2.CONSUMER_ATL03}, icesat2.ALL_TRACKS)
+    local extents = {}
+    local num_extents = 0
+
+    local extentrec = recq:recvrecord(30000)
+    while extentrec do
+        local key = string.format("%d:%d:%d:%d:%d", extentrec:getvalue("track"),
+                                  extentrec:getvalue("segment_id[0]"), extentrec:getvalue("segment_id[1]"),
+                                  extentrec:getvalue("count[0]"), extentrec:getvalue("count[1]"))
+        extents[key] = (extents[key] or 0) + 1
+        num_extents = num_extents + 1
+        extentrec = recq:recvrecord(30000)
+    end
+
+    recq:destroy()
+    return extents, num_extents, reader:stats(false)
+end
+
+-- Compare Extents --
+--  returns the number of extents of the first set not read the same number
+--  of times in the second
+
+local function compareextents (extents1, extents2)
+    local mismatches = 0
+    for key,count in pairs(extents1) do
+        if extents2[key] ~= count then
+            print(string.format("Mismatched extent %s: %d vs %s", key, count, tostring(extents2[key])))
+            mismatches = mismatches + 1
+        end
+    end
+    return mismatches
+end
+
+-- Compare Statistics --
+--  returns the number of statistics of the first reader that differ in the
+--  second
+
+local function comparestats (stats1, stats2)
+    local mismatches = 0
+    for _,stat in ipairs({"read", "filtered", "sent", "avoided"}) do
+        if stats1[stat] ~= stats2[stat] then
+            print(string.format("Mismatched statistic %s: %d vs %d", stat, stats1[stat], stats2[stat]))
+            mismatches = mismatches + 1
+        end
+    end
+    return mismatches
+end
+
+-- Index Granule --
+--  returns the index record of the granule; when sidecar is true, the spatial
+--  sidecars of its pair tracks are registered for the readers of the asset
+
+local function indexgranule (sidecar)
+    local indexq = msg.subscribe("splitindexq")
+    local indexer = icesat2.atl03indexer(asset, {"ATL03_20200304065203_10470605_003_01.h5"}, "splitindexq", 1, sidecar)
+    local index = nil
+
+    local indexrec = indexq:recvrecord(30000)
+    while indexrec do
+        if not sidecar then index = indexrec:tabulate() end
+        indexrec = indexq:recvrecord(30000)
+    end
+
+    indexq:destroy()
+    return index
+end
+
+-- Unit Test --
+
+print('\n------------------\nTest01: Atl03 Reader Split vs Unsplit\n------------------')
+
+-- one reader never splits a run; the tracks of the granule have enough
+-- photons to be split into ranges when there are more readers
+local num_readers = icesat2.readers()
+local unsplit, num_unsplit = readextents(1)
+local split, num_split = readextents(8)
+icesat2.readers(num_readers)
+
+runner.check(num_unsplit > 0, "Failed to read extents")
+runner.check(num_split == num_unsplit, string.format("Failed to read same number of extents: %d vs %d", num_split, num_unsplit))
+runner.check(compareextents(unsplit, split) == 0, "Failed to read unsplit extents when split")
+runner.check(compareextents(split, unsplit) == 0, "Failed to read split extents when unsplit")
+
+print('\n------------------\nTest02: Atl03 Reader Scan vs Bisection vs Sidecar\n------------------')
+
+-- a box across the middle third of the granule, spanning every track, is
+-- subset by scanning every segment, by bisecting between sampled segments,
+-- and by the spatial sidecars of the pair tracks; all three must find the
+-- same runs (so the same extents) and count the same statistics (one reader
+-- is used so that runs are not split)
+local index = indexgranule(false)
+runner.check(index, "Failed to index granule")
+if index then
+    local lat0 = index.lat0 + ((index.lat1 - index.lat0) / 3.0)
+    local lat1 = index.lat0 + (2.0 * (index.lat1 - index.lat0) / 3.0)
+    local lon0 = math.min(index.lon0, index.lon1) - 1.0
+    local lon1 = math.max(index.lon0, index.lon1) + 1.0
+    local poly = { {lat=lat0, lon=lon0}, {lat=lat0, lon=lon1}, {lat=lat1, lon=lon1}, {lat=lat1, lon=lon0} }
+
+    local scanned, num_scanned, scan_stats = readextents(1, {cnf=4, poly=poly, stages={}, consumer=icesat2.CONSUMER_ATL03})
+    local bisected, num_bisected, bisect_stats = readextents(1, {cnf=4, poly=poly, poly_stride=64, stages={}, consumer=icesat2.CONSUMER_ATL03})
+    indexgranule(true) -- sidecars are used when registered
+    local indexed, num_indexed, sidecar_stats = readextents(1, {cnf=4, poly=poly, stages={}, consumer=icesat2.CONSUMER_ATL03})
+    icesat2.readers(num_readers)
+
+    runner.check(num_scanned > 0, "Failed to read extents in polygon")
+    runner.check(num_bisected == num_scanned, string.format("Failed to read same number of extents when bisected: %d vs %d", num_bisected, num_scanned))
+    runner.check(num_indexed == num_scanned, string.format("Failed to read same number of extents from sidecars: %d vs %d", num_indexed, num_scanned))
+    runner.check(compareextents(scanned, bisected) == 0 and compareextents(bisected, scanned) == 0, "Failed to read scanned extents when bisected")
+    runner.check(compareextents(scanned, indexed) == 0 and compareextents(indexed, scanned) == 0, "Failed to read scanned extents from sidecars")
+    runner.check(comparestats(scan_stats, bisect_stats) == 0, "Failed to count scanned statistics when bisected")
+    runner.check(comparestats(scan_stats, sidecar_stats) == 0, "Failed to count scanned statistics from sidecars")
+end
+
+-- Clean Up --
+
+-- Report Results --
+
+runner.report()
+
@@ -0,0 +1,32 @@
+local runner = require("test_executive")
+local console = require("console")
+
+-- Setup --
+
+t = icesat2.ut_atl03()
+
+-- Unit Test --
+
+print('\n------------------\nTest01\n------------------')
+runner.check(t:polytest(), "Failed polytest")
+
+print('\n------------------\nTest02\n------------------')
+runner.check(t:queuetest(), "Failed queuetest")
+
+print('\n------------------\nTest03\n------------------')
+local cache_mb = icesat2.cache()
+icesat2.cache(0) -- empty cache
+runner.check(t:cachetest(icesat2.cache(1)), "Failed cachetest")
+icesat2.cache(0)
+icesat2.cache(cache_mb)
+
+print('\n------------------\nTest04\n------------------')
+runner.check(t:extenttest({len=40, res=20, cnf=2, atl08_class={"atl08_ground", "atl08_canopy", "atl08_unclassified"}}), "Failed extenttest")
+runner.check(t:extenttest({len=40, res=5, cnf=2, atl08_class={"atl08_ground", "atl08_canopy", "atl08_unclassified"}}), "Failed extenttest")
+
+-- Clean Up --
+
+-- Report Results --
+
+runner.report()
+
@@ -42,6 +42,9 @@ print('\n------------------\nTest03: Atl03 Extent Definition\n------------------
 def = msg.definition("atl03rec")
 print("atl03rec", json.encode(def))
 
+def = msg.definition("atl03rec.batch")
+print("atl03rec.batch", json.encode(def))
+
 -- Clean Up --
 
 -- Report Results --
@@ -13,6 +13,15 @@ runner.check(t:lsftest(), "Failed lsftest")
 print('\n------------------\nTest02\n------------------')
 runner.check(t:sorttest(), "Failed sorttest")
 
+print('\n------------------\nTest03\n------------------')
+runner.check(t:rdetest(), "Failed rdetest")
+
+print('\n------------------\nTest04\n------------------')
+runner.check(t:kerneltest(), "Failed kerneltest")
+
+print('\n------------------\nTest05\n------------------')
+runner.check(t:fittest(), "Failed fittest")
+
 -- Clean Up --
 
 -- Report Results --